@@ -0,0 +1,242 @@
+#include <stdlib.h>
+#include "bench.h"
+
+#ifndef BENCH_MIN_SAMPLE_NANOSECONDS
+#define BENCH_MIN_SAMPLE_NANOSECONDS 1000000ull
+#endif
+
+#define BENCH_MAX_REPETITIONS 1024
+
+static struct {
+    const char* filter;
+    const char* suite;
+    uint32_t warmup_samples;
+    uint32_t repetitions;
+    bench_output output;
+    uint32_t records_printed;
+} bench_settings = {
+    .filter = NULL,
+    .suite = "engine",
+    .warmup_samples = 3,
+    .repetitions = 15,
+    .output = BENCH_OUTPUT_TABLE,
+    .records_printed = 0,
+};
+
+static atomic_uint32 bench_failure_count;
+
+#if !(defined(__GNUC__) || defined(__clang__))
+volatile const void* bench_sink;
+#endif
+
+bench_output get_bench_output(void) {
+    return bench_settings.output;
+}
+
+void record_bench_failure(void) {
+    atomic_fetch_add_uint32(&bench_failure_count, 1, MEMORY_ORDER_RELAXED);
+}
+
+uint32_t get_bench_failure_count(void) {
+    return atomic_load_uint32(&bench_failure_count, MEMORY_ORDER_ACQUIRE);
+}
+
+void begin_bench_record(void) {
+    if (bench_settings.output == BENCH_OUTPUT_JSON) {
+        printf(bench_settings.records_printed == 0 ? "\n  " : ",\n  ");
+    }
+    ++bench_settings.records_printed;
+}
+
+static uint64_t time_sample(bench_function function, void* context, uint64_t iterations) {
+    uint64_t start = read_timestamp();
+    function(context, iterations);
+    return timestamp_to_nanoseconds(read_timestamp() - start);
+}
+
+static int compare_doubles(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest-rank percentile of an ascending sorted array.
+static double percentile(const double* sorted, uint32_t count, double fraction) {
+    uint32_t rank = (uint32_t)(fraction * (double)count + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    if (rank > count) {
+        rank = count;
+    }
+    return sorted[rank - 1];
+}
+
+void run_bench(const char* name, bench_function function, void* context, uint64_t bytes_per_operation) {
+    ASSERT(name != NULL, return, "Benchmark name cannot be NULL");
+    ASSERT(function != NULL, return, "Benchmark function cannot be NULL");
+
+    if (bench_settings.filter != NULL && strstr(name, bench_settings.filter) == NULL) {
+        return;
+    }
+
+    // Calibrate: double the iterations until one sample is long enough to be measured accurately.
+    // The first call is not counted, so one-off costs (like page faults on first use) do not end the calibration early.
+    time_sample(function, context, 1);
+    uint64_t iterations = 1;
+    while (time_sample(function, context, iterations) < BENCH_MIN_SAMPLE_NANOSECONDS && iterations < (1ull << 40)) {
+        iterations *= 2;
+    }
+
+    for (uint32_t i = 0; i < bench_settings.warmup_samples; ++i) {
+        time_sample(function, context, iterations);
+    }
+
+    double nanoseconds_per_operation[BENCH_MAX_REPETITIONS];
+    uint32_t repetitions = bench_settings.repetitions;
+    for (uint32_t i = 0; i < repetitions; ++i) {
+        nanoseconds_per_operation[i] = (double)time_sample(function, context, iterations) / (double)iterations;
+    }
+    qsort(nanoseconds_per_operation, repetitions, sizeof(double), compare_doubles);
+
+    double p50 = percentile(nanoseconds_per_operation, repetitions, 0.50);
+    double p90 = percentile(nanoseconds_per_operation, repetitions, 0.90);
+    double p99 = percentile(nanoseconds_per_operation, repetitions, 0.99);
+    double minimum = nanoseconds_per_operation[0];
+    double throughput = bytes_per_operation > 0 ?
+        ((double)bytes_per_operation / p50) * 1000.0 : // bytes per nanosecond -> MB/s
+        1000.0 / p50;                                   // operations per nanosecond -> Mops/s
+
+    begin_bench_record();
+    if (bench_settings.output == BENCH_OUTPUT_JSON) {
+        printf("{\"name\": \"%s\", \"iterations_per_sample\": %llu, \"min_ns_per_op\": %.3f, \"p50_ns_per_op\": %.3f, \"p90_ns_per_op\": %.3f, \"p99_ns_per_op\": %.3f, \"throughput\": %.3f, \"throughput_unit\": \"%s\"}",
+            name, (unsigned long long)iterations, minimum, p50, p90, p99, throughput, bytes_per_operation > 0 ? "MB/s" : "Mops/s");
+    }
+    else if (bench_settings.output == BENCH_OUTPUT_CSV) {
+        printf("%s,%llu,%.3f,%.3f,%.3f,%.3f,%.3f,%s\n", name, (unsigned long long)iterations, minimum, p50, p90, p99, throughput, bytes_per_operation > 0 ? "MB/s" : "Mops/s");
+    }
+    else {
+        printf("%-48s %12.3f %12.3f %12.3f %12.3f %12.3f %s\n", name, minimum, p50, p90, p99, throughput, bytes_per_operation > 0 ? "MB/s" : "Mops/s");
+    }
+    fflush(stdout);
+}
+
+static void print_usage(void) {
+    printf("usage: bench [--suite engine|simulation|pacing] [--csv | --json]\n"
+        "  engine:     [--filter <substring>] [--warmup <samples>] [--repetitions <samples>]\n"
+        "  simulation: [--asteroids <count>] [--projectiles <count>] [--players <count>] [--ticks <count>] [--seed <seed>] [--threads <count>]\n"
+        "  pacing:     [--rate <frames per second>] [--frames <count>] [--work <milliseconds>]\n");
+}
+
+int main(int argc, char** argv) {
+    simulation_bench_settings simulation_settings = {
+        .asteroid_count = 0,
+        .projectile_count = 0,
+        .player_count = 1,
+        .ticks = 60,
+        .seed = 1,
+        .thread_count = 1,
+    };
+
+    pacing_bench_settings pacing_settings = {
+        .frame_rate = 0,
+        .frames = 120,
+        .work_milliseconds = 2.0,
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            bench_settings.filter = argv[++i];
+        }
+        else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            bench_settings.warmup_samples = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+            bench_settings.repetitions = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--suite") == 0 && i + 1 < argc) {
+            bench_settings.suite = argv[++i];
+        }
+        else if (strcmp(argv[i], "--csv") == 0) {
+            bench_settings.output = BENCH_OUTPUT_CSV;
+        }
+        else if (strcmp(argv[i], "--json") == 0) {
+            bench_settings.output = BENCH_OUTPUT_JSON;
+        }
+        else if (strcmp(argv[i], "--asteroids") == 0 && i + 1 < argc) {
+            simulation_settings.asteroid_count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--projectiles") == 0 && i + 1 < argc) {
+            simulation_settings.projectile_count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--players") == 0 && i + 1 < argc) {
+            simulation_settings.player_count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) {
+            simulation_settings.ticks = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            simulation_settings.seed = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            simulation_settings.thread_count = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            pacing_settings.frame_rate = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+            pacing_settings.frames = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--work") == 0 && i + 1 < argc) {
+            pacing_settings.work_milliseconds = strtod(argv[++i], NULL);
+        }
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (bench_settings.repetitions == 0 || bench_settings.repetitions > BENCH_MAX_REPETITIONS) {
+        printf("repetitions must be between 1 and %u\n", BENCH_MAX_REPETITIONS);
+        return 1;
+    }
+
+    bool is_engine_suite = strcmp(bench_settings.suite, "engine") == 0;
+    bool is_simulation_suite = strcmp(bench_settings.suite, "simulation") == 0;
+    bool is_pacing_suite = strcmp(bench_settings.suite, "pacing") == 0;
+    if (!is_engine_suite && !is_simulation_suite && !is_pacing_suite) {
+        print_usage();
+        return 1;
+    }
+
+    if (bench_settings.output == BENCH_OUTPUT_JSON) {
+        printf("[");
+    }
+
+    if (is_engine_suite) {
+        if (bench_settings.output == BENCH_OUTPUT_CSV) {
+            printf("name,iterations_per_sample,min_ns_per_op,p50_ns_per_op,p90_ns_per_op,p99_ns_per_op,throughput,throughput_unit\n");
+        }
+        else if (bench_settings.output == BENCH_OUTPUT_TABLE) {
+            printf("%-48s %12s %12s %12s %12s %12s\n", "benchmark (ns/op)", "min", "p50", "p90", "p99", "throughput");
+        }
+        run_engine_benches();
+    }
+    else if (is_simulation_suite) {
+        run_simulation_benches(&simulation_settings);
+    }
+    else {
+        run_pacing_benches(&pacing_settings);
+    }
+
+    if (bench_settings.output == BENCH_OUTPUT_JSON) {
+        printf("\n]\n");
+    }
+
+    uint32_t failure_count = get_bench_failure_count();
+    if (failure_count > 0) {
+        fprintf(stderr, "%u sanity check%s failed\n", failure_count, failure_count == 1 ? "" : "s");
+        return 1;
+    }
+    return 0;
+}
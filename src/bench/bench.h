@@ -0,0 +1,66 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+A small microbenchmark harness. Every benchmark is a function that performs `iterations` operations.
+The harness calibrates the number of iterations so a sample takes a measurable amount of time, runs warmup samples,
+and then reports percentiles of the nanoseconds per operation over the measured samples (plus throughput).
+*/
+
+#include "platform_layer.h"
+
+typedef void (*bench_function)(void* context, uint64_t iterations);
+
+typedef enum {
+    BENCH_OUTPUT_TABLE,
+    BENCH_OUTPUT_CSV,
+    BENCH_OUTPUT_JSON,
+} bench_output;
+
+bench_output get_bench_output(void);
+
+// Separates JSON records, call this before printing each record.
+void begin_bench_record(void);
+
+// bytes_per_operation is used to report throughput in MB/s, pass 0 to report operations per second instead.
+void run_bench(const char* name, bench_function function, void* context, uint64_t bytes_per_operation);
+
+// Sanity checks that fail are counted (from any thread), and bench exits with a failure status if any did.
+void record_bench_failure(void);
+uint32_t get_bench_failure_count(void);
+
+// An ASSERT that also counts as a failed sanity check.
+#define BENCH_CHECK(condition, fallback, ...) ASSERT(condition, record_bench_failure(); fallback, __VA_ARGS__)
+
+// Prevents the compiler from optimizing away a benchmarked computation whose result is otherwise unused.
+#if defined(__GNUC__) || defined(__clang__)
+#define BENCH_DO_NOT_OPTIMIZE(value) __asm__ volatile("" : : "g"(&(value)) : "memory")
+#else
+extern volatile const void* bench_sink;
+#define BENCH_DO_NOT_OPTIMIZE(value) (bench_sink = (const void*)&(value))
+#endif
+
+void run_engine_benches(void);
+
+// A count of 0 means "sweep a default range of counts" for asteroids and projectiles.
+typedef struct {
+    uint32_t asteroid_count;
+    uint32_t projectile_count;
+    uint32_t player_count;
+    uint32_t ticks;
+    uint32_t seed;
+    uint32_t thread_count; // 1 runs every phase on the calling thread, 0 uses one thread per processor
+} simulation_bench_settings;
+
+void run_simulation_benches(const simulation_bench_settings* settings);
+
+// A frame rate of 0 means "sweep a default range of frame rates".
+typedef struct {
+    uint32_t frame_rate;
+    uint32_t frames;
+    double work_milliseconds; // busy work done every frame before waiting
+} pacing_bench_settings;
+
+void run_pacing_benches(const pacing_bench_settings* settings);
+
+#endif // BENCH_H
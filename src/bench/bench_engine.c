@@ -0,0 +1,2549 @@
+#include "bench.h"
+#include "platform_layer.h"
+#include "headless_platform_layer.h"
+#include "asset_files.h"
+#include "profiler.h"
+#include "frame_statistics.h"
+#include "job_system.h"
+#include "pool_allocator.h"
+#include "tlsf_allocator.h"
+#include "dynamic_array.h"
+#include "hash_map.h"
+#include "slot_map.h"
+#include "soa.h"
+#include "concurrent_queue.h"
+#include "bitset.h"
+#include <stdlib.h>
+
+/*
+Benchmarks for the engine's core primitives: bump allocation, capped arrays, geometry, strings, WAV parsing and sprite instance generation.
+*/
+
+#define BENCH_ARENA_RESET_BYTES (32 * 1024 * 1024)
+
+/*
+=============================================================================================================================
+    Memory Allocation
+=============================================================================================================================
+*/
+
+typedef struct {
+    bump_allocator* arena;
+    size_t alignment;
+    size_t bytes;
+} bump_allocate_bench;
+
+static void bench_bump_allocate(void* context, uint64_t iterations) {
+    bump_allocate_bench* bench = (bump_allocate_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (bench->arena->used_bytes + bench->bytes + bench->alignment > BENCH_ARENA_RESET_BYTES) {
+            reset_bump_allocator(bench->arena);
+        }
+        void* allocation = bump_allocate(bench->arena, bench->alignment, bench->bytes);
+        BENCH_DO_NOT_OPTIMIZE(allocation);
+    }
+}
+
+// A scratch allocation that is freed as soon as it is used, instead of at the next reset.
+static void bench_scoped_allocate(void* context, uint64_t iterations) {
+    bump_allocate_bench* bench = (bump_allocate_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        arena_scope scope = arena_scope_begin(bench->arena);
+        void* allocation = bump_allocate(bench->arena, bench->alignment, bench->bytes);
+        BENCH_DO_NOT_OPTIMIZE(allocation);
+        arena_scope_end(scope);
+    }
+}
+
+#define BENCH_ARENA_GROWTH_BYTES (32 * 1024 * 1024)
+
+// Grows a fresh arena to BENCH_ARENA_GROWTH_BYTES and writes to every page, so the commits and page faults are what is measured.
+static void bench_arena_growth(void* context, uint64_t iterations) {
+    const bump_allocator_options* options = (const bump_allocator_options*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bump_allocator growing;
+        if (create_bump_allocator_with_options(&growing, BENCH_ARENA_GROWTH_BYTES, options) != RESULT_SUCCESS) {
+            return;
+        }
+        for (size_t offset = 0; offset < BENCH_ARENA_GROWTH_BYTES; offset += 64 * 1024) {
+            uint8_t* chunk = (uint8_t*)bump_allocate(&growing, 64, 64 * 1024);
+            for (size_t page = 0; page < 64 * 1024; page += 4096) {
+                chunk[page] = (uint8_t)page;
+            }
+        }
+        destroy_bump_allocator(&growing);
+    }
+}
+
+static void check_arena_commits(void) {
+    // Sanity check: commits grow geometrically, per-page commits do not, resetting gives back memory above the limit
+    // (and the arena still works afterwards), and a huge page arena is aligned to huge pages.
+    bump_allocator arena;
+    if (create_bump_allocator(&arena, BENCH_ARENA_GROWTH_BYTES) != RESULT_SUCCESS) {
+        return;
+    }
+    bump_allocate(&arena, 1, 1);
+    BENCH_CHECK(arena.next_page_bytes == BUMP_ALLOCATOR_MIN_COMMIT_BYTES, , "First commit is %zu bytes, expected %d", arena.next_page_bytes, BUMP_ALLOCATOR_MIN_COMMIT_BYTES);
+    for (uint32_t i = 0; i < 1024; ++i) {
+        bump_allocate(&arena, 1, 4096);
+    }
+    BENCH_CHECK(arena.commit_count <= 8, , "Growing to 4 MB took %u commits", arena.commit_count);
+    destroy_bump_allocator(&arena);
+
+    bump_allocator_options page_options = { .min_commit_bytes = 4096, .max_commit_bytes = 4096 };
+    if (create_bump_allocator_with_options(&arena, BENCH_ARENA_GROWTH_BYTES, &page_options) != RESULT_SUCCESS) {
+        return;
+    }
+    for (uint32_t i = 0; i < 256; ++i) {
+        bump_allocate(&arena, 1, 4096);
+    }
+    BENCH_CHECK(arena.commit_count == 256, , "Per-page commits grew to 1 MB in %u commits, expected 256", arena.commit_count);
+    destroy_bump_allocator(&arena);
+
+    bump_allocator_options decommit_options = { .decommit_above_bytes = 256 * 1024 };
+    if (create_bump_allocator_with_options(&arena, BENCH_ARENA_GROWTH_BYTES, &decommit_options) != RESULT_SUCCESS) {
+        return;
+    }
+    memset(bump_allocate(&arena, 64, 4 * 1024 * 1024), 1, 4 * 1024 * 1024);
+    reset_bump_allocator(&arena);
+    BENCH_CHECK(arena.next_page_bytes <= 256 * 1024, , "Reset kept %zu bytes committed, expected at most 256 KB", arena.next_page_bytes);
+    uint8_t* reused = (uint8_t*)bump_allocate(&arena, 64, 1024 * 1024);
+    memset(reused, 2, 1024 * 1024);
+    BENCH_CHECK(reused[1024 * 1024 - 1] == 2, , "Arena memory is not writable after decommitting");
+    destroy_bump_allocator(&arena);
+
+    bump_allocator_options huge_options = { .use_huge_pages = true };
+    if (create_bump_allocator_with_options(&arena, BENCH_ARENA_GROWTH_BYTES, &huge_options) != RESULT_SUCCESS) {
+        return;
+    }
+    memset(bump_allocate(&arena, 64, 4 * 1024 * 1024), 3, 4 * 1024 * 1024);
+    BENCH_CHECK(((uintptr_t)arena.base % BUMP_ALLOCATOR_HUGE_PAGE_SIZE) == 0, , "Huge page arena is not aligned to huge pages");
+    destroy_bump_allocator(&arena);
+}
+
+static void check_frame_arenas(void) {
+    // Sanity check: data allocated in a frame arena survives the next FRAME_ARENA_COUNT - 1 frames, and its arena is reset after that.
+    memory_allocators allocators = { 0 };
+    if (create_frame_arenas(&allocators, 1024 * 1024, NULL) != RESULT_SUCCESS) {
+        return;
+    }
+    uint32_t* snapshot = (uint32_t*)bump_allocate(get_frame_arena(&allocators), alignof(uint32_t), sizeof(uint32_t) * 256);
+    for (uint32_t i = 0; i < 256; ++i) {
+        snapshot[i] = i;
+    }
+    bump_allocator* snapshot_arena = get_frame_arena(&allocators);
+
+    for (uint32_t frame = 1; frame < FRAME_ARENA_COUNT; ++frame) {
+        advance_frame_arenas(&allocators);
+        bump_allocate(get_frame_arena(&allocators), 64, 4096);
+        BENCH_CHECK(get_past_frame_arena(&allocators, frame) == snapshot_arena && snapshot_arena->used_bytes == sizeof(uint32_t) * 256
+            && snapshot[255] == 255, , "Frame arena data did not survive %u frame(s)", frame);
+    }
+    advance_frame_arenas(&allocators);
+    BENCH_CHECK(get_frame_arena(&allocators) == snapshot_arena && snapshot_arena->used_bytes == 0, ,
+        "Frame arena was not reset after %d frames", FRAME_ARENA_COUNT);
+    destroy_frame_arenas(&allocators);
+}
+
+typedef struct snapshot_node {
+    struct snapshot_node* next;
+    uint32_t value;
+} snapshot_node;
+
+#define BENCH_SNAPSHOT_BYTES (16 * 1024 * 1024)
+#define BENCH_SNAPSHOT_VERSION 1
+
+typedef struct {
+    bump_allocator* arena;
+    size_t region;
+    string path;
+} arena_snapshot_bench;
+
+// Touches every page after loading, so the pages being read in on first use are counted too.
+static void bench_load_arena_snapshot(void* context, uint64_t iterations) {
+    arena_snapshot_bench* bench = (arena_snapshot_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        void* root = NULL;
+        load_arena_snapshot(bench->arena, bench->region, BENCH_SNAPSHOT_VERSION, bench->path, &root);
+        const uint8_t* region = (const uint8_t*)bench->arena->base + bench->region;
+        uint32_t sum = 0;
+        for (size_t offset = 0; offset < bench->arena->used_bytes - bench->region; offset += 4096) {
+            sum += region[offset];
+        }
+        BENCH_DO_NOT_OPTIMIZE(sum);
+        BENCH_DO_NOT_OPTIMIZE(root);
+    }
+}
+
+// Reading the same bytes into the arena, which is what loading costs without mapping.
+static void bench_read_arena_snapshot(void* context, uint64_t iterations) {
+    arena_snapshot_bench* bench = (arena_snapshot_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bench->arena->used_bytes = bench->region;
+        string contents;
+        result read_result = read_entire_file(bench->path, bench->arena, &contents);
+        BENCH_DO_NOT_OPTIMIZE(read_result);
+    }
+}
+
+static void run_arena_snapshot_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    string path = concat(get_executable_directory(arena), (string)CSTR("bench_arena_snapshot.bin"), arena);
+
+    bump_allocator snapshot_arena;
+    bump_allocator_options options = { .preferred_base = (void*)0x200000000000ull };
+    if (create_bump_allocator_with_options(&snapshot_arena, 64 * 1024 * 1024, &options) != RESULT_SUCCESS) {
+        return;
+    }
+
+    BENCH_CHECK(snapshot_arena.base == options.preferred_base, , "Arena was reserved at %p instead of its preferred base %p", snapshot_arena.base, options.preferred_base);
+
+    // Sanity check: a linked list saved from the snapshot region comes back with its pointers and values after being overwritten,
+    // what was allocated before the region is left alone, and the arena carries on allocating after what was loaded.
+    uint32_t* engine_data = (uint32_t*)bump_allocate(&snapshot_arena, alignof(uint32_t), sizeof(uint32_t));
+    *engine_data = 7;
+    size_t region = begin_arena_snapshot_region(&snapshot_arena);
+    snapshot_node* list = NULL;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        snapshot_node* node = (snapshot_node*)bump_allocate(&snapshot_arena, alignof(snapshot_node), sizeof(snapshot_node));
+        node->next = list;
+        node->value = i;
+        list = node;
+    }
+    uint8_t* padding = (uint8_t*)bump_allocate(&snapshot_arena, 64, BENCH_SNAPSHOT_BYTES);
+    memset(padding, 1, BENCH_SNAPSHOT_BYTES);
+    size_t saved_used_bytes = snapshot_arena.used_bytes;
+
+    if (save_arena_snapshot(&snapshot_arena, region, list, BENCH_SNAPSHOT_VERSION, path) == RESULT_SUCCESS) {
+        memset((uint8_t*)snapshot_arena.base + region, 0xCD, saved_used_bytes - region);
+        snapshot_arena.used_bytes = region;
+        bump_allocate(&snapshot_arena, 1, 12345);
+
+        void* root = NULL;
+        result load_result = load_arena_snapshot(&snapshot_arena, region, BENCH_SNAPSHOT_VERSION, path, &root);
+        uint32_t expected = 1000;
+        for (snapshot_node* node = (snapshot_node*)root; load_result == RESULT_SUCCESS && node != NULL; node = node->next) {
+            BENCH_CHECK(node->value == --expected, break, "Snapshot node has value %u, expected %u", node->value, expected);
+        }
+        BENCH_CHECK(load_result == RESULT_SUCCESS && root == list && expected == 0 && *engine_data == 7 && snapshot_arena.used_bytes == saved_used_bytes, ,
+            "Loaded arena snapshot does not match what was saved");
+        uint8_t* after = (uint8_t*)bump_allocate(&snapshot_arena, 1, 4096);
+        memset(after, 2, 4096);
+        BENCH_CHECK(padding[BENCH_SNAPSHOT_BYTES - 1] == 1 && after[4095] == 2, , "Arena is not usable after loading a snapshot");
+
+        // Sanity check: saving over the file the region was just loaded from (a quick save after a quick load) keeps both intact.
+        list->value = 5000;
+        BENCH_CHECK(save_arena_snapshot(&snapshot_arena, region, list, BENCH_SNAPSHOT_VERSION, path) == RESULT_SUCCESS
+            && padding[0] == 1 && padding[BENCH_SNAPSHOT_BYTES - 1] == 1
+            && load_arena_snapshot(&snapshot_arena, region, BENCH_SNAPSHOT_VERSION, path, &root) == RESULT_SUCCESS && ((snapshot_node*)root)->value == 5000
+            && ((snapshot_node*)root)->next->value == 998 && after[4095] == 2, , "Arena snapshot saved over its mapped file did not load back");
+
+        arena_snapshot_bench bench = { .arena = &snapshot_arena, .region = region, .path = path };
+        run_bench("arena_snapshot/load_16MB", bench_load_arena_snapshot, &bench, saved_used_bytes - region);
+        run_bench("arena_snapshot/read_file_16MB", bench_read_arena_snapshot, &bench, saved_used_bytes - region);
+        remove(path.text);
+    }
+
+    destroy_bump_allocator(&snapshot_arena);
+    reset_bump_allocator(arena);
+}
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+static void bench_tagged_allocate(void* context, uint64_t iterations) {
+    bump_allocate_bench* bench = (bump_allocate_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (bench->arena->used_bytes + bench->bytes + bench->alignment > BENCH_ARENA_RESET_BYTES) {
+            reset_bump_allocator(bench->arena);
+        }
+        void* allocation = BUMP_ALLOCATE_TAGGED(bench->arena, bench->alignment, bench->bytes, "bench");
+        BENCH_DO_NOT_OPTIMIZE(allocation);
+    }
+}
+
+static void check_memory_accounting(void) {
+    // Sanity check: tags split the usage, a reset keeps the frame's high-water mark and each tag's peak, and the next frame starts from zero.
+    bump_allocator arena;
+    if (create_bump_allocator(&arena, 1024 * 1024) != RESULT_SUCCESS) {
+        return;
+    }
+    BUMP_ALLOCATE_TAGGED(&arena, 1, 1000, "sprites");
+    BUMP_ALLOCATE_TAGGED(&arena, 1, 500, "sprites");
+    BUMP_ALLOCATE_TAGGED(&arena, 1, 200, MEMORY_TAG_HERE);
+    bump_allocate(&arena, 1, 300);
+    reset_bump_allocator(&arena);
+    BUMP_ALLOCATE_TAGGED(&arena, 1, 100, "sprites");
+
+    const bump_allocator_accounting* accounting = &arena.accounting;
+    BENCH_CHECK(accounting->tag_count == 3 && accounting->previous_high_water_bytes == 2000 && accounting->high_water_bytes == 100, ,
+        "Memory accounting found %u tags and high-water marks of %zu and %zu, expected 3, 2000 and 100",
+        accounting->tag_count, accounting->previous_high_water_bytes, accounting->high_water_bytes);
+    BENCH_CHECK(strcmp(accounting->tags[0].name, "sprites") == 0 && accounting->tags[0].bytes == 100 && accounting->tags[0].peak_bytes == 1500
+        && accounting->tags[0].allocation_count == 3, , "Tag %s has %zu bytes (peak %zu), expected 100 (peak 1500)",
+        accounting->tags[0].name, accounting->tags[0].bytes, accounting->tags[0].peak_bytes);
+    destroy_bump_allocator(&arena);
+}
+#endif
+
+static void run_bump_allocator_benches(bump_allocator* arena) {
+    check_arena_commits();
+    check_frame_arenas();
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    check_memory_accounting();
+#endif
+
+    // Sanity check: nested scopes rewind to where each one began, and ARENA_SCOPE ends its scope when the block is left with break.
+    reset_bump_allocator(arena);
+    bump_allocate(arena, 1, 100);
+    arena_scope outer = arena_scope_begin(arena);
+    bump_allocate(arena, 16, 1000);
+    size_t inner_start = arena->used_bytes;
+    ARENA_SCOPE(arena) {
+        bump_allocate(arena, 64, 5000);
+        if (arena->used_bytes > inner_start) {
+            break;
+        }
+        bump_allocate(arena, 1, 1);
+    }
+    BENCH_CHECK(arena->used_bytes == inner_start && arena->scope_depth == 1, , "Inner arena scope did not rewind (%zu used, expected %zu)", arena->used_bytes, inner_start);
+    arena_scope_end(outer);
+    BENCH_CHECK(arena->used_bytes == 100 && arena->scope_depth == 0, , "Outer arena scope did not rewind (%zu used, expected 100)", arena->used_bytes);
+
+    const size_t alignments[] = { 1, 16, 64 };
+    const size_t sizes[] = { 16, 256, 4096 };
+    for (uint32_t a = 0; a < ARRAY_LENGTH(alignments); ++a) {
+        for (uint32_t s = 0; s < ARRAY_LENGTH(sizes); ++s) {
+            bump_allocate_bench bench = { .arena = arena, .alignment = alignments[a], .bytes = sizes[s] };
+            char name[64];
+            snprintf(name, sizeof(name), "bump_allocate/align_%zu/bytes_%zu", alignments[a], sizes[s]);
+            reset_bump_allocator(arena);
+            run_bench(name, bench_bump_allocate, &bench, sizes[s]);
+        }
+    }
+
+    bump_allocator_options page_commits = { .min_commit_bytes = 4096, .max_commit_bytes = 4096 };
+    bump_allocator_options geometric_commits = { 0 };
+    bump_allocator_options huge_pages = { .use_huge_pages = true };
+    run_bench("bump_allocate/grow_32MB/page_commits", bench_arena_growth, &page_commits, BENCH_ARENA_GROWTH_BYTES);
+    run_bench("bump_allocate/grow_32MB/geometric_commits", bench_arena_growth, &geometric_commits, BENCH_ARENA_GROWTH_BYTES);
+    run_bench("bump_allocate/grow_32MB/huge_pages", bench_arena_growth, &huge_pages, BENCH_ARENA_GROWTH_BYTES);
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    bump_allocate_bench tagged = { .arena = arena, .alignment = 16, .bytes = 256 };
+    reset_bump_allocator(arena);
+    run_bench("bump_allocate/tagged/align_16/bytes_256", bench_tagged_allocate, &tagged, tagged.bytes);
+#endif
+
+    bump_allocate_bench scoped = { .arena = arena, .alignment = 16, .bytes = 4096 };
+    reset_bump_allocator(arena);
+    run_bench("bump_allocate/scoped/align_16/bytes_4096", bench_scoped_allocate, &scoped, scoped.bytes);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Pool Allocator
+=============================================================================================================================
+*/
+
+#define BENCH_POOL_BLOCKS 4096
+#define BENCH_POOL_LIVE_BLOCKS 1024
+#define BENCH_POOL_THREADS 4
+#define BENCH_POOL_THREAD_ROUNDS 2000
+
+typedef struct {
+    float position[2];
+    float velocity[2];
+    float lifetime;
+    uint32_t owner;
+} bench_particle;
+
+typedef struct {
+    pool_allocator pool;
+    pool_cache cache;
+    void* live[BENCH_POOL_LIVE_BLOCKS];
+    uint32_t random_state;
+    atomic_uint32 corrupted_blocks;
+} pool_bench;
+
+typedef struct {
+    pool_bench* bench;
+    uint32_t owner;
+} pool_bench_thread;
+
+static void bench_pool_allocate_free(void* context, uint64_t iterations) {
+    pool_bench* bench = (pool_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        void* block = pool_allocate(&bench->pool);
+        BENCH_DO_NOT_OPTIMIZE(block);
+        pool_free(&bench->pool, block);
+    }
+}
+
+static void bench_pool_cache_allocate_free(void* context, uint64_t iterations) {
+    pool_bench* bench = (pool_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        void* block = pool_cache_allocate(&bench->pool, &bench->cache);
+        BENCH_DO_NOT_OPTIMIZE(block);
+        pool_cache_free(&bench->pool, &bench->cache, block);
+    }
+}
+
+// Replaces a random live block every iteration, like particles expiring and spawning.
+static void bench_pool_churn(void* context, uint64_t iterations) {
+    pool_bench* bench = (pool_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bench->random_state ^= bench->random_state << 13;
+        bench->random_state ^= bench->random_state >> 17;
+        bench->random_state ^= bench->random_state << 5;
+        uint32_t slot = bench->random_state % BENCH_POOL_LIVE_BLOCKS;
+        pool_cache_free(&bench->pool, &bench->cache, bench->live[slot]);
+        bench->live[slot] = pool_cache_allocate(&bench->pool, &bench->cache);
+        BENCH_DO_NOT_OPTIMIZE(bench->live[slot]);
+    }
+}
+
+// Allocates a batch, stamps it with the thread's id, checks nobody else was handed the same blocks, and frees them again.
+static unsigned long churn_pool_on_thread(void* arg) {
+    pool_bench_thread* thread_bench = (pool_bench_thread*)arg;
+    pool_bench* bench = thread_bench->bench;
+    pool_cache cache = { 0 };
+    bench_particle* particles[16];
+    for (uint32_t round = 0; round < BENCH_POOL_THREAD_ROUNDS; ++round) {
+        for (uint32_t i = 0; i < ARRAY_LENGTH(particles); ++i) {
+            particles[i] = (bench_particle*)(round & 1 ? pool_cache_allocate(&bench->pool, &cache) : pool_allocate(&bench->pool));
+            if (particles[i] != NULL) {
+                particles[i]->owner = thread_bench->owner;
+            }
+        }
+        for (uint32_t i = 0; i < ARRAY_LENGTH(particles); ++i) {
+            if (particles[i] == NULL) {
+                continue;
+            }
+            if (particles[i]->owner != thread_bench->owner) {
+                atomic_fetch_add_uint32(&bench->corrupted_blocks, 1, MEMORY_ORDER_RELAXED);
+            }
+            if (round & 1) {
+                pool_cache_free(&bench->pool, &cache, particles[i]);
+            }
+            else {
+                pool_free(&bench->pool, particles[i]);
+            }
+        }
+    }
+    flush_pool_cache(&bench->pool, &cache);
+    return 0;
+}
+
+static void run_pool_allocator_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    pool_bench* bench = (pool_bench*)bump_allocate(arena, alignof(pool_bench), sizeof(pool_bench));
+    if (bench == NULL) {
+        BUG("Failed to allocate pool benchmark data.");
+        return;
+    }
+    memset(bench, 0, sizeof(pool_bench));
+    if (create_pool_allocator(&bench->pool, arena, sizeof(bench_particle), alignof(bench_particle), BENCH_POOL_BLOCKS) != RESULT_SUCCESS) {
+        return;
+    }
+
+    // Sanity check: every block can be handed out once, a full pool fails without a bug, and freed blocks are reused.
+    for (uint32_t i = 0; i < BENCH_POOL_BLOCKS; ++i) {
+        void* block = pool_allocate(&bench->pool);
+        BENCH_CHECK(block != NULL && ((uintptr_t)block % alignof(bench_particle)) == 0, break, "Pool block %u is NULL or misaligned", i);
+        if (i < BENCH_POOL_LIVE_BLOCKS) {
+            bench->live[i] = block;
+        }
+    }
+    BENCH_CHECK(pool_allocate(&bench->pool) == NULL, , "Allocated more blocks than the pool holds");
+    void* freed = bench->live[7];
+    pool_free(&bench->pool, freed);
+    BENCH_CHECK(pool_allocate(&bench->pool) == freed, , "Freed pool block was not reused");
+    pool_statistics statistics = get_pool_statistics(&bench->pool);
+    BENCH_CHECK(statistics.in_use == BENCH_POOL_BLOCKS && statistics.peak_in_use == BENCH_POOL_BLOCKS && statistics.failed_allocation_count == 1,
+        , "Pool statistics are wrong: %u in use, %u peak, %llu failed", statistics.in_use, statistics.peak_in_use, (unsigned long long)statistics.failed_allocation_count);
+    reset_pool_allocator(&bench->pool);
+
+    // Sanity check: threads sharing the pool (with and without caches) are never handed the same block, and every block comes back.
+    pool_bench_thread thread_benches[BENCH_POOL_THREADS];
+    thread threads[BENCH_POOL_THREADS];
+    for (uint32_t i = 0; i < BENCH_POOL_THREADS; ++i) {
+        thread_benches[i] = (pool_bench_thread){ .bench = bench, .owner = i };
+        if (create_thread(&threads[i], churn_pool_on_thread, &thread_benches[i]) != RESULT_SUCCESS) {
+            return;
+        }
+    }
+    for (uint32_t i = 0; i < BENCH_POOL_THREADS; ++i) {
+        join_thread(&threads[i]);
+        destroy_thread(&threads[i]);
+    }
+    statistics = get_pool_statistics(&bench->pool);
+    BENCH_CHECK(atomic_load_uint32(&bench->corrupted_blocks, MEMORY_ORDER_RELAXED) == 0 && statistics.in_use == 0, ,
+        "Pool blocks were shared between threads (%u) or not returned (%u in use)", atomic_load_uint32(&bench->corrupted_blocks, MEMORY_ORDER_RELAXED), statistics.in_use);
+
+    run_bench("pool/allocate_free", bench_pool_allocate_free, bench, sizeof(bench_particle));
+    run_bench("pool/cache_allocate_free", bench_pool_cache_allocate_free, bench, sizeof(bench_particle));
+
+    for (uint32_t i = 0; i < BENCH_POOL_LIVE_BLOCKS; ++i) {
+        bench->live[i] = pool_cache_allocate(&bench->pool, &bench->cache);
+    }
+    bench->random_state = 0x9E3779B9u;
+    run_bench("pool/churn_" TOSTRING(BENCH_POOL_LIVE_BLOCKS) "_live_blocks", bench_pool_churn, bench, sizeof(bench_particle));
+    flush_pool_cache(&bench->pool, &bench->cache);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    TLSF Allocator
+=============================================================================================================================
+*/
+
+#define BENCH_TLSF_CAPACITY (96 * 1024 * 1024)
+#define BENCH_TLSF_SLOTS 512
+#define BENCH_TLSF_TRACE_LENGTH 16384
+
+/*
+An allocation trace modelled on the game's variable-size data: mostly small records, some level and asset data,
+a few streamed sound buffers. Each entry names a slot: if the slot is empty it is allocated with the entry's size, otherwise it is freed
+(or, for a few entries, resized). Replaying it in a loop keeps the heap at a steady state with a churning mix of sizes.
+*/
+typedef struct {
+    uint32_t slot;
+    uint32_t bytes;
+    bool resize;
+} tlsf_trace_entry;
+
+typedef struct {
+    tlsf_allocator tlsf;
+    tlsf_trace_entry trace[BENCH_TLSF_TRACE_LENGTH];
+    void* slots[BENCH_TLSF_SLOTS];
+    uint32_t cursor;
+} tlsf_bench;
+
+static uint32_t next_trace_random(uint32_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+    return *state;
+}
+
+static void create_tlsf_trace(tlsf_trace_entry* trace, uint32_t length, uint32_t seed) {
+    uint32_t state = seed;
+    for (uint32_t i = 0; i < length; ++i) {
+        uint32_t kind = next_trace_random(&state) % 100;
+        uint32_t bytes;
+        if (kind < 60) {
+            bytes = 16 + next_trace_random(&state) % 240; // small records
+        }
+        else if (kind < 90) {
+            bytes = 256 + next_trace_random(&state) % (16 * 1024); // level and asset data
+        }
+        else if (kind < 99) {
+            bytes = 16 * 1024 + next_trace_random(&state) % (240 * 1024);
+        }
+        else {
+            bytes = 256 * 1024 + next_trace_random(&state) % (1792 * 1024); // streamed sound buffers
+        }
+        trace[i] = (tlsf_trace_entry){ .slot = next_trace_random(&state) % BENCH_TLSF_SLOTS, .bytes = bytes, .resize = next_trace_random(&state) % 16 == 0 };
+    }
+}
+
+static void bench_tlsf_allocate_free(void* context, uint64_t iterations) {
+    tlsf_bench* bench = (tlsf_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        void* allocation = tlsf_allocate(&bench->tlsf, 16, 64);
+        BENCH_DO_NOT_OPTIMIZE(allocation);
+        tlsf_free(&bench->tlsf, allocation);
+    }
+}
+
+static void bench_malloc_free(void* context, uint64_t iterations) {
+    (void)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        void* allocation = malloc(64);
+        BENCH_DO_NOT_OPTIMIZE(allocation);
+        free(allocation);
+    }
+}
+
+static void bench_tlsf_trace(void* context, uint64_t iterations) {
+    tlsf_bench* bench = (tlsf_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        const tlsf_trace_entry* entry = &bench->trace[bench->cursor];
+        bench->cursor = (bench->cursor + 1) % BENCH_TLSF_TRACE_LENGTH;
+        void** slot = &bench->slots[entry->slot];
+        if (*slot == NULL) {
+            *slot = tlsf_allocate(&bench->tlsf, 16, entry->bytes);
+        }
+        else if (entry->resize) {
+            void* resized = tlsf_reallocate(&bench->tlsf, *slot, 16, entry->bytes);
+            *slot = resized != NULL ? resized : *slot;
+        }
+        else {
+            tlsf_free(&bench->tlsf, *slot);
+            *slot = NULL;
+        }
+    }
+}
+
+static void bench_malloc_trace(void* context, uint64_t iterations) {
+    tlsf_bench* bench = (tlsf_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        const tlsf_trace_entry* entry = &bench->trace[bench->cursor];
+        bench->cursor = (bench->cursor + 1) % BENCH_TLSF_TRACE_LENGTH;
+        void** slot = &bench->slots[entry->slot];
+        if (*slot == NULL) {
+            *slot = malloc(entry->bytes);
+        }
+        else if (entry->resize) {
+            void* resized = realloc(*slot, entry->bytes);
+            *slot = resized != NULL ? resized : *slot;
+        }
+        else {
+            free(*slot);
+            *slot = NULL;
+        }
+    }
+}
+
+static void check_tlsf_allocator(tlsf_bench* bench) {
+    // Sanity check: allocations never overlap (each slot is filled with its own byte and checked before it is freed or resized),
+    // alignment is honoured, resizing keeps the contents, and freeing everything merges the heap back into one block.
+    const size_t alignments[] = { 16, 16, 16, 64, 256, 4096 };
+    uint32_t sizes[BENCH_TLSF_SLOTS] = { 0 };
+    uint32_t state = 12345;
+    for (uint32_t i = 0; i < BENCH_TLSF_TRACE_LENGTH; ++i) {
+        const tlsf_trace_entry* entry = &bench->trace[i];
+        uint8_t* allocation = (uint8_t*)bench->slots[entry->slot];
+        uint8_t fill = (uint8_t)entry->slot;
+        if (allocation != NULL) {
+            for (uint32_t b = 0; b < sizes[entry->slot]; b += 61) {
+                BENCH_CHECK(allocation[b] == fill, return, "TLSF allocation in slot %u was overwritten at byte %u", entry->slot, b);
+            }
+        }
+
+        if (allocation == NULL) {
+            size_t alignment = alignments[next_trace_random(&state) % ARRAY_LENGTH(alignments)];
+            allocation = (uint8_t*)tlsf_allocate(&bench->tlsf, alignment, entry->bytes);
+            BENCH_CHECK(allocation != NULL && ((uintptr_t)allocation & (alignment - 1)) == 0, return,
+                "TLSF allocation of %u bytes aligned to %zu failed or is misaligned", entry->bytes, alignment);
+            memset(allocation, fill, entry->bytes);
+            sizes[entry->slot] = entry->bytes;
+        }
+        else if (entry->resize) {
+            uint8_t* resized = (uint8_t*)tlsf_reallocate(&bench->tlsf, allocation, 16, entry->bytes);
+            BENCH_CHECK(resized != NULL, return, "TLSF reallocation to %u bytes failed", entry->bytes);
+            allocation = resized;
+            memset(allocation, fill, entry->bytes);
+            sizes[entry->slot] = entry->bytes;
+        }
+        else {
+            tlsf_free(&bench->tlsf, allocation);
+            allocation = NULL;
+            sizes[entry->slot] = 0;
+        }
+        bench->slots[entry->slot] = allocation;
+
+        if (i % 1024 == 0) {
+            get_tlsf_statistics(&bench->tlsf); // checks the block list in debug builds
+        }
+    }
+
+    for (uint32_t i = 0; i < BENCH_TLSF_SLOTS; ++i) {
+        tlsf_free(&bench->tlsf, bench->slots[i]);
+        bench->slots[i] = NULL;
+    }
+    tlsf_statistics statistics = get_tlsf_statistics(&bench->tlsf);
+    BENCH_CHECK(statistics.free_blocks == 1 && statistics.allocated_blocks == 0 && statistics.used_bytes == 0 && statistics.fragmentation == 0.0f, ,
+        "TLSF heap did not merge back into one block: %u free blocks, %u allocated, %zu bytes used", statistics.free_blocks, statistics.allocated_blocks, statistics.used_bytes);
+    BENCH_CHECK(tlsf_allocate(&bench->tlsf, 16, BENCH_TLSF_CAPACITY) == NULL, , "TLSF allocated more than its capacity");
+}
+
+static void run_tlsf_allocator_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    tlsf_bench* bench = (tlsf_bench*)bump_allocate(arena, alignof(tlsf_bench), sizeof(tlsf_bench));
+    if (bench == NULL) {
+        BUG("Failed to allocate TLSF benchmark data.");
+        return;
+    }
+    memset(bench, 0, sizeof(tlsf_bench));
+    if (create_tlsf_allocator(&bench->tlsf, arena, BENCH_TLSF_CAPACITY) != RESULT_SUCCESS) {
+        return;
+    }
+    create_tlsf_trace(bench->trace, BENCH_TLSF_TRACE_LENGTH, 0xC0FFEEu);
+    check_tlsf_allocator(bench);
+    reset_tlsf_allocator(&bench->tlsf);
+
+    run_bench("tlsf/allocate_free_64B", bench_tlsf_allocate_free, bench, 64);
+    run_bench("malloc/allocate_free_64B", bench_malloc_free, NULL, 64);
+
+    bench->cursor = 0;
+    run_bench("tlsf/replay_game_trace", bench_tlsf_trace, bench, 0);
+    tlsf_statistics statistics = get_tlsf_statistics(&bench->tlsf);
+    for (uint32_t i = 0; i < BENCH_TLSF_SLOTS; ++i) {
+        tlsf_free(&bench->tlsf, bench->slots[i]);
+        bench->slots[i] = NULL;
+    }
+
+    bench->cursor = 0;
+    run_bench("malloc/replay_game_trace", bench_malloc_trace, bench, 0);
+    for (uint32_t i = 0; i < BENCH_TLSF_SLOTS; ++i) {
+        free(bench->slots[i]);
+        bench->slots[i] = NULL;
+    }
+
+    if (get_bench_output() == BENCH_OUTPUT_TABLE && statistics.allocation_count > 0) {
+        printf("tlsf trace heap: %u allocated blocks, %.1f MB used (peak %.1f MB), %u free blocks, %.1f%% fragmentation, %llu failed allocations\n",
+            statistics.allocated_blocks, (double)statistics.used_bytes / (1024.0 * 1024.0), (double)statistics.peak_used_bytes / (1024.0 * 1024.0),
+            statistics.free_blocks, statistics.fragmentation * 100.0f, (unsigned long long)statistics.failed_allocation_count);
+    }
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Capped Arrays
+=============================================================================================================================
+*/
+
+// Capacity has head room above the benchmarked element count, so that every operation stays in bounds.
+#define BENCH_ARRAY_CAPACITY 1024
+#define BENCH_ARRAY_COUNT 512
+
+typedef struct {
+    vector2 position;
+    vector2 direction;
+    float speed;
+    float angular_velocity;
+    float rotation;
+    uint32_t size;
+    uint32_t content;
+    uint32_t id;
+} bench_entity;
+
+DECLARE_CAPPED_ARRAY(bench_values, uint32_t, BENCH_ARRAY_CAPACITY)
+IMPLEMENT_CAPPED_ARRAY(bench_values, uint32_t, BENCH_ARRAY_CAPACITY)
+DECLARE_CAPPED_ARRAY(bench_entities, bench_entity, BENCH_ARRAY_CAPACITY)
+IMPLEMENT_CAPPED_ARRAY(bench_entities, bench_entity, BENCH_ARRAY_CAPACITY)
+
+// Generates the same set of benchmarks for every capped array type.
+#define CAPPED_ARRAY_BENCHES(name, element_type, make_element) \
+    static void bench_##name##_append(void* context, uint64_t iterations) { \
+        name* array = (name*)context; \
+        for (uint64_t i = 0; i < iterations; ++i) { \
+            if (array->count >= BENCH_ARRAY_COUNT) { \
+                name##_clear(array); \
+            } \
+            name##_append(array, make_element((uint32_t)i)); \
+        } \
+        BENCH_DO_NOT_OPTIMIZE(array->elements[0]); \
+    } \
+    static void bench_##name##_insert_middle(void* context, uint64_t iterations) { \
+        name* array = (name*)context; \
+        for (uint64_t i = 0; i < iterations; ++i) { \
+            array->count = BENCH_ARRAY_COUNT; \
+            name##_insert(array, BENCH_ARRAY_COUNT / 2, make_element((uint32_t)i)); \
+        } \
+        BENCH_DO_NOT_OPTIMIZE(array->elements[0]); \
+    } \
+    static void bench_##name##_remove_middle(void* context, uint64_t iterations) { \
+        name* array = (name*)context; \
+        for (uint64_t i = 0; i < iterations; ++i) { \
+            array->count = BENCH_ARRAY_COUNT; \
+            name##_remove(array, BENCH_ARRAY_COUNT / 2); \
+        } \
+        BENCH_DO_NOT_OPTIMIZE(array->elements[0]); \
+    } \
+    static void bench_##name##_remove_swap(void* context, uint64_t iterations) { \
+        name* array = (name*)context; \
+        for (uint64_t i = 0; i < iterations; ++i) { \
+            array->count = BENCH_ARRAY_COUNT; \
+            name##_remove_swap(array, (uint32_t)(i % BENCH_ARRAY_COUNT)); \
+        } \
+        BENCH_DO_NOT_OPTIMIZE(array->elements[0]); \
+    } \
+    /* Keeps every other element, the way a despawn pass removes the dead entities. */ \
+    static bool name##_every_other(const element_type* element, void* context) { \
+        (void)element; \
+        uint32_t* visited = (uint32_t*)context; \
+        return (*visited)++ % 2 == 1; \
+    } \
+    static void bench_##name##_remove_every_other_loop(void* context, uint64_t iterations) { \
+        name* array = (name*)context; \
+        for (uint64_t i = 0; i < iterations; ++i) { \
+            array->count = BENCH_ARRAY_COUNT; \
+            for (int32_t j = BENCH_ARRAY_COUNT - 1; j >= 0; j -= 2) { \
+                name##_remove(array, (uint32_t)j); \
+            } \
+        } \
+        BENCH_DO_NOT_OPTIMIZE(array->elements[0]); \
+    } \
+    static void bench_##name##_remove_every_other_if(void* context, uint64_t iterations) { \
+        name* array = (name*)context; \
+        for (uint64_t i = 0; i < iterations; ++i) { \
+            array->count = BENCH_ARRAY_COUNT; \
+            uint32_t visited = 0; \
+            name##_remove_if(array, name##_every_other, &visited); \
+        } \
+        BENCH_DO_NOT_OPTIMIZE(array->elements[0]); \
+    } \
+    static void bench_##name##_find_missing(void* context, uint64_t iterations) { \
+        name* array = (name*)context; \
+        array->count = BENCH_ARRAY_COUNT; \
+        element_type missing = make_element(UINT32_MAX); \
+        for (uint64_t i = 0; i < iterations; ++i) { \
+            uint32_t index = 0; \
+            bool found = name##_find(array, missing, &index); \
+            BENCH_DO_NOT_OPTIMIZE(found); \
+        } \
+    } \
+    static void run_##name##_benches(name* array) { \
+        for (uint32_t i = 0; i < BENCH_ARRAY_CAPACITY; ++i) { \
+            array->elements[i] = make_element(i); \
+        } \
+        array->count = 0; \
+        run_bench(#name "/append", bench_##name##_append, array, sizeof(element_type)); \
+        run_bench(#name "/insert_middle_of_" TOSTRING(BENCH_ARRAY_COUNT), bench_##name##_insert_middle, array, 0); \
+        run_bench(#name "/remove_middle_of_" TOSTRING(BENCH_ARRAY_COUNT), bench_##name##_remove_middle, array, 0); \
+        run_bench(#name "/remove_swap", bench_##name##_remove_swap, array, 0); \
+        run_bench(#name "/remove_every_other_of_" TOSTRING(BENCH_ARRAY_COUNT) "/remove_loop", bench_##name##_remove_every_other_loop, array, 0); \
+        run_bench(#name "/remove_every_other_of_" TOSTRING(BENCH_ARRAY_COUNT) "/remove_if", bench_##name##_remove_every_other_if, array, 0); \
+        run_bench(#name "/find_missing_in_" TOSTRING(BENCH_ARRAY_COUNT), bench_##name##_find_missing, array, sizeof(element_type) * BENCH_ARRAY_COUNT); \
+    }
+
+static inline uint32_t make_bench_value(uint32_t i) {
+    return i;
+}
+
+static inline bench_entity make_bench_entity(uint32_t i) {
+    bench_entity entity = { 0 };
+    entity.position = (vector2){ (float)i, (float)i };
+    entity.id = i;
+    return entity;
+}
+
+CAPPED_ARRAY_BENCHES(bench_values, uint32_t, make_bench_value)
+CAPPED_ARRAY_BENCHES(bench_entities, bench_entity, make_bench_entity)
+
+DECLARE_CAPPED_ARRAY(bench_bytes, uint8_t, 256)
+IMPLEMENT_CAPPED_ARRAY(bench_bytes, uint8_t, 256)
+DECLARE_CAPPED_ARRAY(bench_halves, uint16_t, 256)
+IMPLEMENT_CAPPED_ARRAY(bench_halves, uint16_t, 256)
+DECLARE_CAPPED_ARRAY(bench_words, uint64_t, 256)
+IMPLEMENT_CAPPED_ARRAY(bench_words, uint64_t, 256)
+
+static bool bench_value_is_even(const uint32_t* value, void* context) {
+    (void)context;
+    return *value % 2 == 0;
+}
+
+// Finds every element of an array of 0, 1, 2, ... (offset so no element is zero), in the SIMD blocks and in the tail, and a missing one.
+#define CHECK_CAPPED_ARRAY_FIND(name, element_type, array) \
+    { \
+        (array)->count = 0; \
+        for (uint32_t i = 0; i < 200; ++i) { \
+            name##_append((array), (element_type)(i + 1)); \
+        } \
+        for (uint32_t i = 0; i < 200; ++i) { \
+            uint32_t index = UINT32_MAX; \
+            found_all = found_all && name##_find((array), (element_type)(i + 1), &index) && index == i; \
+        } \
+        found_all = found_all && !name##_find((array), (element_type)0, NULL); \
+    }
+
+static void check_capped_arrays(bump_allocator* arena) {
+    // Sanity check: remove shifts exactly the elements after the index, remove_if keeps the order of the rest,
+    // and find matches a memcmp loop for every scalar size and for structs.
+    reset_bump_allocator(arena);
+    bench_values* values = (bench_values*)bump_allocate(arena, alignof(bench_values), sizeof(bench_values));
+    bench_entities* entities = (bench_entities*)bump_allocate(arena, alignof(bench_entities), sizeof(bench_entities));
+    bench_bytes* bytes = (bench_bytes*)bump_allocate(arena, alignof(bench_bytes), sizeof(bench_bytes));
+    bench_halves* halves = (bench_halves*)bump_allocate(arena, alignof(bench_halves), sizeof(bench_halves));
+    bench_words* words = (bench_words*)bump_allocate(arena, alignof(bench_words), sizeof(bench_words));
+    BENCH_CHECK(values != NULL && entities != NULL && bytes != NULL && halves != NULL && words != NULL, return, "Failed to allocate capped array checks");
+
+    values->count = 0;
+    for (uint32_t i = 0; i < 10; ++i) {
+        bench_values_append(values, i);
+    }
+    values->elements[10] = 12345; // past the count, where the old remove read from
+    bench_values_remove(values, 3);
+    bench_values_remove(values, 0);
+    BENCH_CHECK(values->count == 8 && values->elements[0] == 1 && values->elements[2] == 4 && values->elements[7] == 9 && values->elements[8] == 9
+        && values->elements[10] == 12345, , "Capped array remove did not shift exactly the elements after the index");
+
+    uint32_t removed = bench_values_remove_if(values, bench_value_is_even, NULL);
+    BENCH_CHECK(removed == 4 && values->count == 4 && values->elements[0] == 1 && values->elements[1] == 5 && values->elements[3] == 9, ,
+        "Capped array remove_if removed %u elements, or did not keep the order of the rest", removed);
+
+    bool found_all = true;
+    CHECK_CAPPED_ARRAY_FIND(bench_bytes, uint8_t, bytes)
+    CHECK_CAPPED_ARRAY_FIND(bench_halves, uint16_t, halves)
+    CHECK_CAPPED_ARRAY_FIND(bench_values, uint32_t, values)
+    CHECK_CAPPED_ARRAY_FIND(bench_words, uint64_t, words)
+    words->elements[150] = 151ull << 32; // the same low half as another element
+    found_all = found_all && !bench_words_find(words, 151ull << 32 | 150, NULL) && bench_words_find(words, 151ull << 32, NULL);
+    entities->count = 0;
+    for (uint32_t i = 0; i < 200; ++i) {
+        bench_entities_append(entities, make_bench_entity(i));
+    }
+    uint32_t entity_index = 0;
+    found_all = found_all && bench_entities_find(entities, make_bench_entity(123), &entity_index) && entity_index == 123;
+    BENCH_CHECK(found_all, , "Capped array find did not find the first equal element");
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Dynamic Arrays
+=============================================================================================================================
+*/
+
+DECLARE_DYNAMIC_ARRAY(bench_dynamic_values, uint32_t)
+IMPLEMENT_DYNAMIC_ARRAY(bench_dynamic_values, uint32_t)
+
+#define BENCH_DYNAMIC_ARRAY_COUNT 100000
+
+typedef struct {
+    bump_allocator* arena;
+    bool interleave; // allocate something else between appends, so the array is never the last allocation and has to copy to grow
+} dynamic_array_bench;
+
+// Builds an array of BENCH_DYNAMIC_ARRAY_COUNT values from empty, growth included.
+static void bench_dynamic_array_append(void* context, uint64_t iterations) {
+    dynamic_array_bench* bench = (dynamic_array_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        reset_bump_allocator(bench->arena);
+        bench_dynamic_values values = { 0 };
+        for (uint32_t j = 0; j < BENCH_DYNAMIC_ARRAY_COUNT; ++j) {
+            if (bench->interleave && values.count == values.capacity) {
+                bump_allocate(bench->arena, 1, 1);
+            }
+            bench_dynamic_values_append(&values, bench->arena, j);
+        }
+        BENCH_DO_NOT_OPTIMIZE(values.elements[BENCH_DYNAMIC_ARRAY_COUNT - 1]);
+    }
+}
+
+static void check_dynamic_arrays(bump_allocator* arena) {
+    // Sanity check: an array that is the last allocation grows in place, one that is not moves with its contents,
+    // and insert and remove keep the order of the other elements.
+    reset_bump_allocator(arena);
+    bench_dynamic_values values = { 0 };
+    bench_dynamic_values_append(&values, arena, 0);
+    uint32_t* first_elements = values.elements;
+    for (uint32_t i = 1; i < 1000; ++i) {
+        bench_dynamic_values_append(&values, arena, i);
+    }
+    BENCH_CHECK(values.elements == first_elements && values.count == 1000 && values.capacity >= 1000, ,
+        "Dynamic array at the end of its arena moved when it grew (%u elements, capacity %u)", values.count, values.capacity);
+
+    bump_allocate(arena, 1, 1);
+    bench_dynamic_values_reserve(&values, arena, values.capacity + 1);
+    BENCH_CHECK(values.elements != first_elements && values.elements[999] == 999, , "Dynamic array did not keep its elements when it moved");
+
+    uint32_t inserted[3] = { 100, 101, 102 };
+    bench_dynamic_values_insert_multiple(&values, arena, 1, inserted, 3);
+    bench_dynamic_values_remove(&values, 0);
+    bench_dynamic_values_remove(&values, 3);
+    uint32_t index = 0;
+    BENCH_CHECK(values.count == 1001 && values.elements[0] == 100 && values.elements[2] == 102 && values.elements[3] == 2 && values.elements[1000] == 999
+        && bench_dynamic_values_find(&values, 500, &index) && index == 501, , "Dynamic array insert and remove did not keep the element order");
+    reset_bump_allocator(arena);
+}
+
+static void run_dynamic_array_benches(bump_allocator* arena) {
+    check_dynamic_arrays(arena);
+
+    bump_allocator reserved;
+    if (create_bump_allocator(&reserved, sizeof(uint32_t) * BENCH_DYNAMIC_ARRAY_COUNT * 2) != RESULT_SUCCESS) {
+        return;
+    }
+    dynamic_array_bench in_place = { .arena = &reserved };
+    dynamic_array_bench copying = { .arena = arena, .interleave = true };
+    run_bench("dynamic_array/append_" TOSTRING(BENCH_DYNAMIC_ARRAY_COUNT) "/reserved_arena", bench_dynamic_array_append, &in_place, sizeof(uint32_t) * BENCH_DYNAMIC_ARRAY_COUNT);
+    run_bench("dynamic_array/append_" TOSTRING(BENCH_DYNAMIC_ARRAY_COUNT) "/shared_arena", bench_dynamic_array_append, &copying, sizeof(uint32_t) * BENCH_DYNAMIC_ARRAY_COUNT);
+    destroy_bump_allocator(&reserved);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Hash Maps
+=============================================================================================================================
+*/
+
+DECLARE_HASH_MAP(bench_lookup, uint64_t, uint32_t)
+IMPLEMENT_HASH_MAP(bench_lookup, uint64_t, uint32_t, hash_uint64, uint64_equal)
+DECLARE_HASH_MAP(bench_names, string, uint32_t)
+IMPLEMENT_HASH_MAP(bench_names, string, uint32_t, hash_string, string_equal)
+
+#define BENCH_HASH_MAP_LOOKUPS 4096
+
+typedef struct {
+    bench_lookup map;
+    uint64_t* keys; // keys[i] maps to i, for the linear scan
+    uint32_t count;
+    uint64_t* lookups; // keys to look up, in a random order
+} hash_map_bench;
+
+static void bench_hash_map_find(void* context, uint64_t iterations) {
+    hash_map_bench* bench = (hash_map_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        uint32_t* value = bench_lookup_find(&bench->map, bench->lookups[i % BENCH_HASH_MAP_LOOKUPS]);
+        BENCH_DO_NOT_OPTIMIZE(value);
+    }
+}
+
+static void bench_linear_scan_find(void* context, uint64_t iterations) {
+    hash_map_bench* bench = (hash_map_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        uint64_t key = bench->lookups[i % BENCH_HASH_MAP_LOOKUPS];
+        uint32_t index = 0;
+        while (index < bench->count && bench->keys[index] != key) {
+            ++index;
+        }
+        BENCH_DO_NOT_OPTIMIZE(index);
+    }
+}
+
+static void check_hash_maps(bump_allocator* arena) {
+    // Sanity check: every inserted key is found with its latest value through growth, removals leave the other keys reachable,
+    // and iteration visits each entry once.
+    reset_bump_allocator(arena);
+    bench_lookup map = { 0 };
+    for (uint32_t i = 0; i < 10000; ++i) {
+        bench_lookup_insert(&map, arena, (uint64_t)i * 3, i);
+    }
+    bench_lookup_insert(&map, arena, 300, 12345);
+    for (uint32_t i = 0; i < 10000; i += 2) {
+        bench_lookup_remove(&map, (uint64_t)i * 3);
+    }
+    uint32_t* overwritten = bench_lookup_find(&map, 303);
+    BENCH_CHECK(map.count == 5000 && overwritten != NULL && *overwritten == 101 && !bench_lookup_contains(&map, 300) && !bench_lookup_contains(&map, 1)
+        && map.count + map.deleted_count <= map.capacity / 8 * 7, , "Hash map lost or kept the wrong entries (%u entries, capacity %u)", map.count, map.capacity);
+
+    uint32_t cursor = 0;
+    uint32_t visited = 0;
+    uint64_t key = 0;
+    uint32_t* value = NULL;
+    while (bench_lookup_next(&map, &cursor, &key, &value)) {
+        visited += (key == (uint64_t)*value * 3 && *value % 2 == 1) ? 1 : 0;
+    }
+    BENCH_CHECK(visited == 5000, , "Hash map iteration visited %u of 5000 entries", visited);
+
+    // Churn that never grows the map has to reuse or clear out the deleted slots.
+    uint32_t capacity = map.capacity;
+    for (uint32_t i = 0; i < 100000; ++i) {
+        bench_lookup_insert(&map, arena, 1000000 + i, i);
+        bench_lookup_remove(&map, 1000000 + i);
+    }
+    BENCH_CHECK(map.count == 5000 && map.capacity == capacity && bench_lookup_contains(&map, 303), , "Hash map churn grew the map or lost entries");
+
+    bench_names names = { 0 };
+    bench_names_insert(&names, arena, (string)CSTR("explosion"), 1);
+    bench_names_insert(&names, arena, (string)CSTR("laser"), 2);
+    string key_copy = { .text = "explosion!", .length = 9 };
+    uint32_t* found = bench_names_find(&names, key_copy);
+    BENCH_CHECK(found != NULL && *found == 1 && !bench_names_contains(&names, (string)CSTR("lase")), , "Hash map with string keys compared the wrong bytes");
+    reset_bump_allocator(arena);
+}
+
+static void run_hash_map_benches(bump_allocator* arena) {
+    check_hash_maps(arena);
+
+    static const uint32_t counts[] = { 8, 64, 1024, 1024 * 1024 };
+    for (uint32_t c = 0; c < ARRAY_LENGTH(counts); ++c) {
+        reset_bump_allocator(arena);
+        hash_map_bench bench = { .count = counts[c] };
+        bench.keys = (uint64_t*)bump_allocate(arena, alignof(uint64_t), sizeof(uint64_t) * bench.count);
+        bench.lookups = (uint64_t*)bump_allocate(arena, alignof(uint64_t), sizeof(uint64_t) * BENCH_HASH_MAP_LOOKUPS);
+        BENCH_CHECK(bench.keys != NULL && bench.lookups != NULL, return, "Failed to allocate hash map benchmark keys");
+        bench_lookup_reserve(&bench.map, arena, bench.count);
+        for (uint32_t i = 0; i < bench.count; ++i) {
+            bench.keys[i] = hash_uint64(i + 1); // arbitrary, well spread keys, like handles or string hashes
+            bench_lookup_insert(&bench.map, arena, bench.keys[i], i);
+        }
+        uint64_t random_state = 12345;
+        for (uint32_t i = 0; i < BENCH_HASH_MAP_LOOKUPS; ++i) {
+            random_state = random_state * 6364136223846793005ull + 1442695040888963407ull;
+            bench.lookups[i] = bench.keys[(random_state >> 33) % bench.count];
+        }
+
+        char name[64];
+        snprintf(name, sizeof(name), "hash_map/find_%u", bench.count);
+        run_bench(name, bench_hash_map_find, &bench, 0);
+        snprintf(name, sizeof(name), "linear_scan/find_%u", bench.count);
+        run_bench(name, bench_linear_scan_find, &bench, 0);
+    }
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Slot Maps
+=============================================================================================================================
+*/
+
+DECLARE_SLOT_MAP(bench_slot_entities, bench_entity)
+IMPLEMENT_SLOT_MAP(bench_slot_entities, bench_entity)
+
+#define BENCH_SLOT_MAP_COUNT 100000
+
+typedef struct {
+    bench_slot_entities map;
+    bump_allocator* arena;
+    slot_handle* handles; // in a random order
+} slot_map_bench;
+
+static void bench_slot_map_get(void* context, uint64_t iterations) {
+    slot_map_bench* bench = (slot_map_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bench_entity* entity = bench_slot_entities_get(&bench->map, bench->handles[i % BENCH_SLOT_MAP_COUNT]);
+        BENCH_DO_NOT_OPTIMIZE(entity);
+    }
+}
+
+// Removes an entity and inserts another, so the map stays full and the freed slots are reused.
+static void bench_slot_map_remove_insert(void* context, uint64_t iterations) {
+    slot_map_bench* bench = (slot_map_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        slot_handle* handle = &bench->handles[i % BENCH_SLOT_MAP_COUNT];
+        bench_slot_entities_remove(&bench->map, *handle);
+        *handle = bench_slot_entities_insert(&bench->map, bench->arena, make_bench_entity((uint32_t)i));
+    }
+    BENCH_DO_NOT_OPTIMIZE(bench->map.count);
+}
+
+static void check_slot_maps(bump_allocator* arena) {
+    // Sanity check: handles find their element after other elements are removed and moved into their place,
+    // a removed element's handle is stale even once its slot is reused, and cleared maps reuse their slots.
+    reset_bump_allocator(arena);
+    bench_slot_entities map = { 0 };
+    slot_handle handles[1000];
+    for (uint32_t i = 0; i < 1000; ++i) {
+        handles[i] = bench_slot_entities_insert(&map, arena, make_bench_entity(i));
+    }
+    for (uint32_t i = 0; i < 1000; i += 3) {
+        bench_slot_entities_remove(&map, handles[i]);
+    }
+    bool found_all = map.count == 666;
+    for (uint32_t i = 0; i < 1000; ++i) {
+        bench_entity* entity = bench_slot_entities_get(&map, handles[i]);
+        found_all = found_all && (i % 3 == 0 ? entity == NULL : entity != NULL && entity->id == i);
+    }
+    BENCH_CHECK(found_all, , "Slot map handles did not follow their elements through removals");
+
+    slot_handle reused = bench_slot_entities_insert(&map, arena, make_bench_entity(5000));
+    BENCH_CHECK((reused & (SLOT_MAP_MAX_SLOTS - 1)) == (handles[999] & (SLOT_MAP_MAX_SLOTS - 1)) && reused != handles[999]
+        && !bench_slot_entities_contains(&map, handles[999]) && bench_slot_entities_get(&map, reused)->id == 5000, ,
+        "Slot map did not reuse the last freed slot with a new generation");
+    BENCH_CHECK(!bench_slot_entities_remove(&map, handles[999]) && !bench_slot_entities_contains(&map, SLOT_HANDLE_NONE), , "Slot map accepted a stale handle");
+
+    uint32_t slot_count = map.lookup.slot_count;
+    bench_slot_entities_clear(&map);
+    for (uint32_t i = 0; i < 1000; ++i) {
+        bench_slot_entities_insert(&map, arena, make_bench_entity(i));
+    }
+    BENCH_CHECK(map.count == 1000 && map.lookup.slot_count == slot_count && !bench_slot_entities_contains(&map, handles[1]), ,
+        "Cleared slot map did not reuse its slots (%u slots, was %u)", map.lookup.slot_count, slot_count);
+
+    // Sanity check: a slot whose generation runs out is retired, and neither SLOT_HANDLE_NONE nor its old handles find anything.
+    bench_slot_entities cycled = { 0 };
+    slot_handle last = SLOT_HANDLE_NONE;
+    for (uint32_t i = 0; i < SLOT_MAP_MAX_GENERATION * 2; ++i) {
+        last = bench_slot_entities_insert(&cycled, arena, make_bench_entity(111));
+        bench_slot_entities_remove(&cycled, last);
+    }
+    bench_slot_entities_insert(&cycled, arena, make_bench_entity(111));
+    BENCH_CHECK(cycled.lookup.slots[0].generation == 0 && !bench_slot_entities_contains(&cycled, SLOT_HANDLE_NONE) && !bench_slot_entities_contains(&cycled, last)
+        && !bench_slot_entities_contains(&cycled, SLOT_MAP_MAX_GENERATION << SLOT_MAP_INDEX_BITS), ,
+        "Slot map handle found an element in a retired slot");
+    reset_bump_allocator(arena);
+}
+
+static void run_slot_map_benches(bump_allocator* arena) {
+    check_slot_maps(arena);
+
+    reset_bump_allocator(arena);
+    slot_map_bench bench = { .arena = arena };
+    bench.handles = (slot_handle*)bump_allocate(arena, alignof(slot_handle), sizeof(slot_handle) * BENCH_SLOT_MAP_COUNT);
+    BENCH_CHECK(bench.handles != NULL, return, "Failed to allocate slot map benchmark handles");
+    bench_slot_entities_reserve(&bench.map, arena, BENCH_SLOT_MAP_COUNT);
+    for (uint32_t i = 0; i < BENCH_SLOT_MAP_COUNT; ++i) {
+        bench.handles[i] = bench_slot_entities_insert(&bench.map, arena, make_bench_entity(i));
+    }
+    uint64_t random_state = 12345;
+    for (uint32_t i = BENCH_SLOT_MAP_COUNT - 1; i > 0; --i) {
+        random_state = random_state * 6364136223846793005ull + 1442695040888963407ull;
+        uint32_t j = (uint32_t)((random_state >> 33) % (i + 1));
+        slot_handle swap = bench.handles[i];
+        bench.handles[i] = bench.handles[j];
+        bench.handles[j] = swap;
+    }
+
+    run_bench("slot_map/get_" TOSTRING(BENCH_SLOT_MAP_COUNT), bench_slot_map_get, &bench, 0);
+    run_bench("slot_map/remove_insert_" TOSTRING(BENCH_SLOT_MAP_COUNT), bench_slot_map_remove_insert, &bench, 0);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Struct of Arrays
+=============================================================================================================================
+*/
+
+DECLARE_SOA(bench_motion, (vector2, position), (vector2, velocity), (float, rotation), (float, angular_velocity), (uint32_t, id), (float, health))
+IMPLEMENT_SOA(bench_motion, (vector2, position), (vector2, velocity), (float, rotation), (float, angular_velocity), (uint32_t, id), (float, health))
+
+#define BENCH_SOA_COUNT 100000
+
+typedef struct {
+    bench_motion soa;
+    bench_motion_element* aos; // the same rows, as an array of structs
+} soa_bench;
+
+static void bench_soa_integrate(void* context, uint64_t iterations) {
+    soa_bench* bench = (soa_bench*)context;
+    bench_motion* soa = &bench->soa;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        for (uint32_t j = 0; j < soa->count; ++j) {
+            soa->position[j] = vector2_add(soa->position[j], vector2_scale(soa->velocity[j], 0.016f));
+        }
+        BENCH_DO_NOT_OPTIMIZE(soa->position[0]);
+    }
+}
+
+static void bench_aos_integrate(void* context, uint64_t iterations) {
+    soa_bench* bench = (soa_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        for (uint32_t j = 0; j < BENCH_SOA_COUNT; ++j) {
+            bench->aos[j].position = vector2_add(bench->aos[j].position, vector2_scale(bench->aos[j].velocity, 0.016f));
+        }
+        BENCH_DO_NOT_OPTIMIZE(bench->aos[0].position);
+    }
+}
+
+static void check_soa(bump_allocator* arena) {
+    // Sanity check: columns are aligned and padded, rows keep all their fields through growth and swap removal, and rows past the
+    // count are zero.
+    reset_bump_allocator(arena);
+    bench_motion soa = { 0 };
+    for (uint32_t i = 0; i < 1000; ++i) {
+        bench_motion_append(&soa, arena, (bench_motion_element){ .position = { (float)i, 0.0f }, .id = i, .health = (float)i * 2.0f });
+    }
+    BENCH_CHECK((uintptr_t)soa.position % SOA_COLUMN_ALIGNMENT == 0 && (uintptr_t)soa.health % SOA_COLUMN_ALIGNMENT == 0
+        && soa.capacity % SOA_CAPACITY_GRANULARITY == 0 && soa.capacity >= 1000, , "Struct of arrays columns are not aligned and padded");
+
+    bench_motion_remove_swap(&soa, 10);
+    bench_motion_remove_swap(&soa, soa.count - 1);
+    bench_motion_element element = { 0 };
+    bench_motion_get(&soa, 10, &element);
+    BENCH_CHECK(soa.count == 998 && element.id == 999 && element.position.x == 999.0f && element.health == 1998.0f && soa.id[997] == 997, ,
+        "Struct of arrays swap removal did not move the whole row");
+    BENCH_CHECK(soa.id[998] == 0 && soa.id[999] == 0 && soa.position[998].x == 0.0f && soa.health[999] == 0.0f, ,
+        "Struct of arrays removal left stale rows past the count");
+
+    bench_motion_clear(&soa);
+    bool is_zeroed = true;
+    for (uint32_t i = 0; i < soa.capacity; ++i) {
+        is_zeroed = is_zeroed && soa.id[i] == 0 && soa.position[i].x == 0.0f && soa.health[i] == 0.0f;
+    }
+    BENCH_CHECK(soa.count == 0 && is_zeroed, , "Struct of arrays clear left stale rows past the count");
+    reset_bump_allocator(arena);
+}
+
+static void run_soa_benches(bump_allocator* arena) {
+    check_soa(arena);
+
+    reset_bump_allocator(arena);
+    soa_bench bench = { 0 };
+    bench.aos = (bench_motion_element*)bump_allocate(arena, alignof(bench_motion_element), sizeof(bench_motion_element) * BENCH_SOA_COUNT);
+    BENCH_CHECK(bench.aos != NULL && bench_motion_reserve(&bench.soa, arena, BENCH_SOA_COUNT) == RESULT_SUCCESS, return, "Failed to allocate struct of arrays benchmark rows");
+    for (uint32_t i = 0; i < BENCH_SOA_COUNT; ++i) {
+        bench_motion_element element = { .position = { (float)i, (float)i }, .velocity = { 1.0f, -1.0f }, .id = i, .health = 100.0f };
+        bench.aos[i] = element;
+        bench_motion_append(&bench.soa, arena, element);
+    }
+
+    run_bench("soa/integrate_positions_" TOSTRING(BENCH_SOA_COUNT), bench_soa_integrate, &bench, (sizeof(vector2) * 2) * BENCH_SOA_COUNT);
+    run_bench("aos/integrate_positions_" TOSTRING(BENCH_SOA_COUNT), bench_aos_integrate, &bench, (sizeof(vector2) * 2) * BENCH_SOA_COUNT);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Bitsets
+=============================================================================================================================
+*/
+
+#define BENCH_BITSET_BITS 4096
+
+DECLARE_BITSET(bench_bits, BENCH_BITSET_BITS)
+DECLARE_BITSET(bench_small_bitset, 100)
+
+typedef struct {
+    bench_bits bits;
+    bool flags[BENCH_BITSET_BITS]; // the same set, as an array of flags
+} bitset_bench;
+
+static void bench_bitset_iterate(void* context, uint64_t iterations) {
+    bitset_bench* bench = (bitset_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        uint32_t sum = 0;
+        for (uint32_t bit = bench_bits_next(&bench->bits, 0); bit < BENCH_BITSET_BITS; bit = bench_bits_next(&bench->bits, bit + 1)) {
+            sum += bit;
+        }
+        BENCH_DO_NOT_OPTIMIZE(sum);
+    }
+}
+
+static void bench_flags_iterate(void* context, uint64_t iterations) {
+    bitset_bench* bench = (bitset_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        uint32_t sum = 0;
+        for (uint32_t j = 0; j < BENCH_BITSET_BITS; ++j) {
+            if (bench->flags[j]) {
+                sum += j;
+            }
+        }
+        BENCH_DO_NOT_OPTIMIZE(sum);
+    }
+}
+
+static void bench_bitset_count(void* context, uint64_t iterations) {
+    bitset_bench* bench = (bitset_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        uint32_t count = bench_bits_count(&bench->bits);
+        BENCH_DO_NOT_OPTIMIZE(count);
+    }
+}
+
+static void bench_flags_count(void* context, uint64_t iterations) {
+    bitset_bench* bench = (bitset_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        uint32_t count = 0;
+        for (uint32_t j = 0; j < BENCH_BITSET_BITS; ++j) {
+            count += bench->flags[j];
+        }
+        BENCH_DO_NOT_OPTIMIZE(count);
+    }
+}
+
+static void check_bitsets(void) {
+    // Sanity check: ranges across word boundaries, iteration in order, counting, and whole-set operations.
+    bench_small_bitset set = { 0 };
+    BENCH_CHECK(!bench_small_bitset_any(&set) && bench_small_bitset_next(&set, 0) == 100, , "Empty bitset has bits set");
+    bench_small_bitset_set_range(&set, 60, 70);
+    bench_small_bitset_set(&set, 99);
+    bench_small_bitset_assign(&set, 3, true);
+    bench_small_bitset_assign(&set, 65, false);
+    BENCH_CHECK(bench_small_bitset_count(&set) == 11 && bench_small_bitset_test(&set, 3) && !bench_small_bitset_test(&set, 65) && bench_small_bitset_test(&set, 69)
+        && !bench_small_bitset_test(&set, 70), , "Bitset range or assign set the wrong bits (%u set)", bench_small_bitset_count(&set));
+
+    uint32_t expected[] = { 3, 60, 61, 62, 63, 64, 66, 67, 68, 69, 99 };
+    uint32_t visited = 0;
+    for (uint32_t bit = bench_small_bitset_next(&set, 0); bit < 100; bit = bench_small_bitset_next(&set, bit + 1)) {
+        BENCH_CHECK(visited < ARRAY_LENGTH(expected) && bit == expected[visited], break, "Bitset iteration visited bit %u", bit);
+        ++visited;
+    }
+    BENCH_CHECK(visited == ARRAY_LENGTH(expected), , "Bitset iteration visited %u of %u bits", visited, (uint32_t)ARRAY_LENGTH(expected));
+
+    bench_small_bitset all = { 0 };
+    bench_small_bitset_set_all(&all);
+    BENCH_CHECK(bench_small_bitset_count(&all) == 100 && all.words[1] == 0xFFFFFFFFFull, , "Bitset set_all set bits past the bit count");
+    bench_small_bitset_clear_range(&all, 1, 99);
+    BENCH_CHECK(bench_small_bitset_count(&all) == 2 && bench_small_bitset_next(&all, 1) == 99, , "Bitset clear_range cleared the wrong bits");
+
+    bench_small_bitset layers = { 0 };
+    bench_small_bitset_set(&layers, 64);
+    bench_small_bitset_set(&layers, 66);
+    bench_small_bitset both = { 0 };
+    bench_small_bitset_and(&both, &set, &layers);
+    bench_small_bitset_and_not(&layers, &layers, &set);
+    bench_small_bitset_or(&all, &all, &both);
+    BENCH_CHECK(bench_small_bitset_count(&both) == 2 && bench_small_bitset_includes(&set, &both) && bench_small_bitset_intersects(&all, &set)
+        && !bench_small_bitset_any(&layers) && bench_small_bitset_count(&all) == 4 && !bench_small_bitset_includes(&both, &set), ,
+        "Bitset and, or, and_not, includes or intersects gave the wrong answer");
+}
+
+static void run_bitset_benches(bump_allocator* arena) {
+    check_bitsets();
+
+    reset_bump_allocator(arena);
+    bitset_bench* bench = (bitset_bench*)bump_allocate(arena, alignof(bitset_bench), sizeof(bitset_bench));
+    if (bench == NULL) {
+        BUG("Failed to allocate bitset benchmark data.");
+        return;
+    }
+    memset(bench, 0, sizeof(bitset_bench));
+    // About one in 32 bits set, like the few active voices or colliding layers out of many.
+    uint32_t random_state = 0x9E3779B9u;
+    for (uint32_t i = 0; i < BENCH_BITSET_BITS; ++i) {
+        random_state ^= random_state << 13;
+        random_state ^= random_state >> 17;
+        random_state ^= random_state << 5;
+        bool is_set = (random_state & 31) == 0;
+        bench->flags[i] = is_set;
+        bench_bits_assign(&bench->bits, i, is_set);
+    }
+
+    run_bench("bitset/iterate_sparse_" TOSTRING(BENCH_BITSET_BITS), bench_bitset_iterate, bench, 0);
+    run_bench("flags/iterate_sparse_" TOSTRING(BENCH_BITSET_BITS), bench_flags_iterate, bench, 0);
+    run_bench("bitset/count_" TOSTRING(BENCH_BITSET_BITS), bench_bitset_count, bench, 0);
+    run_bench("flags/count_" TOSTRING(BENCH_BITSET_BITS), bench_flags_count, bench, 0);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Geometry
+=============================================================================================================================
+*/
+
+#define BENCH_GEOMETRY_INPUTS 256
+
+typedef struct {
+    vector2 vectors2[BENCH_GEOMETRY_INPUTS];
+    vector3 vectors3[BENCH_GEOMETRY_INPUTS];
+    matrix matrices[BENCH_GEOMETRY_INPUTS];
+    float angles[BENCH_GEOMETRY_INPUTS];
+} geometry_inputs;
+
+static void bench_vector2_normalize(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        vector2 result = vector2_normalize(inputs->vectors2[i % BENCH_GEOMETRY_INPUTS]);
+        BENCH_DO_NOT_OPTIMIZE(result);
+    }
+}
+
+static void bench_vector2_rotate(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        vector2 result = vector2_rotate(inputs->vectors2[i % BENCH_GEOMETRY_INPUTS], inputs->angles[i % BENCH_GEOMETRY_INPUTS]);
+        BENCH_DO_NOT_OPTIMIZE(result);
+    }
+}
+
+static void bench_vector3_cross_normalize(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        vector3 a = inputs->vectors3[i % BENCH_GEOMETRY_INPUTS];
+        vector3 b = inputs->vectors3[(i + 1) % BENCH_GEOMETRY_INPUTS];
+        vector3 result = vector3_normalize(vector3_cross(a, b));
+        BENCH_DO_NOT_OPTIMIZE(result);
+    }
+}
+
+static void bench_circle_overlaps_circle(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        circle a = { inputs->vectors2[i % BENCH_GEOMETRY_INPUTS], 32.0f };
+        circle b = { inputs->vectors2[(i + 7) % BENCH_GEOMETRY_INPUTS], 32.0f };
+        bool overlaps = circle_overlaps_circle(a, b);
+        BENCH_DO_NOT_OPTIMIZE(overlaps);
+    }
+}
+
+static void bench_matrix_multiply(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        matrix result = matrix_multiply(inputs->matrices[i % BENCH_GEOMETRY_INPUTS], inputs->matrices[(i + 1) % BENCH_GEOMETRY_INPUTS]);
+        BENCH_DO_NOT_OPTIMIZE(result);
+    }
+}
+
+static void bench_matrix_transpose(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        matrix result = matrix_transpose(inputs->matrices[i % BENCH_GEOMETRY_INPUTS]);
+        BENCH_DO_NOT_OPTIMIZE(result);
+    }
+}
+
+static void bench_view_matrix(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        vector3 eye = inputs->vectors3[i % BENCH_GEOMETRY_INPUTS];
+        matrix result = view_matrix(eye, (vector3) { 0.0f, 0.0f, 0.0f }, (vector3) { 0.0f, 1.0f, 0.0f });
+        BENCH_DO_NOT_OPTIMIZE(result);
+    }
+}
+
+static void bench_orthographic_matrix(void* context, uint64_t iterations) {
+    geometry_inputs* inputs = (geometry_inputs*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        vector2 size = inputs->vectors2[i % BENCH_GEOMETRY_INPUTS];
+        matrix result = orthographic_matrix(0.0f, size.x + 1.0f, size.y + 1.0f, 0.0f, -1.0f, 1.0f);
+        BENCH_DO_NOT_OPTIMIZE(result);
+    }
+}
+
+static void run_geometry_benches(bump_allocator* arena) {
+    geometry_inputs* inputs = (geometry_inputs*)bump_allocate(arena, alignof(geometry_inputs), sizeof(geometry_inputs));
+    BENCH_CHECK(inputs != NULL, return, "Failed to allocate geometry benchmark inputs");
+
+    srand(1);
+    for (uint32_t i = 0; i < BENCH_GEOMETRY_INPUTS; ++i) {
+        float x = (float)(rand() % 2048) - 1024.0f;
+        float y = (float)(rand() % 2048) - 1024.0f;
+        float z = (float)(rand() % 2048) - 1024.0f;
+        inputs->vectors2[i] = (vector2){ x, y };
+        inputs->vectors3[i] = (vector3){ x, y, z + 2048.0f };
+        inputs->angles[i] = (float)(rand() % 360) * (M_PI / 180.0f);
+        inputs->matrices[i] = matrix_multiply(rotation_z_matrix(inputs->angles[i]), translation_matrix(x, y, z));
+    }
+
+    run_bench("geometry/vector2_normalize", bench_vector2_normalize, inputs, 0);
+    run_bench("geometry/vector2_rotate", bench_vector2_rotate, inputs, 0);
+    run_bench("geometry/vector3_cross_normalize", bench_vector3_cross_normalize, inputs, 0);
+    run_bench("geometry/circle_overlaps_circle", bench_circle_overlaps_circle, inputs, 0);
+    run_bench("geometry/matrix_multiply", bench_matrix_multiply, inputs, 0);
+    run_bench("geometry/matrix_transpose", bench_matrix_transpose, inputs, 0);
+    run_bench("geometry/view_matrix", bench_view_matrix, inputs, 0);
+    run_bench("geometry/orthographic_matrix", bench_orthographic_matrix, inputs, 0);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Strings
+=============================================================================================================================
+*/
+
+static void bench_concat(void* context, uint64_t iterations) {
+    bump_allocator* arena = (bump_allocator*)context;
+    string a = CSTR("assets/sounds/0_asteroid_explosion");
+    string b = CSTR(".wav");
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (arena->used_bytes > BENCH_ARENA_RESET_BYTES) {
+            reset_bump_allocator(arena);
+        }
+        string combined = concat(a, b, arena);
+        BENCH_DO_NOT_OPTIMIZE(combined);
+    }
+}
+
+static void bench_append_last_string(void* context, uint64_t iterations) {
+    bump_allocator* arena = (bump_allocator*)context;
+    string suffix = CSTR("/segment");
+    reset_bump_allocator(arena);
+    string path = concat((string)CSTR("root"), (string)CSTR(""), arena);
+    --arena->used_bytes; // drop the null terminator so the string is the last allocation
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (arena->used_bytes > BENCH_ARENA_RESET_BYTES) {
+            reset_bump_allocator(arena);
+            path = concat((string)CSTR("root"), (string)CSTR(""), arena);
+            --arena->used_bytes;
+        }
+        append_last_string(&path, suffix, arena);
+    }
+    BENCH_DO_NOT_OPTIMIZE(path);
+}
+
+static void run_string_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    run_bench("string/concat_34_plus_4", bench_concat, arena, 0);
+    run_bench("string/append_last_string_8", bench_append_last_string, arena, 8);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    WAV files
+=============================================================================================================================
+*/
+
+typedef struct {
+    bump_allocator* arena;
+    string path;
+} file_bench;
+
+static void bench_read_wav_file(void* context, uint64_t iterations) {
+    file_bench* bench = (file_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        reset_bump_allocator(bench->arena);
+        sound loaded_sound;
+        result read_result = read_wav_file(bench->path, bench->arena, &loaded_sound);
+        BENCH_DO_NOT_OPTIMIZE(read_result);
+    }
+}
+
+// Writes one second of a silent stereo 16 bit WAV file (the engine's default audio format) to benchmark against.
+static result write_bench_wav_file(string path, bump_allocator* arena, size_t* out_file_size) {
+    const uint32_t data_size = AUDIO_SAMPLE_RATE * AUDIO_CHANNELS * (AUDIO_BITS_PER_SAMPLE / 8);
+    const uint32_t file_size = 44 + data_size;
+    uint8_t* file = (uint8_t*)bump_allocate(arena, 4, file_size);
+    BENCH_CHECK(file != NULL, return RESULT_FAILURE, "Failed to allocate benchmark WAV file");
+    memset(file, 0, file_size);
+
+    sound_format format = {
+        .audio_format = 1, // PCM
+        .num_channels = AUDIO_CHANNELS,
+        .sample_rate = AUDIO_SAMPLE_RATE,
+        .byte_rate = AUDIO_SAMPLE_RATE * AUDIO_CHANNELS * (AUDIO_BITS_PER_SAMPLE / 8),
+        .block_align = AUDIO_CHANNELS * (AUDIO_BITS_PER_SAMPLE / 8),
+        .bits_per_sample = AUDIO_BITS_PER_SAMPLE,
+    };
+    uint32_t riff_size = file_size - 8;
+    uint32_t fmt_size = sizeof(sound_format);
+
+    memcpy(file + 0, "RIFF", 4);
+    memcpy(file + 4, &riff_size, 4);
+    memcpy(file + 8, "WAVE", 4);
+    memcpy(file + 12, "fmt ", 4);
+    memcpy(file + 16, &fmt_size, 4);
+    memcpy(file + 20, &format, sizeof(sound_format));
+    memcpy(file + 36, "data", 4);
+    memcpy(file + 40, &data_size, 4);
+
+    *out_file_size = file_size;
+    return write_entire_file(path, file, file_size);
+}
+
+static void run_file_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    string directory = get_executable_directory(arena);
+    string path = concat(directory, (string)CSTR("bench_sound.wav"), arena);
+
+    // The path lives at the start of the arena, so reads are made from a second arena.
+    bump_allocator file_arena;
+    if (create_bump_allocator(&file_arena, 64 * 1024 * 1024) != RESULT_SUCCESS) {
+        return;
+    }
+
+    size_t file_size = 0;
+    if (write_bench_wav_file(path, &file_arena, &file_size) == RESULT_SUCCESS) {
+        file_bench bench = { .arena = &file_arena, .path = path };
+        run_bench("asset_files/read_wav_file_1s_stereo", bench_read_wav_file, &bench, file_size);
+        remove(path.text);
+    }
+
+    destroy_bump_allocator(&file_arena);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Sprite instance generation
+=============================================================================================================================
+*/
+
+static void bench_draw_sprite(void* context, uint64_t iterations) {
+    graphics* headless_graphics = (graphics*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        if (get_headless_sprite_instances(headless_graphics).count >= MAX_SPRITES) {
+            begin_headless_frame(headless_graphics);
+        }
+        float offset = (float)(i & 511);
+        draw_sprite(headless_graphics, (vector2) { offset, 1024.0f - offset }, (vector2) { 64.0f, 64.0f }, (vector2int) { 64, 192 }, (vector2int) { 64, 64 }, offset * 0.01f);
+    }
+    sprite_instances instances = get_headless_sprite_instances(headless_graphics);
+    BENCH_DO_NOT_OPTIMIZE(instances);
+}
+
+static void run_graphics_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    graphics* headless_graphics = create_headless_graphics(arena, (vector2int) { 1024, 1024 }, (vector2int) { 512, 512 });
+    if (headless_graphics == NULL) {
+        return;
+    }
+
+    run_bench("graphics/draw_sprite", bench_draw_sprite, headless_graphics, sizeof(sprite_instance));
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Profiler
+=============================================================================================================================
+*/
+
+#ifdef ENABLE_PROFILER
+static void bench_profile_scope(void* context, uint64_t iterations) {
+    (void)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        PROFILE_SCOPE("bench_scope") {
+            BENCH_DO_NOT_OPTIMIZE(i);
+        }
+    }
+}
+
+static void bench_export_profiler_trace(void* context, uint64_t iterations) {
+    file_bench* bench = (file_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        reset_bump_allocator(bench->arena);
+        result export_result = export_profiler_trace(bench->path, bench->arena);
+        BENCH_DO_NOT_OPTIMIZE(export_result);
+    }
+}
+
+static void run_profiler_benches(bump_allocator* arena) {
+    run_bench("profiler/scope", bench_profile_scope, NULL, 0);
+
+    // The scope benchmark above has filled this thread's ring buffer, so this exports a full buffer.
+    reset_bump_allocator(arena);
+    string path = concat(get_executable_directory(arena), (string)CSTR("bench_trace.json"), arena);
+    bump_allocator text_arena;
+    if (create_bump_allocator(&text_arena, 64 * 1024 * 1024) != RESULT_SUCCESS) {
+        return;
+    }
+
+    file_bench bench = { .arena = &text_arena, .path = path };
+    run_bench("profiler/export_trace_" TOSTRING(PROFILER_EVENTS_PER_THREAD) "_events", bench_export_profiler_trace, &bench, 0);
+    remove(path.text);
+    destroy_bump_allocator(&text_arena);
+    reset_bump_allocator(arena);
+}
+#endif
+
+/*
+=============================================================================================================================
+    Time
+=============================================================================================================================
+*/
+
+static void bench_read_timestamp(void* context, uint64_t iterations) {
+    (void)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        uint64_t timestamp = read_timestamp();
+        BENCH_DO_NOT_OPTIMIZE(timestamp);
+    }
+}
+
+static void bench_update_clock(void* context, uint64_t iterations) {
+    clock* bench_clock = (clock*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        update_clock(bench_clock);
+    }
+    BENCH_DO_NOT_OPTIMIZE(bench_clock->time_since_previous_update);
+}
+
+static void run_time_benches(void) {
+    // Sanity check: conversions stay exact after days of uptime (where a float of seconds would be off by milliseconds).
+    const uint64_t ten_days_nanoseconds = 10ull * 24 * 60 * 60 * 1000000000ull + 1;
+    uint64_t ten_days_ticks = (ten_days_nanoseconds / 1000000000ull) * get_timestamp_frequency() + get_timestamp_frequency() / 1000000000ull;
+    BENCH_CHECK(timestamp_to_nanoseconds(ten_days_ticks) / 1000 == ten_days_nanoseconds / 1000, , "Timestamp conversion lost precision after ten days");
+
+    clock bench_clock;
+    if (create_clock(&bench_clock) != RESULT_SUCCESS) {
+        return;
+    }
+
+    run_bench("time/read_timestamp", bench_read_timestamp, NULL, 0);
+    run_bench("time/update_clock", bench_update_clock, &bench_clock, 0);
+}
+
+/*
+=============================================================================================================================
+    Frame statistics
+=============================================================================================================================
+*/
+
+static void bench_record_frame_statistics(void* context, uint64_t iterations) {
+    frame_statistics* statistics = (frame_statistics*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        float jitter = (float)(i & 15) * 0.25f;
+        record_frame_statistics(statistics, 16.0f + jitter, 4.0f + jitter, 2.0f + jitter);
+    }
+}
+
+static void bench_summarize_frame_statistics(void* context, uint64_t iterations) {
+    frame_statistics* statistics = (frame_statistics*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        frame_metric_summary summary = summarize_frame_metric(statistics, FRAME_METRIC_FRAME);
+        BENCH_DO_NOT_OPTIMIZE(summary);
+    }
+}
+
+static void run_frame_statistics_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    frame_statistics statistics;
+    if (create_frame_statistics(&statistics, arena, FRAME_STATISTICS_WINDOW_FRAMES, 20.0f) != RESULT_SUCCESS) {
+        return;
+    }
+
+    // Sanity check: a window of 1..100 ms has p50 of 50 ms, p99 of 99 ms and 80 hitches above 20 ms.
+    for (uint32_t i = 1; i <= 100; ++i) {
+        record_frame_statistics(&statistics, (float)i, 0.0f, 0.0f);
+    }
+    frame_metric_summary summary = summarize_frame_metric(&statistics, FRAME_METRIC_FRAME);
+    BENCH_CHECK(summary.p50 > 49.9f && summary.p50 < 50.1f && summary.p99 > 98.9f && summary.p99 < 99.1f && summary.max == 100.0f && summary.hitches == 80,
+        , "Unexpected frame statistics summary: p50 %f, p99 %f, max %f, hitches %u", summary.p50, summary.p99, summary.max, summary.hitches);
+
+    run_bench("frame_statistics/record", bench_record_frame_statistics, &statistics, 0);
+    run_bench("frame_statistics/summarize_" TOSTRING(FRAME_STATISTICS_WINDOW_FRAMES) "_frames", bench_summarize_frame_statistics, &statistics, 0);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Jobs
+=============================================================================================================================
+*/
+
+#define BENCH_JOB_COUNT 64
+#define BENCH_JOB_SUM_VALUES (1u << 20)
+
+typedef struct {
+    job_system* system;
+    const float* values;
+    uint32_t count;
+    float sum;
+} bench_sum_job;
+
+#define BENCH_JOB_SCRATCH_FLOATS 256
+
+typedef struct {
+    job_system* system;
+    uint32_t seed;
+    scratch_result result;
+} bench_scratch_job;
+
+typedef struct {
+    job_system* system;
+    job jobs[BENCH_JOB_COUNT];
+    bench_sum_job sums[BENCH_JOB_COUNT];
+    bench_scratch_job scratch_jobs[BENCH_JOB_COUNT];
+    float* values;
+} jobs_bench;
+
+static void empty_job(void* data) {
+    (void)data;
+}
+
+static void sum_job(void* data) {
+    bench_sum_job* sum = (bench_sum_job*)data;
+    float total = 0.0f;
+    for (uint32_t i = 0; i < sum->count; ++i) {
+        total += sum->values[i];
+    }
+    sum->sum = total;
+}
+
+// Splits its range in two until it is small, so the check also covers jobs that submit and wait on jobs from worker threads.
+static void split_sum_job(void* data) {
+    bench_sum_job* sum = (bench_sum_job*)data;
+    if (sum->count <= 1024) {
+        sum_job(sum);
+        return;
+    }
+
+    uint32_t half = sum->count / 2;
+    bench_sum_job halves[2] = {
+        { .system = sum->system, .values = sum->values, .count = half },
+        { .system = sum->system, .values = sum->values + half, .count = sum->count - half },
+    };
+    job jobs[2] = { { .function = split_sum_job, .data = &halves[0] }, { .function = split_sum_job, .data = &halves[1] } };
+    job_counter counter = { 0 };
+    run_jobs(sum->system, jobs, 2, &counter);
+    wait_for_counter(sum->system, &counter);
+    sum->sum = halves[0].sum + halves[1].sum;
+}
+
+static unsigned long split_sum_outside_job_system(void* arg) {
+    split_sum_job(arg);
+    return 0;
+}
+
+// Builds its output in the thread's scratch arena and hands it back to the waiting thread.
+static void scratch_job(void* data) {
+    bench_scratch_job* scratch = (bench_scratch_job*)data;
+    float* output = (float*)job_scratch_allocate(scratch->system, alignof(float), sizeof(float) * BENCH_JOB_SCRATCH_FLOATS);
+    if (output == NULL) {
+        scratch->result = (scratch_result){ 0 };
+        return;
+    }
+    for (uint32_t i = 0; i < BENCH_JOB_SCRATCH_FLOATS; ++i) {
+        output[i] = (float)(scratch->seed + i);
+    }
+    scratch->result = make_scratch_result(scratch->system, output, sizeof(float) * BENCH_JOB_SCRATCH_FLOATS);
+}
+
+static void mark_range(void* context, uint32_t begin, uint32_t end) {
+    uint8_t* marks = (uint8_t*)context;
+    for (uint32_t i = begin; i < end; ++i) {
+        ++marks[i];
+    }
+}
+
+static void scale_range(void* context, uint32_t begin, uint32_t end) {
+    float* values = (float*)context;
+    for (uint32_t i = begin; i < end; ++i) {
+        values[i] = values[i] * 0.5f + 1.0f;
+    }
+}
+
+static void bench_parallel_for_scale(void* context, uint64_t iterations) {
+    jobs_bench* bench = (jobs_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        parallel_for(bench->system, bench->values, BENCH_JOB_SUM_VALUES, sizeof(float), 4096, scale_range, bench->values);
+    }
+}
+
+static void bench_run_empty_jobs(void* context, uint64_t iterations) {
+    jobs_bench* bench = (jobs_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        job_counter counter = { 0 };
+        run_jobs(bench->system, bench->jobs, BENCH_JOB_COUNT, &counter);
+        wait_for_counter(bench->system, &counter);
+    }
+}
+
+static void bench_scratch_results(void* context, uint64_t iterations) {
+    jobs_bench* bench = (jobs_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        reset_job_scratch_arenas(bench->system);
+        job_counter counter = { 0 };
+        run_jobs(bench->system, bench->jobs, BENCH_JOB_COUNT, &counter);
+        wait_for_counter(bench->system, &counter);
+        for (uint32_t j = 0; j < BENCH_JOB_COUNT; ++j) {
+            const float* output = (const float*)get_scratch_result(bench->system, bench->scratch_jobs[j].result);
+            BENCH_DO_NOT_OPTIMIZE(output);
+        }
+    }
+}
+
+static void bench_parallel_sum(void* context, uint64_t iterations) {
+    jobs_bench* bench = (jobs_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        job_counter counter = { 0 };
+        run_jobs(bench->system, bench->jobs, BENCH_JOB_COUNT, &counter);
+        wait_for_counter(bench->system, &counter);
+        BENCH_DO_NOT_OPTIMIZE(bench->sums[0].sum);
+    }
+}
+
+static void run_job_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    jobs_bench* bench = (jobs_bench*)bump_allocate(arena, alignof(jobs_bench), sizeof(jobs_bench));
+    job_system* system = (job_system*)bump_allocate(arena, alignof(job_system), sizeof(job_system));
+    float* values = (float*)bump_allocate(arena, alignof(float), sizeof(float) * BENCH_JOB_SUM_VALUES);
+    if (bench == NULL || system == NULL || values == NULL) {
+        BUG("Failed to allocate job benchmark data.");
+        return;
+    }
+
+    for (uint32_t i = 0; i < BENCH_JOB_SUM_VALUES; ++i) {
+        values[i] = (float)(i & 7);
+    }
+    const float expected_sum = 3.5f * (float)BENCH_JOB_SUM_VALUES;
+
+    // Sanity check: nested jobs on several threads add up the whole array, even on machines with fewer cores.
+    if (create_job_system(system, 4, arena) != RESULT_SUCCESS) {
+        return;
+    }
+    bench_sum_job root = { .system = system, .values = values, .count = BENCH_JOB_SUM_VALUES };
+    split_sum_job(&root);
+    BENCH_CHECK(root.sum == expected_sum, , "Nested job sum is %f, expected %f", root.sum, expected_sum);
+
+    // Sanity check: the same sum submitted from a thread outside the job system goes through the shared queue and adds up too.
+    bench_sum_job outside_root = { .system = system, .values = values, .count = BENCH_JOB_SUM_VALUES };
+    thread outsider;
+    if (create_thread(&outsider, split_sum_outside_job_system, &outside_root) != RESULT_SUCCESS) {
+        return;
+    }
+    join_thread(&outsider);
+    destroy_thread(&outsider);
+    BENCH_CHECK(outside_root.sum == expected_sum, , "Job sum submitted from outside the job system is %f, expected %f", outside_root.sum, expected_sum);
+
+    // Sanity check: parallel_for visits every index exactly once, whatever the count and the alignment of the elements.
+    uint8_t* marks = (uint8_t*)values;
+    const uint32_t counts[] = { 1, 63, 64, 65, 1000, 4097, 100003 };
+    for (uint32_t c = 0; c < ARRAY_LENGTH(counts); ++c) {
+        for (uint32_t offset = 0; offset < 4; ++offset) {
+            memset(marks, 0, counts[c] + offset);
+            parallel_for(system, marks + offset, counts[c], sizeof(uint8_t), 1, mark_range, marks + offset);
+            for (uint32_t i = 0; i < counts[c]; ++i) {
+                BENCH_CHECK(marks[offset + i] == 1, break, "parallel_for visited index %u of %u %u times", i, counts[c], marks[offset + i]);
+            }
+        }
+    }
+    for (uint32_t i = 0; i < BENCH_JOB_SUM_VALUES; ++i) {
+        values[i] = (float)(i & 7);
+    }
+
+    // Sanity check: results built in the workers' scratch arenas reach the main thread intact, survive being copied out,
+    // and belong to the old frame once the arenas are reset.
+    for (uint32_t i = 0; i < BENCH_JOB_COUNT; ++i) {
+        bench->scratch_jobs[i] = (bench_scratch_job){ .system = system, .seed = i * BENCH_JOB_SCRATCH_FLOATS };
+        bench->jobs[i] = (job){ .function = scratch_job, .data = &bench->scratch_jobs[i] };
+    }
+    job_counter scratch_counter = { 0 };
+    run_jobs(system, bench->jobs, BENCH_JOB_COUNT, &scratch_counter);
+    wait_for_counter(system, &scratch_counter);
+    const float* kept = (const float*)copy_scratch_result(system, bench->scratch_jobs[1].result, arena);
+    for (uint32_t i = 0; i < BENCH_JOB_COUNT; ++i) {
+        const float* output = (const float*)get_scratch_result(system, bench->scratch_jobs[i].result);
+        BENCH_CHECK(output != NULL && output[BENCH_JOB_SCRATCH_FLOATS - 1] == (float)((i + 1) * BENCH_JOB_SCRATCH_FLOATS - 1), break,
+            "Scratch result %u was not handed back intact", i);
+    }
+    reset_job_scratch_arenas(system);
+    BENCH_CHECK(bench->scratch_jobs[0].result.frame != system->scratch_frame, , "Scratch result is still current after a reset");
+    BENCH_CHECK(kept != NULL && kept[0] == (float)BENCH_JOB_SCRATCH_FLOATS, , "Copied scratch result did not survive the reset");
+    destroy_job_system(system);
+
+    if (create_job_system(system, 0, arena) != RESULT_SUCCESS) {
+        return;
+    }
+    bench->system = system;
+    bench->values = values;
+
+    for (uint32_t i = 0; i < BENCH_JOB_COUNT; ++i) {
+        bench->jobs[i] = (job){ .function = empty_job };
+    }
+    run_bench("jobs/run_and_wait_" TOSTRING(BENCH_JOB_COUNT) "_empty_jobs", bench_run_empty_jobs, bench, 0);
+
+    for (uint32_t i = 0; i < BENCH_JOB_COUNT; ++i) {
+        bench->scratch_jobs[i] = (bench_scratch_job){ .system = system, .seed = i };
+        bench->jobs[i] = (job){ .function = scratch_job, .data = &bench->scratch_jobs[i] };
+    }
+    run_bench("jobs/scratch_results_" TOSTRING(BENCH_JOB_COUNT) "_jobs", bench_scratch_results, bench, sizeof(float) * BENCH_JOB_SCRATCH_FLOATS * BENCH_JOB_COUNT);
+
+    const uint32_t chunk = BENCH_JOB_SUM_VALUES / BENCH_JOB_COUNT;
+    for (uint32_t i = 0; i < BENCH_JOB_COUNT; ++i) {
+        bench->sums[i] = (bench_sum_job){ .system = system, .values = values + i * chunk, .count = chunk };
+        bench->jobs[i] = (job){ .function = sum_job, .data = &bench->sums[i] };
+    }
+    // Sanity check: the chunks add up to the whole array.
+    bench_parallel_sum(bench, 1);
+    float sum = 0.0f;
+    for (uint32_t i = 0; i < BENCH_JOB_COUNT; ++i) {
+        sum += bench->sums[i].sum;
+    }
+    BENCH_CHECK(sum == expected_sum, , "Parallel sum is %f, expected %f", sum, expected_sum);
+    run_bench("jobs/parallel_sum_1M_floats_in_" TOSTRING(BENCH_JOB_COUNT) "_jobs", bench_parallel_sum, bench, sizeof(float) * BENCH_JOB_SUM_VALUES);
+    run_bench("jobs/parallel_for_scale_1M_floats", bench_parallel_for_scale, bench, sizeof(float) * BENCH_JOB_SUM_VALUES);
+
+    destroy_job_system(system);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Synchronization
+=============================================================================================================================
+*/
+
+#define BENCH_SYNC_THREADS 4
+#define BENCH_SYNC_INCREMENTS 100000
+
+typedef struct {
+    spinlock spinlock;
+    mutex mutex;
+    rwlock rwlock;
+    semaphore semaphore;
+    atomic_uint64 atomic_counter;
+    uint64_t spinlock_counter;
+    uint64_t rwlock_counter;
+    atomic_uint32 semaphore_acquired;
+} sync_bench;
+
+static unsigned long contend_sync_primitives(void* arg) {
+    sync_bench* bench = (sync_bench*)arg;
+    for (uint32_t i = 0; i < BENCH_SYNC_INCREMENTS; ++i) {
+        atomic_fetch_add_uint64(&bench->atomic_counter, 1, MEMORY_ORDER_RELAXED);
+
+        lock_spinlock(&bench->spinlock);
+        ++bench->spinlock_counter;
+        unlock_spinlock(&bench->spinlock);
+
+        lock_rwlock_exclusive(&bench->rwlock);
+        ++bench->rwlock_counter;
+        unlock_rwlock_exclusive(&bench->rwlock);
+    }
+
+    // Each thread takes one count from the semaphore, which only the main thread signals.
+    wait_semaphore(&bench->semaphore);
+    atomic_fetch_add_uint32(&bench->semaphore_acquired, 1, MEMORY_ORDER_RELEASE);
+    return 0;
+}
+
+static void bench_atomic_fetch_add(void* context, uint64_t iterations) {
+    sync_bench* bench = (sync_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        atomic_fetch_add_uint64(&bench->atomic_counter, 1, MEMORY_ORDER_SEQ_CST);
+    }
+}
+
+static void bench_spinlock(void* context, uint64_t iterations) {
+    sync_bench* bench = (sync_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        lock_spinlock(&bench->spinlock);
+        ++bench->spinlock_counter;
+        unlock_spinlock(&bench->spinlock);
+    }
+}
+
+static void bench_mutex(void* context, uint64_t iterations) {
+    sync_bench* bench = (sync_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        lock_mutex(&bench->mutex);
+        ++bench->spinlock_counter;
+        unlock_mutex(&bench->mutex);
+    }
+}
+
+static void bench_rwlock_shared(void* context, uint64_t iterations) {
+    sync_bench* bench = (sync_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        lock_rwlock_shared(&bench->rwlock);
+        BENCH_DO_NOT_OPTIMIZE(bench->rwlock_counter);
+        unlock_rwlock_shared(&bench->rwlock);
+    }
+}
+
+static void bench_semaphore(void* context, uint64_t iterations) {
+    sync_bench* bench = (sync_bench*)context;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        signal_semaphore(&bench->semaphore, 1);
+        wait_semaphore(&bench->semaphore);
+    }
+}
+
+static void run_sync_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    sync_bench* bench = (sync_bench*)bump_allocate(arena, 64, sizeof(sync_bench));
+    if (bench == NULL) {
+        BUG("Failed to allocate synchronization benchmark data.");
+        return;
+    }
+    memset(bench, 0, sizeof(sync_bench));
+    if (create_mutex(&bench->mutex) != RESULT_SUCCESS || create_rwlock(&bench->rwlock) != RESULT_SUCCESS || init_semaphore(&bench->semaphore, 0) != RESULT_SUCCESS) {
+        return;
+    }
+
+    // Sanity check: contended increments are not lost, and threads blocked on the semaphore all wake up once it is signalled.
+    thread threads[BENCH_SYNC_THREADS];
+    for (uint32_t i = 0; i < BENCH_SYNC_THREADS; ++i) {
+        if (create_thread(&threads[i], contend_sync_primitives, bench) != RESULT_SUCCESS) {
+            return;
+        }
+    }
+    BENCH_CHECK(atomic_load_uint32(&bench->semaphore_acquired, MEMORY_ORDER_ACQUIRE) == 0, , "Threads acquired the semaphore before it was signalled");
+    signal_semaphore(&bench->semaphore, BENCH_SYNC_THREADS);
+    for (uint32_t i = 0; i < BENCH_SYNC_THREADS; ++i) {
+        join_thread(&threads[i]);
+        destroy_thread(&threads[i]);
+    }
+
+    const uint64_t expected = (uint64_t)BENCH_SYNC_THREADS * BENCH_SYNC_INCREMENTS;
+    BENCH_CHECK(atomic_load_uint64(&bench->atomic_counter, MEMORY_ORDER_ACQUIRE) == expected && bench->spinlock_counter == expected && bench->rwlock_counter == expected
+        && atomic_load_uint32(&bench->semaphore_acquired, MEMORY_ORDER_ACQUIRE) == BENCH_SYNC_THREADS,
+        , "Lost updates under contention: atomic %llu, spinlock %llu, rwlock %llu of %llu, semaphore %u of %u",
+        (unsigned long long)atomic_load_uint64(&bench->atomic_counter, MEMORY_ORDER_RELAXED), (unsigned long long)bench->spinlock_counter,
+        (unsigned long long)bench->rwlock_counter, (unsigned long long)expected, atomic_load_uint32(&bench->semaphore_acquired, MEMORY_ORDER_RELAXED), BENCH_SYNC_THREADS);
+
+    run_bench("sync/atomic_fetch_add", bench_atomic_fetch_add, bench, 0);
+    run_bench("sync/spinlock_lock_unlock", bench_spinlock, bench, 0);
+    run_bench("sync/mutex_lock_unlock", bench_mutex, bench, 0);
+    run_bench("sync/rwlock_shared_lock_unlock", bench_rwlock_shared, bench, 0);
+    run_bench("sync/semaphore_signal_wait", bench_semaphore, bench, 0);
+
+    destroy_rwlock(&bench->rwlock);
+    destroy_mutex(&bench->mutex);
+    reset_bump_allocator(arena);
+}
+
+/*
+=============================================================================================================================
+    Concurrent Queues
+=============================================================================================================================
+*/
+
+DECLARE_SPSC_QUEUE(bench_spsc_queue, uint64_t)
+IMPLEMENT_SPSC_QUEUE(bench_spsc_queue, uint64_t)
+DECLARE_MPMC_QUEUE(bench_mpmc_queue, uint64_t)
+IMPLEMENT_MPMC_QUEUE(bench_mpmc_queue, uint64_t)
+
+#define BENCH_QUEUE_CAPACITY 1024
+#define BENCH_QUEUE_BATCH 64
+#define BENCH_QUEUE_THREADS 4 // producers, and as many consumers
+#define BENCH_QUEUE_STRESS_VALUES (1u << 18) // per producer
+
+typedef struct {
+    bench_spsc_queue spsc;
+    bench_mpmc_queue mpmc;
+    mutex mutex; // for the mutex_queue baseline, a ring buffer behind a lock like the job system's old shared queue
+    uint64_t* mutex_ring;
+    uint64_t mutex_head;
+    uint64_t mutex_tail;
+    uint64_t values_per_producer;
+    atomic_uint64 popped_sum;
+    atomic_uint32 out_of_order;
+} queue_bench;
+
+typedef struct {
+    queue_bench* bench;
+    uint32_t index;
+} queue_bench_thread;
+
+// A thread that finds the queue full (or empty) yields instead of spinning, so the other end can run on machines with few cores.
+
+static bool push_mutex_queue(queue_bench* bench, uint64_t value) {
+    lock_mutex(&bench->mutex);
+    bool pushed = bench->mutex_tail - bench->mutex_head < BENCH_QUEUE_CAPACITY;
+    if (pushed) {
+        bench->mutex_ring[bench->mutex_tail++ & (BENCH_QUEUE_CAPACITY - 1)] = value;
+    }
+    unlock_mutex(&bench->mutex);
+    return pushed;
+}
+
+static bool pop_mutex_queue(queue_bench* bench, uint64_t* out_value) {
+    lock_mutex(&bench->mutex);
+    bool popped = bench->mutex_head != bench->mutex_tail;
+    if (popped) {
+        *out_value = bench->mutex_ring[bench->mutex_head++ & (BENCH_QUEUE_CAPACITY - 1)];
+    }
+    unlock_mutex(&bench->mutex);
+    return popped;
+}
+
+// Pushes 1..values_per_producer, in batches of a size that changes every time so that they wrap around the ring at every offset.
+static unsigned long produce_spsc_values(void* arg) {
+    queue_bench* bench = (queue_bench*)arg;
+    uint64_t batch[BENCH_QUEUE_BATCH];
+    uint64_t next = 1;
+    uint32_t batch_size = 1;
+    while (next <= bench->values_per_producer) {
+        uint32_t count = 0;
+        while (count < batch_size && next + count <= bench->values_per_producer) {
+            batch[count] = next + count;
+            ++count;
+        }
+        uint32_t pushed = batch_size & 1 ? bench_spsc_queue_push_multiple(&bench->spsc, batch, count) : (uint32_t)bench_spsc_queue_push(&bench->spsc, batch[0]);
+        if (pushed == 0) {
+            yield_thread();
+        }
+        next += pushed;
+        batch_size = batch_size % BENCH_QUEUE_BATCH + 1;
+    }
+    return 0;
+}
+
+// Values are the producer's index in the high bits and a count from 1 in the low bits.
+static unsigned long produce_mpmc_values(void* arg) {
+    queue_bench_thread* thread_bench = (queue_bench_thread*)arg;
+    queue_bench* bench = thread_bench->bench;
+    uint64_t batch[BENCH_QUEUE_BATCH];
+    uint64_t next = 1;
+    while (next <= bench->values_per_producer) {
+        uint32_t count = 0;
+        while (count < BENCH_QUEUE_BATCH && next + count <= bench->values_per_producer) {
+            batch[count] = ((uint64_t)thread_bench->index << 32) | (next + count);
+            ++count;
+        }
+        uint32_t pushed = thread_bench->index & 1 ? bench_mpmc_queue_push_multiple(&bench->mpmc, batch, count) : (uint32_t)bench_mpmc_queue_push(&bench->mpmc, batch[0]);
+        if (pushed == 0) {
+            yield_thread();
+        }
+        next += pushed;
+    }
+    return 0;
+}
+
+// Pops its share of the values and checks that each producer's values arrive in the order they were pushed.
+static unsigned long consume_mpmc_values(void* arg) {
+    queue_bench_thread* thread_bench = (queue_bench_thread*)arg;
+    queue_bench* bench = thread_bench->bench;
+    uint64_t last[BENCH_QUEUE_THREADS] = { 0 };
+    uint64_t batch[BENCH_QUEUE_BATCH];
+    uint64_t sum = 0;
+    uint64_t remaining = bench->values_per_producer;
+    while (remaining > 0) {
+        uint32_t max_count = remaining < BENCH_QUEUE_BATCH ? (uint32_t)remaining : BENCH_QUEUE_BATCH;
+        uint32_t popped = thread_bench->index & 1 ? bench_mpmc_queue_pop_multiple(&bench->mpmc, batch, max_count) : (uint32_t)bench_mpmc_queue_pop(&bench->mpmc, &batch[0]);
+        if (popped == 0) {
+            yield_thread();
+        }
+        for (uint32_t i = 0; i < popped; ++i) {
+            uint32_t producer = (uint32_t)(batch[i] >> 32) % BENCH_QUEUE_THREADS;
+            uint64_t value = batch[i] & 0xFFFFFFFFull;
+            if (value <= last[producer]) {
+                atomic_fetch_add_uint32(&bench->out_of_order, 1, MEMORY_ORDER_RELAXED);
+            }
+            last[producer] = value;
+            sum += value;
+        }
+        remaining -= popped;
+    }
+    atomic_fetch_add_uint64(&bench->popped_sum, sum, MEMORY_ORDER_RELAXED);
+    return 0;
+}
+
+static unsigned long consume_spsc_values(void* arg) {
+    queue_bench* bench = (queue_bench*)arg;
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < bench->values_per_producer; ++i) {
+        while (!bench_spsc_queue_pop(&bench->spsc, &value)) {
+            yield_thread();
+        }
+    }
+    return 0;
+}
+
+static unsigned long consume_spsc_batches(void* arg) {
+    queue_bench* bench = (queue_bench*)arg;
+    uint64_t batch[BENCH_QUEUE_BATCH];
+    for (uint64_t remaining = bench->values_per_producer; remaining > 0;) {
+        uint32_t popped = bench_spsc_queue_pop_multiple(&bench->spsc, batch, BENCH_QUEUE_BATCH);
+        if (popped == 0) {
+            yield_thread();
+        }
+        remaining -= popped < remaining ? popped : remaining;
+    }
+    return 0;
+}
+
+static unsigned long consume_mutex_queue_values(void* arg) {
+    queue_bench_thread* thread_bench = (queue_bench_thread*)arg;
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < thread_bench->bench->values_per_producer; ++i) {
+        while (!pop_mutex_queue(thread_bench->bench, &value)) {
+            yield_thread();
+        }
+    }
+    return 0;
+}
+
+static unsigned long produce_mutex_queue_values(void* arg) {
+    queue_bench_thread* thread_bench = (queue_bench_thread*)arg;
+    for (uint64_t i = 0; i < thread_bench->bench->values_per_producer; ++i) {
+        while (!push_mutex_queue(thread_bench->bench, i)) {
+            yield_thread();
+        }
+    }
+    return 0;
+}
+
+static void check_concurrent_queues(queue_bench* bench) {
+    // Sanity check: a full queue refuses values, values come out in order, and batches wrap around the end of the ring.
+    uint64_t values[BENCH_QUEUE_CAPACITY + 8];
+    for (uint32_t i = 0; i < ARRAY_LENGTH(values); ++i) {
+        values[i] = i + 1;
+    }
+    uint64_t out[BENCH_QUEUE_CAPACITY + 8] = { 0 };
+    BENCH_CHECK(bench_spsc_queue_push_multiple(&bench->spsc, values, ARRAY_LENGTH(values)) == BENCH_QUEUE_CAPACITY && !bench_spsc_queue_push(&bench->spsc, 0)
+        && bench_mpmc_queue_push_multiple(&bench->mpmc, values, ARRAY_LENGTH(values)) == BENCH_QUEUE_CAPACITY && !bench_mpmc_queue_push(&bench->mpmc, 0),
+        , "A full queue accepted more values than its capacity");
+    BENCH_CHECK(bench_spsc_queue_pop_multiple(&bench->spsc, out, 10) == 10 && out[9] == 10 && bench_mpmc_queue_pop_multiple(&bench->mpmc, out, 10) == 10 && out[9] == 10,
+        , "Queues did not pop the oldest values first");
+    BENCH_CHECK(bench_spsc_queue_push_multiple(&bench->spsc, values, 20) == 10 && bench_mpmc_queue_push_multiple(&bench->mpmc, values, 20) == 10,
+        , "Queues did not push into the room that was freed");
+    BENCH_CHECK(bench_spsc_queue_pop_multiple(&bench->spsc, out, ARRAY_LENGTH(out)) == BENCH_QUEUE_CAPACITY && out[BENCH_QUEUE_CAPACITY - 11] == BENCH_QUEUE_CAPACITY && out[BENCH_QUEUE_CAPACITY - 1] == 10,
+        , "SPSC queue batch did not wrap around the ring");
+    BENCH_CHECK(bench_mpmc_queue_pop_multiple(&bench->mpmc, out, ARRAY_LENGTH(out)) == BENCH_QUEUE_CAPACITY && out[BENCH_QUEUE_CAPACITY - 11] == BENCH_QUEUE_CAPACITY && out[BENCH_QUEUE_CAPACITY - 1] == 10,
+        , "MPMC queue batch did not wrap around the ring");
+    uint64_t value = 0;
+    BENCH_CHECK(!bench_spsc_queue_pop(&bench->spsc, &value) && bench_spsc_queue_pop_multiple(&bench->spsc, out, 4) == 0
+        && !bench_mpmc_queue_pop(&bench->mpmc, &value) && bench_mpmc_queue_pop_multiple(&bench->mpmc, out, 4) == 0, , "An empty queue popped a value");
+
+    // Stress check: a producer thread streams values through the SPSC queue in batches of every size, and they all arrive in order.
+    bench->values_per_producer = BENCH_QUEUE_STRESS_VALUES;
+    thread producer;
+    if (create_thread(&producer, produce_spsc_values, bench) != RESULT_SUCCESS) {
+        return;
+    }
+    uint64_t expected = 1;
+    uint32_t out_of_order = 0;
+    uint32_t batch_size = 1;
+    while (expected <= BENCH_QUEUE_STRESS_VALUES) {
+        uint32_t popped = batch_size & 2 ? bench_spsc_queue_pop_multiple(&bench->spsc, out, batch_size) : (uint32_t)bench_spsc_queue_pop(&bench->spsc, &out[0]);
+        for (uint32_t i = 0; i < popped; ++i, ++expected) {
+            out_of_order += out[i] != expected;
+        }
+        batch_size = batch_size % BENCH_QUEUE_BATCH + 1;
+    }
+    join_thread(&producer);
+    destroy_thread(&producer);
+    BENCH_CHECK(out_of_order == 0 && !bench_spsc_queue_pop(&bench->spsc, &value), , "SPSC queue popped %u values out of order", out_of_order);
+
+    // Stress check: producers and consumers share the MPMC queue (half of them with batches), nothing is lost or duplicated,
+    // and every consumer sees each producer's values in order.
+    queue_bench_thread thread_benches[BENCH_QUEUE_THREADS];
+    thread producers[BENCH_QUEUE_THREADS];
+    thread consumers[BENCH_QUEUE_THREADS];
+    for (uint32_t i = 0; i < BENCH_QUEUE_THREADS; ++i) {
+        thread_benches[i] = (queue_bench_thread){ .bench = bench, .index = i };
+        if (create_thread(&producers[i], produce_mpmc_values, &thread_benches[i]) != RESULT_SUCCESS
+            || create_thread(&consumers[i], consume_mpmc_values, &thread_benches[i]) != RESULT_SUCCESS) {
+            return;
+        }
+    }
+    for (uint32_t i = 0; i < BENCH_QUEUE_THREADS; ++i) {
+        join_thread(&producers[i]);
+        destroy_thread(&producers[i]);
+        join_thread(&consumers[i]);
+        destroy_thread(&consumers[i]);
+    }
+    const uint64_t expected_sum = (uint64_t)BENCH_QUEUE_THREADS * BENCH_QUEUE_STRESS_VALUES * (BENCH_QUEUE_STRESS_VALUES + 1) / 2;
+    BENCH_CHECK(atomic_load_uint64(&bench->popped_sum, MEMORY_ORDER_ACQUIRE) == expected_sum && atomic_load_uint32(&bench->out_of_order, MEMORY_ORDER_ACQUIRE) == 0
+        && !bench_mpmc_queue_pop(&bench->mpmc, &value), , "MPMC queue values add up to %llu (expected %llu), %u arrived out of order",
+        (unsigned long long)atomic_load_uint64(&bench->popped_sum, MEMORY_ORDER_RELAXED), (unsigned long long)expected_sum, atomic_load_uint32(&bench->out_of_order, MEMORY_ORDER_RELAXED));
+}
+
+static void bench_spsc_push_pop(void* context, uint64_t iterations) {
+    queue_bench* bench = (queue_bench*)context;
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bench_spsc_queue_push(&bench->spsc, i);
+        bench_spsc_queue_pop(&bench->spsc, &value);
+        BENCH_DO_NOT_OPTIMIZE(value);
+    }
+}
+
+static void bench_mpmc_push_pop(void* context, uint64_t iterations) {
+    queue_bench* bench = (queue_bench*)context;
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        bench_mpmc_queue_push(&bench->mpmc, i);
+        bench_mpmc_queue_pop(&bench->mpmc, &value);
+        BENCH_DO_NOT_OPTIMIZE(value);
+    }
+}
+
+static void bench_mutex_queue_push_pop(void* context, uint64_t iterations) {
+    queue_bench* bench = (queue_bench*)context;
+    uint64_t value = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        push_mutex_queue(bench, i);
+        pop_mutex_queue(bench, &value);
+        BENCH_DO_NOT_OPTIMIZE(value);
+    }
+}
+
+// One operation is one value through the queue to a consumer thread.
+static void bench_spsc_transfer(void* context, uint64_t iterations) {
+    queue_bench* bench = (queue_bench*)context;
+    bench->values_per_producer = iterations;
+    thread consumer;
+    if (create_thread(&consumer, consume_spsc_values, bench) != RESULT_SUCCESS) {
+        return;
+    }
+    for (uint64_t i = 0; i < iterations; ++i) {
+        while (!bench_spsc_queue_push(&bench->spsc, i)) {
+            yield_thread();
+        }
+    }
+    join_thread(&consumer);
+    destroy_thread(&consumer);
+}
+
+static void bench_spsc_transfer_batches(void* context, uint64_t iterations) {
+    queue_bench* bench = (queue_bench*)context;
+    bench->values_per_producer = iterations;
+    thread consumer;
+    if (create_thread(&consumer, consume_spsc_batches, bench) != RESULT_SUCCESS) {
+        return;
+    }
+    uint64_t batch[BENCH_QUEUE_BATCH] = { 0 };
+    for (uint64_t remaining = iterations; remaining > 0;) {
+        uint32_t pushed = bench_spsc_queue_push_multiple(&bench->spsc, batch, remaining < BENCH_QUEUE_BATCH ? (uint32_t)remaining : BENCH_QUEUE_BATCH);
+        if (pushed == 0) {
+            yield_thread();
+        }
+        remaining -= pushed;
+    }
+    join_thread(&consumer);
+    destroy_thread(&consumer);
+}
+
+// Every producer pushes and every consumer pops its share of the values, one operation is one value through the queue.
+static void transfer_between_threads(queue_bench* bench, uint64_t iterations, unsigned long (*producer)(void*), unsigned long (*consumer)(void*)) {
+    bench->values_per_producer = iterations / BENCH_QUEUE_THREADS + 1;
+    queue_bench_thread thread_benches[BENCH_QUEUE_THREADS];
+    thread producers[BENCH_QUEUE_THREADS];
+    thread consumers[BENCH_QUEUE_THREADS];
+    for (uint32_t i = 0; i < BENCH_QUEUE_THREADS; ++i) {
+        thread_benches[i] = (queue_bench_thread){ .bench = bench, .index = i };
+        if (create_thread(&producers[i], producer, &thread_benches[i]) != RESULT_SUCCESS
+            || create_thread(&consumers[i], consumer, &thread_benches[i]) != RESULT_SUCCESS) {
+            return;
+        }
+    }
+    for (uint32_t i = 0; i < BENCH_QUEUE_THREADS; ++i) {
+        join_thread(&producers[i]);
+        destroy_thread(&producers[i]);
+        join_thread(&consumers[i]);
+        destroy_thread(&consumers[i]);
+    }
+}
+
+static void bench_mpmc_transfer(void* context, uint64_t iterations) {
+    transfer_between_threads((queue_bench*)context, iterations, produce_mpmc_values, consume_mpmc_values);
+}
+
+static void bench_mutex_queue_transfer(void* context, uint64_t iterations) {
+    transfer_between_threads((queue_bench*)context, iterations, produce_mutex_queue_values, consume_mutex_queue_values);
+}
+
+static void run_concurrent_queue_benches(bump_allocator* arena) {
+    reset_bump_allocator(arena);
+    queue_bench* bench = (queue_bench*)bump_allocate(arena, alignof(queue_bench), sizeof(queue_bench));
+    if (bench == NULL) {
+        BUG("Failed to allocate queue benchmark data.");
+        return;
+    }
+    memset(bench, 0, sizeof(queue_bench));
+    bench->mutex_ring = (uint64_t*)bump_allocate(arena, alignof(uint64_t), sizeof(uint64_t) * BENCH_QUEUE_CAPACITY);
+    if (bench->mutex_ring == NULL || create_mutex(&bench->mutex) != RESULT_SUCCESS
+        || bench_spsc_queue_create(&bench->spsc, arena, BENCH_QUEUE_CAPACITY) != RESULT_SUCCESS
+        || bench_mpmc_queue_create(&bench->mpmc, arena, BENCH_QUEUE_CAPACITY) != RESULT_SUCCESS) {
+        return;
+    }
+    check_concurrent_queues(bench);
+
+    run_bench("spsc_queue/push_pop", bench_spsc_push_pop, bench, 0);
+    run_bench("mpmc_queue/push_pop", bench_mpmc_push_pop, bench, 0);
+    run_bench("mutex_queue/push_pop", bench_mutex_queue_push_pop, bench, 0);
+    run_bench("spsc_queue/transfer_to_thread", bench_spsc_transfer, bench, sizeof(uint64_t));
+    run_bench("spsc_queue/transfer_to_thread_in_batches_of_" TOSTRING(BENCH_QUEUE_BATCH), bench_spsc_transfer_batches, bench, sizeof(uint64_t));
+    run_bench("mpmc_queue/transfer_" TOSTRING(BENCH_QUEUE_THREADS) "_producers_" TOSTRING(BENCH_QUEUE_THREADS) "_consumers", bench_mpmc_transfer, bench, sizeof(uint64_t));
+    run_bench("mutex_queue/transfer_" TOSTRING(BENCH_QUEUE_THREADS) "_producers_" TOSTRING(BENCH_QUEUE_THREADS) "_consumers", bench_mutex_queue_transfer, bench, sizeof(uint64_t));
+
+    destroy_mutex(&bench->mutex);
+    reset_bump_allocator(arena);
+}
+
+void run_engine_benches(void) {
+    bump_allocator arena;
+    if (create_bump_allocator(&arena, 256 * 1024 * 1024) != RESULT_SUCCESS) {
+        BUG("Failed to create benchmark arena.");
+        return;
+    }
+
+    run_bump_allocator_benches(&arena);
+    run_arena_snapshot_benches(&arena);
+    run_pool_allocator_benches(&arena);
+    run_tlsf_allocator_benches(&arena);
+
+    check_capped_arrays(&arena);
+    bench_values* values = (bench_values*)bump_allocate(&arena, alignof(bench_values), sizeof(bench_values));
+    bench_entities* entities = (bench_entities*)bump_allocate(&arena, alignof(bench_entities), sizeof(bench_entities));
+    if (values != NULL && entities != NULL) {
+        run_bench_values_benches(values);
+        run_bench_entities_benches(entities);
+    }
+    reset_bump_allocator(&arena);
+    run_dynamic_array_benches(&arena);
+    run_hash_map_benches(&arena);
+    run_slot_map_benches(&arena);
+    run_soa_benches(&arena);
+    run_bitset_benches(&arena);
+
+    run_geometry_benches(&arena);
+    run_string_benches(&arena);
+    run_file_benches(&arena);
+    run_graphics_benches(&arena);
+    run_time_benches();
+    run_frame_statistics_benches(&arena);
+    run_sync_benches(&arena);
+    run_concurrent_queue_benches(&arena);
+    run_job_benches(&arena);
+#ifdef ENABLE_PROFILER
+    run_profiler_benches(&arena);
+#endif
+    destroy_bump_allocator(&arena);
+}
@@ -0,0 +1,90 @@
+#include "bench.h"
+#include "frame_pacer.h"
+
+/*
+Frame pacing benchmark. Runs a fake frame loop (busy work for a fixed time, then wait_for_next_frame) and reports
+how close each frame started to its deadline, and how much of the waiting time was spent sleeping rather than spinning.
+The busy percentage is the share of wall time the loop kept the core busy (work plus spinning).
+*/
+
+static const uint32_t pacing_bench_frame_rates[] = { 30, 60, 144, 240 };
+
+static void do_frame_work(uint64_t work_ticks) {
+    uint64_t start = read_timestamp();
+    while (read_timestamp() - start < work_ticks) {
+        CPU_RELAX();
+    }
+}
+
+static void run_pacing_scenario(uint32_t frame_rate, const pacing_bench_settings* settings) {
+    frame_pacer pacer;
+    create_frame_pacer(&pacer, frame_rate);
+    uint64_t work_ticks = (uint64_t)(settings->work_milliseconds * 0.001 * (double)get_timestamp_frequency());
+
+    // The first wait only sets up the deadline grid.
+    wait_for_next_frame(&pacer);
+    pacer.frames_paced = 0;
+    pacer.late_frames = 0;
+    pacer.missed_deadlines = 0;
+    pacer.total_error_ticks = 0;
+    pacer.max_error_ticks = 0;
+    pacer.total_sleep_ticks = 0;
+    pacer.total_spin_ticks = 0;
+
+    uint64_t start = read_timestamp();
+    for (uint32_t frame = 0; frame < settings->frames; ++frame) {
+        do_frame_work(work_ticks);
+        wait_for_next_frame(&pacer);
+    }
+    uint64_t elapsed = read_timestamp() - start;
+
+    double frames = settings->frames > 0 ? (double)settings->frames : 1.0;
+    double elapsed_seconds = timestamp_to_seconds(elapsed);
+    double achieved_rate = elapsed_seconds > 0.0 ? frames / elapsed_seconds : 0.0;
+    double mean_error_ms = timestamp_to_seconds(pacer.total_error_ticks) * 1000.0 / frames;
+    double max_error_ms = timestamp_to_seconds(pacer.max_error_ticks) * 1000.0;
+    double busy_percent = elapsed > 0 ? 100.0 * (double)(elapsed - pacer.total_sleep_ticks) / (double)elapsed : 0.0;
+    double spin_margin_ms = timestamp_to_seconds(pacer.spin_ticks) * 1000.0;
+
+    begin_bench_record();
+    switch (get_bench_output()) {
+    case BENCH_OUTPUT_JSON:
+        printf("{\"target_fps\": %u, \"frames\": %u, \"work_ms\": %.3f, \"achieved_fps\": %.3f, \"mean_error_ms\": %.6f, \"max_error_ms\": %.6f, "
+            "\"late_frames\": %llu, \"missed_deadlines\": %llu, \"busy_percent\": %.2f, \"spin_margin_ms\": %.6f}",
+            frame_rate, settings->frames, settings->work_milliseconds, achieved_rate, mean_error_ms, max_error_ms,
+            (unsigned long long)pacer.late_frames, (unsigned long long)pacer.missed_deadlines, busy_percent, spin_margin_ms);
+        break;
+    case BENCH_OUTPUT_CSV:
+        printf("%u,%u,%.3f,%.3f,%.6f,%.6f,%llu,%llu,%.2f,%.6f\n",
+            frame_rate, settings->frames, settings->work_milliseconds, achieved_rate, mean_error_ms, max_error_ms,
+            (unsigned long long)pacer.late_frames, (unsigned long long)pacer.missed_deadlines, busy_percent, spin_margin_ms);
+        break;
+    default:
+        printf("%10u %10.3f %12.4f %12.4f %8llu %8llu %8.1f%% %12.4f\n",
+            frame_rate, achieved_rate, mean_error_ms, max_error_ms,
+            (unsigned long long)pacer.late_frames, (unsigned long long)pacer.missed_deadlines, busy_percent, spin_margin_ms);
+        break;
+    }
+    fflush(stdout);
+}
+
+void run_pacing_benches(const pacing_bench_settings* settings) {
+    BENCH_CHECK(settings != NULL, return, "Pacing benchmark settings cannot be NULL");
+
+    if (get_bench_output() == BENCH_OUTPUT_CSV) {
+        printf("target_fps,frames,work_ms,achieved_fps,mean_error_ms,max_error_ms,late_frames,missed_deadlines,busy_percent,spin_margin_ms\n");
+    }
+    else if (get_bench_output() == BENCH_OUTPUT_TABLE) {
+        printf("%u frames with %.3f ms of work per frame\n", settings->frames, settings->work_milliseconds);
+        printf("%10s %10s %12s %12s %8s %8s %9s %12s\n", "target_fps", "fps", "mean_err_ms", "max_err_ms", "late", "missed", "busy", "spin_ms");
+    }
+
+    if (settings->frame_rate != 0) {
+        run_pacing_scenario(settings->frame_rate, settings);
+        return;
+    }
+
+    for (uint32_t i = 0; i < ARRAY_LENGTH(pacing_bench_frame_rates); ++i) {
+        run_pacing_scenario(pacing_bench_frame_rates[i], settings);
+    }
+}
@@ -0,0 +1,266 @@
+#include "bench.h"
+
+/*
+Scaling benchmark for the asteroids simulation in game.c.
+The game is compiled into the benchmark with much larger capacities, so that the per phase cost of update_simulation
+can be measured from a handful of entities up to millions of them. Every scenario starts from a fixed seed.
+The asteroids (with their slots and motion columns) and the hits each grow in an arena of their own, like they would in a game with a big perm arena.
+With --threads the parallel phases are split across a job system, the same way the game runs them.
+*/
+
+#define MAX_PROJECTILES (1u << 20)
+#include "../game/game.c"
+
+#define SIMULATION_BENCH_DELTA_TIME (1.0f / 60.0f)
+#define SIMULATION_BENCH_MAX_PLAYERS 1024
+#define SIMULATION_BENCH_MAX_ASTEROIDS (1u << 21)
+
+// Room for the asteroids to double (and split) past the largest count.
+#define SIMULATION_BENCH_ASTEROID_ARENA_BYTES ((sizeof(asteroid) + sizeof(slot_handle) + sizeof(slot_map_slot) + sizeof(asteroid_motion_element)) * SIMULATION_BENCH_MAX_ASTEROIDS * 4)
+#define SIMULATION_BENCH_HIT_ARENA_BYTES (sizeof(slot_handle) * SIMULATION_BENCH_MAX_ASTEROIDS * 4)
+
+typedef struct {
+    bump_allocator asteroids;
+    bump_allocator hits;
+} simulation_bench_arenas;
+
+// The counts used by the default sweep, and the count the other entity type is held at while sweeping.
+static const uint32_t simulation_bench_counts[] = { 10, 100, 1000, 10000, 100000, 1000000 };
+#define SIMULATION_BENCH_DEFAULT_ASTEROIDS 128
+#define SIMULATION_BENCH_DEFAULT_PROJECTILES 16
+
+typedef struct {
+    uint32_t asteroid_count;
+    uint32_t projectile_count;
+    uint32_t player_count;
+    uint32_t ticks;
+    uint32_t thread_count;
+    double integration_ms;
+    double wrap_ms;
+    double collision_ms;
+    double spawn_despawn_ms;
+    double max_tick_ms;
+    uint32_t final_asteroid_count;
+    uint32_t final_projectile_count;
+} simulation_bench_result;
+
+static vector2 random_play_area_position(void) {
+    return (vector2) { (float)(rand() % TARGET_RESOLUTION), (float)(rand() % TARGET_RESOLUTION) };
+}
+
+// Spaceships are kept alive between ticks so that every tick checks the same number of players for collisions.
+static void revive_spaceship(spaceship* ship) {
+    ship->is_destroyed = false;
+    ship->animation.type = ANIMATION_TYPE_NONE;
+    ship->invincibility_time_remaining = 0.0f;
+}
+
+static void populate_simulation(game_state* state, spaceship* extra_players, simulation_bench_arenas* arenas, const simulation_bench_settings* settings) {
+    srand(settings->seed);
+
+    memset(&state->player_spaceship, 0, sizeof(spaceship));
+    state->player_spaceship.transform.position = (vector2){ TARGET_RESOLUTION / 2.0f, TARGET_RESOLUTION / 2.0f };
+    if (settings->player_count == 0) {
+        state->player_spaceship.is_destroyed = true;
+    }
+
+    for (uint32_t i = 1; i < settings->player_count; ++i) {
+        spaceship* ship = &extra_players[i - 1];
+        memset(ship, 0, sizeof(spaceship));
+        ship->transform.position = random_play_area_position();
+    }
+
+    reset_bump_allocator(&arenas->asteroids);
+    reset_bump_allocator(&arenas->hits);
+    state->asteroids = (asteroids){ 0 };
+    state->asteroid_motion = (asteroid_motion){ 0 };
+    state->asteroid_hits = (asteroid_hits){ 0 };
+    asteroids_reserve(&state->asteroids, &arenas->asteroids, settings->asteroid_count);
+    asteroid_motion_reserve(&state->asteroid_motion, &arenas->asteroids, settings->asteroid_count);
+    for (uint32_t i = 0; i < settings->asteroid_count; ++i) {
+        spawn_asteroid(state, &arenas->asteroids, random_play_area_position(), (asteroid_size)(rand() % 3));
+    }
+
+    projectiles_clear(&state->projectiles);
+    for (uint32_t i = 0; i < settings->projectile_count; ++i) {
+        projectile* proj = &state->projectiles.elements[state->projectiles.count++];
+        memset(proj, 0, sizeof(projectile));
+        proj->transform.position = random_play_area_position();
+        proj->transform.direction = vector2_from_angle((float)(rand() % 360) * (M_PI / 180.0f));
+        proj->transform.speed = PLAYER_SPACESHIP_SPEED * 2.0f;
+        proj->lifetime = 2.0f;
+    }
+}
+
+static simulation_bench_result run_simulation_scenario(game_state* state, spaceship* extra_players, simulation_bench_arenas* arenas, job_system* jobs,
+    const simulation_bench_settings* settings) {
+    populate_simulation(state, extra_players, arenas, settings);
+
+    simulation_bench_result result = {
+        .asteroid_count = settings->asteroid_count,
+        .projectile_count = settings->projectile_count,
+        .player_count = settings->player_count,
+        .ticks = settings->ticks,
+        .thread_count = jobs != NULL ? jobs->thread_count : 1,
+    };
+
+    uint64_t integration_ticks = 0;
+    uint64_t wrap_ticks = 0;
+    uint64_t collision_ticks = 0;
+    uint64_t spawn_despawn_ticks = 0;
+    uint64_t max_tick_ticks = 0;
+
+    for (uint32_t tick = 0; tick < settings->ticks; ++tick) {
+        uint64_t start = read_timestamp();
+        integrate_simulation(state, jobs, SIMULATION_BENCH_DELTA_TIME);
+        uint64_t integrated = read_timestamp();
+        wrap_simulation(state, jobs);
+        uint64_t wrapped = read_timestamp();
+        collide_simulation(state, &arenas->hits);
+        for (uint32_t i = 1; i < settings->player_count; ++i) {
+            collide_spaceship_with_asteroids(&extra_players[i - 1], &state->asteroid_motion);
+        }
+        uint64_t collided = read_timestamp();
+        spawn_and_despawn_simulation(state, &arenas->asteroids, SIMULATION_BENCH_DELTA_TIME);
+        uint64_t end = read_timestamp();
+
+        integration_ticks += integrated - start;
+        wrap_ticks += wrapped - integrated;
+        collision_ticks += collided - wrapped;
+        spawn_despawn_ticks += end - collided;
+        if (end - start > max_tick_ticks) {
+            max_tick_ticks = end - start;
+        }
+
+        if (settings->player_count > 0) {
+            revive_spaceship(&state->player_spaceship);
+        }
+        for (uint32_t i = 1; i < settings->player_count; ++i) {
+            revive_spaceship(&extra_players[i - 1]);
+        }
+    }
+
+    double ticks = settings->ticks > 0 ? (double)settings->ticks : 1.0;
+    result.integration_ms = timestamp_to_seconds(integration_ticks) * 1000.0 / ticks;
+    result.wrap_ms = timestamp_to_seconds(wrap_ticks) * 1000.0 / ticks;
+    result.collision_ms = timestamp_to_seconds(collision_ticks) * 1000.0 / ticks;
+    result.spawn_despawn_ms = timestamp_to_seconds(spawn_despawn_ticks) * 1000.0 / ticks;
+    result.max_tick_ms = timestamp_to_seconds(max_tick_ticks) * 1000.0;
+    result.final_asteroid_count = state->asteroids.count;
+    result.final_projectile_count = state->projectiles.count;
+    return result;
+}
+
+static void print_simulation_result(const simulation_bench_result* result) {
+    double total_ms = result->integration_ms + result->wrap_ms + result->collision_ms + result->spawn_despawn_ms;
+    begin_bench_record();
+    switch (get_bench_output()) {
+    case BENCH_OUTPUT_JSON:
+        printf("{\"asteroids\": %u, \"projectiles\": %u, \"players\": %u, \"ticks\": %u, \"threads\": %u, "
+            "\"integration_ms_per_tick\": %.6f, \"wrap_ms_per_tick\": %.6f, \"collision_ms_per_tick\": %.6f, \"spawn_despawn_ms_per_tick\": %.6f, "
+            "\"total_ms_per_tick\": %.6f, \"max_tick_ms\": %.6f, \"final_asteroids\": %u, \"final_projectiles\": %u}",
+            result->asteroid_count, result->projectile_count, result->player_count, result->ticks, result->thread_count,
+            result->integration_ms, result->wrap_ms, result->collision_ms, result->spawn_despawn_ms,
+            total_ms, result->max_tick_ms, result->final_asteroid_count, result->final_projectile_count);
+        break;
+    case BENCH_OUTPUT_CSV:
+        printf("%u,%u,%u,%u,%u,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%u,%u\n",
+            result->asteroid_count, result->projectile_count, result->player_count, result->ticks, result->thread_count,
+            result->integration_ms, result->wrap_ms, result->collision_ms, result->spawn_despawn_ms,
+            total_ms, result->max_tick_ms, result->final_asteroid_count, result->final_projectile_count);
+        break;
+    default:
+        printf("%10u %12u %8u %12.4f %12.4f %12.4f %12.4f %12.4f %12.4f %10u %12u\n",
+            result->asteroid_count, result->projectile_count, result->player_count,
+            result->integration_ms, result->wrap_ms, result->collision_ms, result->spawn_despawn_ms,
+            total_ms, result->max_tick_ms, result->final_asteroid_count, result->final_projectile_count);
+        break;
+    }
+    fflush(stdout);
+}
+
+static void run_and_print_simulation_scenario(game_state* state, spaceship* extra_players, simulation_bench_arenas* arenas, job_system* jobs,
+    const simulation_bench_settings* settings) {
+    BENCH_CHECK(settings->asteroid_count <= SIMULATION_BENCH_MAX_ASTEROIDS, return, "Asteroid count %u exceeds the benchmark capacity %u", settings->asteroid_count, SIMULATION_BENCH_MAX_ASTEROIDS);
+    BENCH_CHECK(settings->projectile_count <= MAX_PROJECTILES, return, "Projectile count %u exceeds the benchmark capacity %u", settings->projectile_count, MAX_PROJECTILES);
+    simulation_bench_result result = run_simulation_scenario(state, extra_players, arenas, jobs, settings);
+    print_simulation_result(&result);
+}
+
+void run_simulation_benches(const simulation_bench_settings* settings) {
+    BENCH_CHECK(settings != NULL, return, "Simulation benchmark settings cannot be NULL");
+    BENCH_CHECK(settings->player_count <= SIMULATION_BENCH_MAX_PLAYERS, return, "Player count %u exceeds the benchmark capacity %u", settings->player_count, SIMULATION_BENCH_MAX_PLAYERS);
+
+    bump_allocator arena;
+    size_t job_system_size = sizeof(job_system) + sizeof(job) * JOB_QUEUE_CAPACITY * (JOB_SYSTEM_MAX_THREADS + 1) + JOB_SYSTEM_CACHE_LINE * (JOB_SYSTEM_MAX_THREADS + 2);
+    if (create_bump_allocator(&arena, sizeof(game_state) + sizeof(spaceship) * SIMULATION_BENCH_MAX_PLAYERS + job_system_size + 4096) != RESULT_SUCCESS) {
+        BUG("Failed to create simulation benchmark arena.");
+        return;
+    }
+
+    game_state* state = (game_state*)bump_allocate(&arena, alignof(game_state), sizeof(game_state));
+    spaceship* extra_players = (spaceship*)bump_allocate(&arena, alignof(spaceship), sizeof(spaceship) * SIMULATION_BENCH_MAX_PLAYERS);
+    if (state == NULL || extra_players == NULL) {
+        BUG("Failed to allocate simulation benchmark state.");
+        destroy_bump_allocator(&arena);
+        return;
+    }
+
+    simulation_bench_arenas arenas = { 0 };
+    if (create_bump_allocator(&arenas.asteroids, SIMULATION_BENCH_ASTEROID_ARENA_BYTES) != RESULT_SUCCESS
+        || create_bump_allocator(&arenas.hits, SIMULATION_BENCH_HIT_ARENA_BYTES) != RESULT_SUCCESS) {
+        BUG("Failed to create simulation benchmark arenas.");
+        destroy_bump_allocator(&arenas.asteroids);
+        destroy_bump_allocator(&arena);
+        return;
+    }
+
+    job_system* jobs = NULL;
+    if (settings->thread_count != 1) {
+        jobs = (job_system*)bump_allocate(&arena, alignof(job_system), sizeof(job_system));
+        if (jobs == NULL || create_job_system(jobs, settings->thread_count, &arena) != RESULT_SUCCESS) {
+            BUG("Failed to create simulation benchmark job system.");
+            destroy_bump_allocator(&arenas.hits);
+            destroy_bump_allocator(&arenas.asteroids);
+            destroy_bump_allocator(&arena);
+            return;
+        }
+    }
+
+    if (get_bench_output() == BENCH_OUTPUT_CSV) {
+        printf("asteroids,projectiles,players,ticks,threads,integration_ms_per_tick,wrap_ms_per_tick,collision_ms_per_tick,spawn_despawn_ms_per_tick,total_ms_per_tick,max_tick_ms,final_asteroids,final_projectiles\n");
+    }
+    else if (get_bench_output() == BENCH_OUTPUT_TABLE) {
+        printf("ms per tick over %u ticks on %u threads\n", settings->ticks, jobs != NULL ? jobs->thread_count : 1);
+        printf("%10s %12s %8s %12s %12s %12s %12s %12s %12s %10s %12s\n",
+            "asteroids", "projectiles", "players", "integration", "wrap", "collision", "spawn", "total", "max_tick", "final_ast", "final_proj");
+    }
+
+    simulation_bench_settings scenario = *settings;
+    if (settings->asteroid_count != 0 && settings->projectile_count != 0) {
+        run_and_print_simulation_scenario(state, extra_players, &arenas, jobs, &scenario);
+    }
+
+    if (settings->asteroid_count == 0) {
+        scenario.projectile_count = settings->projectile_count != 0 ? settings->projectile_count : SIMULATION_BENCH_DEFAULT_PROJECTILES;
+        for (uint32_t i = 0; i < ARRAY_LENGTH(simulation_bench_counts); ++i) {
+            scenario.asteroid_count = simulation_bench_counts[i];
+            run_and_print_simulation_scenario(state, extra_players, &arenas, jobs, &scenario);
+        }
+    }
+
+    if (settings->projectile_count == 0) {
+        scenario.asteroid_count = settings->asteroid_count != 0 ? settings->asteroid_count : SIMULATION_BENCH_DEFAULT_ASTEROIDS;
+        for (uint32_t i = 0; i < ARRAY_LENGTH(simulation_bench_counts); ++i) {
+            scenario.projectile_count = simulation_bench_counts[i];
+            run_and_print_simulation_scenario(state, extra_players, &arenas, jobs, &scenario);
+        }
+    }
+
+    if (jobs != NULL) {
+        destroy_job_system(jobs);
+    }
+    destroy_bump_allocator(&arenas.hits);
+    destroy_bump_allocator(&arenas.asteroids);
+    destroy_bump_allocator(&arena);
+}
@@ -1,6 +1,7 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #include "asset_files.h"
+#include "bitset.h"
 
 IMPLEMENT_CAPPED_ARRAY(sounds, sound, MAX_SOUNDS)
 
@@ -12,7 +13,7 @@ typedef struct {
     uint32_t size;
 } wav_file_chunk_header;
 
-static result read_wav_file(string file_path, bump_allocator* allocator, sound* out_file_data) {
+result read_wav_file(string file_path, bump_allocator* allocator, sound* out_file_data) {
     ASSERT(file_path.length > 0, return RESULT_FAILURE, "File path cannot be empty");
     ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
     ASSERT(out_file_data != NULL, return RESULT_FAILURE, "Output WAV file data cannot be NULL");
@@ -95,15 +96,16 @@ typedef struct {
     // If the file cannot be mapped, it will have the value FILE_ORDERING_INVALID_INDEX.
     uint32_t index_by_file_name[MAX_FILE_NAMES];
 } file_ordering;
-STATIC_ASSERT(MAX_FILE_NAMES <= 64, max_file_names_should_be_bitset_compatible);
 
 #define FILE_ORDERING_INVALID_INDEX UINT32_MAX
 
+DECLARE_BITSET(file_index_bitset, MAX_FILE_NAMES)
+
 static void create_file_ordering(file_names* file_names, file_ordering* out_ordering) {
     ASSERT(file_names != NULL, return, "File names pointer cannot be NULL");
     ASSERT(out_ordering != NULL, return, "Output ordering pointer cannot be NULL");
 #ifndef NDEBUG
-    uint64_t bitset = 0;
+    file_index_bitset file_indices = { 0 };
 #endif
     for (uint32_t i = 0; i < file_names->count; ++i) {
         out_ordering->index_by_file_name[i] = FILE_ORDERING_INVALID_INDEX;
@@ -124,14 +126,17 @@ static void create_file_ordering(file_names* file_names, file_ordering* out_orde
         }
 
 #ifndef NDEBUG
-        bitset |= ((uint64_t)1 << file_index);
+        if (file_index < MAX_FILE_NAMES) {
+            file_index_bitset_set(&file_indices, file_index);
+        }
 #endif
         out_ordering->index_by_file_name[i] = file_index;
         ++out_ordering->num_valid;
     }
 
 #ifndef NDEBUG
-    if (bitset != (out_ordering->num_valid == 64 ? UINT64_MAX : ((uint64_t)1 << out_ordering->num_valid) - 1)) {
+    // Every index is below num_valid and none is repeated exactly when num_valid distinct bits are set, none of them at num_valid or above.
+    if (file_index_bitset_count(&file_indices) != out_ordering->num_valid || file_index_bitset_next(&file_indices, out_ordering->num_valid) != MAX_FILE_NAMES) {
         BUG("File ordering contains duplicate or out-of-bounds indices. Ensure that it is a linear sequence starting from 0.");
     }
 #endif
@@ -174,9 +179,12 @@ void create_sounds_from_files(memory_allocators* allocators, sounds* out_sounds)
     ASSERT(out_sounds != NULL, return, "Output sounds pointer cannot be NULL");
     memset(out_sounds, 0, sizeof(sounds));
 
+    // The directory listing is only needed while the sounds load (the samples go into perm).
+    arena_scope scope = arena_scope_begin(&allocators->temp);
     string executable_directory = get_executable_directory(&allocators->temp);
     string sound_directory = concat(executable_directory, (string)CSTR(ASSET_DIRECTORY), &allocators->temp);
     create_sounds_from_directory(allocators, sound_directory, out_sounds);
+    arena_scope_end(scope);
 }
 
 result create_image_from_first_file(bump_allocator* allocator, image* out_image) {
@@ -10,7 +10,11 @@ and so it makes sense to centralise the functions that might execute at runtime
 #include "platform_layer.h"
 
 #ifndef ASSET_DIRECTORY
+#ifdef _WIN32
 #define ASSET_DIRECTORY "assets\\"
+#else
+#define ASSET_DIRECTORY "assets/"
+#endif
 #endif
 
 typedef struct {
@@ -51,6 +55,7 @@ In the future it might be preferable to make a png reader (instead of using stb_
 */
 
 void create_sounds_from_files(memory_allocators* allocators, sounds* out_sounds);
+result read_wav_file(string file_path, bump_allocator* allocator, sound* out_file_data);
 result create_image_from_first_file(bump_allocator* allocator, image* out_image);
 void destroy_image(image* image);
 #endif // ASSET_FILES_H
\ No newline at end of file
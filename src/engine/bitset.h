@@ -0,0 +1,168 @@
+#ifndef BITSET_H
+#define BITSET_H
+#include "fundamental.h"
+
+/*
+A fixed-size set of bits packed into 64-bit words, for sets of small integers: keys that are down, the components an entity has,
+the collision layers an object is on, the voices that are playing. Testing and changing a bit is a shift and a mask, whole sets are
+combined a word at a time (and, or, and_not), and the set bits are found with one bit scan per set bit rather than a test per bit,
+so iterating a sparse set is much faster than scanning an array of flags.
+
+The bit count is a compile-time constant, so every function is inline and its loops over the words are unrolled. Bits past the
+bit count are always zero. Initialize with { 0 } for an empty set.
+
+usage:
+    DECLARE_BITSET(voice_bitset, MAX_CONCURRENT_SOUNDS)
+
+    voice_bitset_set(&audio->playing, voice);
+    ...
+    for (uint32_t voice = voice_bitset_next(&audio->playing, 0); voice < MAX_CONCURRENT_SOUNDS; voice = voice_bitset_next(&audio->playing, voice + 1)) {
+        ...
+    }
+*/
+
+#define BITSET_WORD_COUNT(bit_count) (((bit_count) + 63) / 64)
+
+// Sets (or clears) the bits in [begin, end).
+static inline void set_bit_range(uint64_t* words, uint32_t begin, uint32_t end) {
+    if (begin >= end) {
+        return;
+    }
+    uint32_t first = begin >> 6;
+    uint32_t last = (end - 1) >> 6;
+    uint64_t first_mask = ~0ull << (begin & 63);
+    uint64_t last_mask = ~0ull >> (63 - ((end - 1) & 63));
+    if (first == last) {
+        words[first] |= first_mask & last_mask;
+        return;
+    }
+    words[first] |= first_mask;
+    for (uint32_t i = first + 1; i < last; ++i) {
+        words[i] = ~0ull;
+    }
+    words[last] |= last_mask;
+}
+
+static inline void clear_bit_range(uint64_t* words, uint32_t begin, uint32_t end) {
+    if (begin >= end) {
+        return;
+    }
+    uint32_t first = begin >> 6;
+    uint32_t last = (end - 1) >> 6;
+    uint64_t first_mask = ~0ull << (begin & 63);
+    uint64_t last_mask = ~0ull >> (63 - ((end - 1) & 63));
+    if (first == last) {
+        words[first] &= ~(first_mask & last_mask);
+        return;
+    }
+    words[first] &= ~first_mask;
+    for (uint32_t i = first + 1; i < last; ++i) {
+        words[i] = 0;
+    }
+    words[last] &= ~last_mask;
+}
+
+// The first set bit at or after from, or bit_count if there is none.
+static inline uint32_t find_next_set_bit(const uint64_t* words, uint32_t bit_count, uint32_t from) {
+    if (from >= bit_count) {
+        return bit_count;
+    }
+    uint32_t word_index = from >> 6;
+    uint64_t word = words[word_index] & (~0ull << (from & 63));
+    while (word == 0) {
+        if (++word_index == BITSET_WORD_COUNT(bit_count)) {
+            return bit_count;
+        }
+        word = words[word_index];
+    }
+    return word_index * 64 + lowest_set_bit(word);
+}
+
+#define DECLARE_BITSET(name, bit_count) \
+    typedef struct { \
+        uint64_t words[BITSET_WORD_COUNT(bit_count)]; \
+    } name; \
+    static inline void name##_set(name* set, uint32_t bit) { \
+        DEBUG_ASSERT(bit < (bit_count), return, "Bit %u out of range of " #name " (%u bits)", bit, (uint32_t)(bit_count)); \
+        set->words[bit >> 6] |= 1ull << (bit & 63); \
+    } \
+    static inline void name##_clear(name* set, uint32_t bit) { \
+        DEBUG_ASSERT(bit < (bit_count), return, "Bit %u out of range of " #name " (%u bits)", bit, (uint32_t)(bit_count)); \
+        set->words[bit >> 6] &= ~(1ull << (bit & 63)); \
+    } \
+    static inline void name##_assign(name* set, uint32_t bit, bool value) { \
+        DEBUG_ASSERT(bit < (bit_count), return, "Bit %u out of range of " #name " (%u bits)", bit, (uint32_t)(bit_count)); \
+        set->words[bit >> 6] = (set->words[bit >> 6] & ~(1ull << (bit & 63))) | ((uint64_t)value << (bit & 63)); \
+    } \
+    static inline bool name##_test(const name* set, uint32_t bit) { \
+        DEBUG_ASSERT(bit < (bit_count), return false, "Bit %u out of range of " #name " (%u bits)", bit, (uint32_t)(bit_count)); \
+        return (set->words[bit >> 6] >> (bit & 63)) & 1; \
+    } \
+    /* Sets (or clears) the bits in [begin, end). */ \
+    static inline void name##_set_range(name* set, uint32_t begin, uint32_t end) { \
+        DEBUG_ASSERT(end <= (bit_count), return, "Range [%u, %u) out of range of " #name " (%u bits)", begin, end, (uint32_t)(bit_count)); \
+        set_bit_range(set->words, begin, end); \
+    } \
+    static inline void name##_clear_range(name* set, uint32_t begin, uint32_t end) { \
+        DEBUG_ASSERT(end <= (bit_count), return, "Range [%u, %u) out of range of " #name " (%u bits)", begin, end, (uint32_t)(bit_count)); \
+        clear_bit_range(set->words, begin, end); \
+    } \
+    static inline void name##_set_all(name* set) { \
+        set_bit_range(set->words, 0, (bit_count)); \
+    } \
+    static inline void name##_clear_all(name* set) { \
+        memset(set->words, 0, sizeof(set->words)); \
+    } \
+    static inline uint32_t name##_count(const name* set) { \
+        uint32_t count = 0; \
+        for (uint32_t i = 0; i < BITSET_WORD_COUNT(bit_count); ++i) { \
+            count += count_set_bits(set->words[i]); \
+        } \
+        return count; \
+    } \
+    static inline bool name##_any(const name* set) { \
+        uint64_t any = 0; \
+        for (uint32_t i = 0; i < BITSET_WORD_COUNT(bit_count); ++i) { \
+            any |= set->words[i]; \
+        } \
+        return any != 0; \
+    } \
+    /* The first set bit at or after from, or bit_count once there are no more (see the usage above). */ \
+    static inline uint32_t name##_next(const name* set, uint32_t from) { \
+        return find_next_set_bit(set->words, (bit_count), from); \
+    } \
+    /* out may be one of the inputs. */ \
+    static inline void name##_and(name* out, const name* a, const name* b) { \
+        for (uint32_t i = 0; i < BITSET_WORD_COUNT(bit_count); ++i) { \
+            out->words[i] = a->words[i] & b->words[i]; \
+        } \
+    } \
+    static inline void name##_or(name* out, const name* a, const name* b) { \
+        for (uint32_t i = 0; i < BITSET_WORD_COUNT(bit_count); ++i) { \
+            out->words[i] = a->words[i] | b->words[i]; \
+        } \
+    } \
+    /* The bits of a that are not in b. */ \
+    static inline void name##_and_not(name* out, const name* a, const name* b) { \
+        for (uint32_t i = 0; i < BITSET_WORD_COUNT(bit_count); ++i) { \
+            out->words[i] = a->words[i] & ~b->words[i]; \
+        } \
+    } \
+    /* Whether a and b have any bit in common (such as two overlapping collision layers). */ \
+    static inline bool name##_intersects(const name* a, const name* b) { \
+        uint64_t common = 0; \
+        for (uint32_t i = 0; i < BITSET_WORD_COUNT(bit_count); ++i) { \
+            common |= a->words[i] & b->words[i]; \
+        } \
+        return common != 0; \
+    } \
+    /* Whether every bit of subset is also in set (such as an entity having all the components a system needs). */ \
+    static inline bool name##_includes(const name* set, const name* subset) { \
+        uint64_t missing = 0; \
+        for (uint32_t i = 0; i < BITSET_WORD_COUNT(bit_count); ++i) { \
+            missing |= subset->words[i] & ~set->words[i]; \
+        } \
+        return missing == 0; \
+    }
+
+#endif // BITSET_H
@@ -0,0 +1,9 @@
+#include "concurrent_queue.h"
+
+void* allocate_concurrent_queue_buffer(bump_allocator* allocator, uint32_t capacity, size_t element_size) {
+    ASSERT(allocator != NULL, return NULL, "Allocator cannot be NULL");
+    ASSERT(capacity > 0 && (capacity & (capacity - 1)) == 0, return NULL, "Queue capacity %u is not a power of two", capacity);
+    void* buffer = BUMP_ALLOCATE_TAGGED(allocator, CONCURRENT_QUEUE_CACHE_LINE, (size_t)capacity * element_size, "queue");
+    ASSERT(buffer != NULL, return NULL, "Failed to allocate a queue of %u elements", capacity);
+    return buffer;
+}
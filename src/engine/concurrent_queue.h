@@ -0,0 +1,279 @@
+#ifndef CONCURRENT_QUEUE_H
+#define CONCURRENT_QUEUE_H
+#include "platform_layer.h"
+
+/*
+Bounded lock-free queues for handing values from one thread to another, in a ring buffer with a power-of-two capacity.
+
+An SPSC queue has exactly one thread pushing and one thread popping (a command stream into the audio or loading thread).
+Both ends are wait-free: they never retry, they move what fits and return. The producer and the consumer each own one index,
+on a cache line of its own, and keep a copy of the other's index, so they only read the other's cache line when the queue looks full
+(or empty) by their copy.
+
+An MPMC queue can be pushed and popped by any number of threads (Dmitry Vyukov's bounded queue). Every cell holds a sequence number
+that says which lap around the ring it is ready for, so a thread claims a cell with one compare-exchange on the push (or pop) position
+and then fills (or empties) it without a lock. A thread that loses the race tries again at the new position.
+
+Both have batch versions (push_multiple, pop_multiple) that move as many values as fit with one update of the shared position,
+which is where most of the cost is. The buffer is allocated from the bump allocator passed to name##_create and never grows,
+pushing to a full queue (or popping from an empty one) moves nothing and returns false (or 0).
+
+usage:
+    DECLARE_SPSC_QUEUE(audio_commands, audio_command)
+    IMPLEMENT_SPSC_QUEUE(audio_commands, audio_command)
+
+    audio_commands_create(&audio->commands, allocator, 256);
+    audio_commands_push(&audio->commands, (audio_command){ .type = AUDIO_COMMAND_PLAY, .sound = sound }); // on the game thread
+    ...
+    audio_command command;
+    while (audio_commands_pop(&audio->commands, &command)) { ... } // on the audio thread
+*/
+
+#define CONCURRENT_QUEUE_CACHE_LINE 64
+
+// Allocates a cache-line aligned ring of capacity elements. capacity must be a power of two.
+void* allocate_concurrent_queue_buffer(bump_allocator* allocator, uint32_t capacity, size_t element_size);
+
+// Copies count elements into (or out of) the ring starting at position, wrapping around the end of the ring.
+static inline void copy_into_ring_buffer(void* ring, uint32_t mask, uint64_t position, const void* source, uint32_t count, size_t element_size) {
+    uint32_t index = (uint32_t)(position & mask);
+    uint32_t first = count < mask + 1 - index ? count : mask + 1 - index;
+    memcpy((uint8_t*)ring + (size_t)index * element_size, source, (size_t)first * element_size);
+    memcpy(ring, (const uint8_t*)source + (size_t)first * element_size, (size_t)(count - first) * element_size);
+}
+
+static inline void copy_out_of_ring_buffer(const void* ring, uint32_t mask, uint64_t position, void* destination, uint32_t count, size_t element_size) {
+    uint32_t index = (uint32_t)(position & mask);
+    uint32_t first = count < mask + 1 - index ? count : mask + 1 - index;
+    memcpy(destination, (const uint8_t*)ring + (size_t)index * element_size, (size_t)first * element_size);
+    memcpy((uint8_t*)destination + (size_t)first * element_size, ring, (size_t)(count - first) * element_size);
+}
+
+/*
+=====
+    SPSC queue
+=====
+Values live in [head, tail). Only the producer writes tail and cached_head, only the consumer writes head and cached_tail.
+*/
+
+#define DECLARE_SPSC_QUEUE(name, type) \
+    typedef struct { \
+        alignas(CONCURRENT_QUEUE_CACHE_LINE) atomic_uint64 head; \
+        uint64_t cached_tail; \
+        alignas(CONCURRENT_QUEUE_CACHE_LINE) atomic_uint64 tail; \
+        uint64_t cached_head; \
+        alignas(CONCURRENT_QUEUE_CACHE_LINE) type* elements; \
+        uint32_t mask; \
+    } name; \
+    result name##_create(name* queue, bump_allocator* allocator, uint32_t capacity); \
+    static inline bool name##_push(name* queue, type element) { \
+        DEBUG_ASSERT(queue != NULL, return false, "Queue " #name " cannot be NULL"); \
+        uint64_t tail = atomic_load_uint64(&queue->tail, MEMORY_ORDER_RELAXED); \
+        if (tail - queue->cached_head > queue->mask) { \
+            queue->cached_head = atomic_load_uint64(&queue->head, MEMORY_ORDER_ACQUIRE); \
+            if (tail - queue->cached_head > queue->mask) { \
+                return false; \
+            } \
+        } \
+        queue->elements[tail & queue->mask] = element; \
+        atomic_store_uint64(&queue->tail, tail + 1, MEMORY_ORDER_RELEASE); \
+        return true; \
+    } \
+    static inline bool name##_pop(name* queue, type* out_element) { \
+        DEBUG_ASSERT(queue != NULL && out_element != NULL, return false, "Queue " #name " and the output element cannot be NULL"); \
+        uint64_t head = atomic_load_uint64(&queue->head, MEMORY_ORDER_RELAXED); \
+        if (head == queue->cached_tail) { \
+            queue->cached_tail = atomic_load_uint64(&queue->tail, MEMORY_ORDER_ACQUIRE); \
+            if (head == queue->cached_tail) { \
+                return false; \
+            } \
+        } \
+        *out_element = queue->elements[head & queue->mask]; \
+        atomic_store_uint64(&queue->head, head + 1, MEMORY_ORDER_RELEASE); \
+        return true; \
+    } \
+    /* Pushes as many of the elements as fit, in order, and returns how many were pushed. */ \
+    static inline uint32_t name##_push_multiple(name* queue, const type* elements, uint32_t count) { \
+        DEBUG_ASSERT(queue != NULL && (elements != NULL || count == 0), return 0, "Queue " #name " and the elements cannot be NULL"); \
+        uint64_t tail = atomic_load_uint64(&queue->tail, MEMORY_ORDER_RELAXED); \
+        uint64_t capacity = (uint64_t)queue->mask + 1; \
+        if (tail - queue->cached_head + count > capacity) { \
+            queue->cached_head = atomic_load_uint64(&queue->head, MEMORY_ORDER_ACQUIRE); \
+        } \
+        uint64_t free_count = capacity - (tail - queue->cached_head); \
+        if (count > free_count) { \
+            count = (uint32_t)free_count; \
+        } \
+        copy_into_ring_buffer(queue->elements, queue->mask, tail, elements, count, sizeof(type)); \
+        atomic_store_uint64(&queue->tail, tail + count, MEMORY_ORDER_RELEASE); \
+        return count; \
+    } \
+    /* Pops up to max_count elements, oldest first, and returns how many were popped. */ \
+    static inline uint32_t name##_pop_multiple(name* queue, type* out_elements, uint32_t max_count) { \
+        DEBUG_ASSERT(queue != NULL && (out_elements != NULL || max_count == 0), return 0, "Queue " #name " and the output elements cannot be NULL"); \
+        uint64_t head = atomic_load_uint64(&queue->head, MEMORY_ORDER_RELAXED); \
+        if (queue->cached_tail - head < max_count) { \
+            queue->cached_tail = atomic_load_uint64(&queue->tail, MEMORY_ORDER_ACQUIRE); \
+        } \
+        uint64_t available = queue->cached_tail - head; \
+        uint32_t count = available < max_count ? (uint32_t)available : max_count; \
+        copy_out_of_ring_buffer(queue->elements, queue->mask, head, out_elements, count, sizeof(type)); \
+        atomic_store_uint64(&queue->head, head + count, MEMORY_ORDER_RELEASE); \
+        return count; \
+    }
+
+#define IMPLEMENT_SPSC_QUEUE(name, type) \
+    result name##_create(name* queue, bump_allocator* allocator, uint32_t capacity) { \
+        ASSERT(queue != NULL, return RESULT_FAILURE, "Queue " #name " cannot be NULL"); \
+        memset(queue, 0, sizeof(name)); \
+        queue->elements = (type*)allocate_concurrent_queue_buffer(allocator, capacity, sizeof(type)); \
+        if (queue->elements == NULL) { \
+            return RESULT_FAILURE; \
+        } \
+        queue->mask = capacity - 1; \
+        return RESULT_SUCCESS; \
+    }
+
+/*
+=====
+    MPMC queue
+=====
+A cell's sequence is its position when it is free for that lap, position + 1 once it holds a value, and position + capacity once
+the value has been taken (which is the position of the cell on the next lap, so it is free again).
+A claimed cell is only ever touched by the thread that claimed it, so the value needs no atomics, only the sequence that publishes it.
+*/
+
+#define DECLARE_MPMC_QUEUE(name, type) \
+    typedef struct { \
+        atomic_uint64 sequence; \
+        type value; \
+    } name##_cell; \
+    typedef struct { \
+        alignas(CONCURRENT_QUEUE_CACHE_LINE) atomic_uint64 push_position; \
+        alignas(CONCURRENT_QUEUE_CACHE_LINE) atomic_uint64 pop_position; \
+        alignas(CONCURRENT_QUEUE_CACHE_LINE) name##_cell* cells; \
+        uint32_t mask; \
+    } name; \
+    result name##_create(name* queue, bump_allocator* allocator, uint32_t capacity); \
+    static inline bool name##_push(name* queue, type element) { \
+        DEBUG_ASSERT(queue != NULL, return false, "Queue " #name " cannot be NULL"); \
+        uint64_t position = atomic_load_uint64(&queue->push_position, MEMORY_ORDER_RELAXED); \
+        for (;;) { \
+            name##_cell* cell = &queue->cells[position & queue->mask]; \
+            int64_t lap = (int64_t)(atomic_load_uint64(&cell->sequence, MEMORY_ORDER_ACQUIRE) - position); \
+            if (lap == 0) { \
+                /* A failed exchange loads the current position into position. */ \
+                if (atomic_compare_exchange_uint64(&queue->push_position, &position, position + 1, MEMORY_ORDER_RELAXED)) { \
+                    cell->value = element; \
+                    atomic_store_uint64(&cell->sequence, position + 1, MEMORY_ORDER_RELEASE); \
+                    return true; \
+                } \
+            } \
+            else if (lap < 0) { \
+                return false; /* the value from the last lap has not been taken yet, so the queue is full */ \
+            } \
+            else { \
+                position = atomic_load_uint64(&queue->push_position, MEMORY_ORDER_RELAXED); \
+            } \
+        } \
+    } \
+    static inline bool name##_pop(name* queue, type* out_element) { \
+        DEBUG_ASSERT(queue != NULL && out_element != NULL, return false, "Queue " #name " and the output element cannot be NULL"); \
+        uint64_t position = atomic_load_uint64(&queue->pop_position, MEMORY_ORDER_RELAXED); \
+        for (;;) { \
+            name##_cell* cell = &queue->cells[position & queue->mask]; \
+            int64_t lap = (int64_t)(atomic_load_uint64(&cell->sequence, MEMORY_ORDER_ACQUIRE) - (position + 1)); \
+            if (lap == 0) { \
+                if (atomic_compare_exchange_uint64(&queue->pop_position, &position, position + 1, MEMORY_ORDER_RELAXED)) { \
+                    *out_element = cell->value; \
+                    atomic_store_uint64(&cell->sequence, position + queue->mask + 1, MEMORY_ORDER_RELEASE); \
+                    return true; \
+                } \
+            } \
+            else if (lap < 0) { \
+                return false; /* nothing has been pushed to this position yet, so the queue is empty */ \
+            } \
+            else { \
+                position = atomic_load_uint64(&queue->pop_position, MEMORY_ORDER_RELAXED); \
+            } \
+        } \
+    } \
+    /* Claims the run of free cells at the push position with one exchange, and returns how many of the elements were pushed. */ \
+    static inline uint32_t name##_push_multiple(name* queue, const type* elements, uint32_t count) { \
+        DEBUG_ASSERT(queue != NULL && (elements != NULL || count == 0), return 0, "Queue " #name " and the elements cannot be NULL"); \
+        if (count == 0) { \
+            return 0; \
+        } \
+        uint64_t position = atomic_load_uint64(&queue->push_position, MEMORY_ORDER_RELAXED); \
+        for (;;) { \
+            int64_t lap = (int64_t)(atomic_load_uint64(&queue->cells[position & queue->mask].sequence, MEMORY_ORDER_ACQUIRE) - position); \
+            if (lap < 0) { \
+                return 0; \
+            } \
+            if (lap > 0) { \
+                position = atomic_load_uint64(&queue->push_position, MEMORY_ORDER_RELAXED); \
+                continue; \
+            } \
+            uint32_t claimed = 1; \
+            while (claimed < count \
+                && atomic_load_uint64(&queue->cells[(position + claimed) & queue->mask].sequence, MEMORY_ORDER_ACQUIRE) == position + claimed) { \
+                ++claimed; \
+            } \
+            if (atomic_compare_exchange_uint64(&queue->push_position, &position, position + claimed, MEMORY_ORDER_RELAXED)) { \
+                for (uint32_t i = 0; i < claimed; ++i) { \
+                    name##_cell* cell = &queue->cells[(position + i) & queue->mask]; \
+                    cell->value = elements[i]; \
+                    atomic_store_uint64(&cell->sequence, position + i + 1, MEMORY_ORDER_RELEASE); \
+                } \
+                return claimed; \
+            } \
+        } \
+    } \
+    /* Claims the run of full cells at the pop position with one exchange, and returns how many elements were popped. */ \
+    static inline uint32_t name##_pop_multiple(name* queue, type* out_elements, uint32_t max_count) { \
+        DEBUG_ASSERT(queue != NULL && (out_elements != NULL || max_count == 0), return 0, "Queue " #name " and the output elements cannot be NULL"); \
+        if (max_count == 0) { \
+            return 0; \
+        } \
+        uint64_t position = atomic_load_uint64(&queue->pop_position, MEMORY_ORDER_RELAXED); \
+        for (;;) { \
+            int64_t lap = (int64_t)(atomic_load_uint64(&queue->cells[position & queue->mask].sequence, MEMORY_ORDER_ACQUIRE) - (position + 1)); \
+            if (lap < 0) { \
+                return 0; \
+            } \
+            if (lap > 0) { \
+                position = atomic_load_uint64(&queue->pop_position, MEMORY_ORDER_RELAXED); \
+                continue; \
+            } \
+            uint32_t claimed = 1; \
+            while (claimed < max_count \
+                && atomic_load_uint64(&queue->cells[(position + claimed) & queue->mask].sequence, MEMORY_ORDER_ACQUIRE) == position + claimed + 1) { \
+                ++claimed; \
+            } \
+            if (atomic_compare_exchange_uint64(&queue->pop_position, &position, position + claimed, MEMORY_ORDER_RELAXED)) { \
+                for (uint32_t i = 0; i < claimed; ++i) { \
+                    name##_cell* cell = &queue->cells[(position + i) & queue->mask]; \
+                    out_elements[i] = cell->value; \
+                    atomic_store_uint64(&cell->sequence, position + i + queue->mask + 1, MEMORY_ORDER_RELEASE); \
+                } \
+                return claimed; \
+            } \
+        } \
+    }
+
+#define IMPLEMENT_MPMC_QUEUE(name, type) \
+    result name##_create(name* queue, bump_allocator* allocator, uint32_t capacity) { \
+        ASSERT(queue != NULL, return RESULT_FAILURE, "Queue " #name " cannot be NULL"); \
+        memset(queue, 0, sizeof(name)); \
+        queue->cells = (name##_cell*)allocate_concurrent_queue_buffer(allocator, capacity, sizeof(name##_cell)); \
+        if (queue->cells == NULL) { \
+            return RESULT_FAILURE; \
+        } \
+        for (uint32_t i = 0; i < capacity; ++i) { \
+            atomic_store_uint64(&queue->cells[i].sequence, i, MEMORY_ORDER_RELAXED); \
+        } \
+        queue->mask = capacity - 1; \
+        return RESULT_SUCCESS; \
+    }
+
+#endif // CONCURRENT_QUEUE_H
@@ -0,0 +1,47 @@
+#include "dynamic_array.h"
+
+result grow_dynamic_array(void** elements, uint32_t count, uint32_t* capacity, bump_allocator* allocator, size_t element_size, size_t alignment, uint32_t min_capacity) {
+    ASSERT(elements != NULL && capacity != NULL, return RESULT_FAILURE, "Dynamic array cannot be NULL");
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    if (min_capacity <= *capacity) {
+        return RESULT_SUCCESS;
+    }
+
+    uint64_t new_capacity = (uint64_t)*capacity * 2;
+    if (new_capacity < DYNAMIC_ARRAY_MIN_CAPACITY) {
+        new_capacity = DYNAMIC_ARRAY_MIN_CAPACITY;
+    }
+    if (new_capacity < min_capacity) {
+        new_capacity = min_capacity;
+    }
+    if (new_capacity > UINT32_MAX) {
+        new_capacity = UINT32_MAX;
+    }
+
+    uint8_t* elements_end = (uint8_t*)*elements + (size_t)*capacity * element_size;
+    if (*elements != NULL && elements_end == (uint8_t*)allocator->base + allocator->used_bytes) {
+        // The elements are the last allocation, so the allocator can grow under them. If doubling does not fit, take what is left.
+        uint64_t available = (allocator->capacity - allocator->used_bytes) / element_size + *capacity;
+        if (new_capacity > available && min_capacity <= available) {
+            new_capacity = available;
+        }
+        if (BUMP_ALLOCATE_TAGGED(allocator, 1, (size_t)(new_capacity - *capacity) * element_size, "dynamic_array") == NULL) {
+            return RESULT_FAILURE;
+        }
+        *capacity = (uint32_t)new_capacity;
+        return RESULT_SUCCESS;
+    }
+
+    DEBUG_ASSERT(*elements == NULL || ((uint8_t*)*elements >= (uint8_t*)allocator->base && elements_end <= (uint8_t*)allocator->base + allocator->used_bytes), ,
+        "Dynamic array at %p grown with an allocator it was not allocated from (or that was reset)", *elements);
+    void* moved = BUMP_ALLOCATE_TAGGED(allocator, alignment, (size_t)new_capacity * element_size, "dynamic_array");
+    if (moved == NULL) {
+        return RESULT_FAILURE;
+    }
+    if (count > 0) {
+        memcpy(moved, *elements, (size_t)count * element_size);
+    }
+    *elements = moved;
+    *capacity = (uint32_t)new_capacity;
+    return RESULT_SUCCESS;
+}
@@ -0,0 +1,162 @@
+#ifndef DYNAMIC_ARRAY_H
+#define DYNAMIC_ARRAY_H
+#include "platform_layer.h"
+
+/*
+A growable array in a bump allocator, for when the number of elements depends on content rather than on a compile-time cap.
+It has the same API as a capped array, except that functions that can grow it take the allocator to grow into (always the same one).
+The allocator is passed in rather than stored, so an array in perm holds no pointers out of perm (see save_arena_snapshot).
+
+When the array is full its capacity doubles. If the elements are the last allocation in the allocator they grow in place, otherwise
+they are copied to a new allocation and the old one is left until the allocator is reset. To make growth never copy, give the array
+a bump allocator of its own: the address space for the largest size is reserved up front, and memory is only committed as it grows.
+
+Initialize with { 0 } (the first append allocates), or reserve a capacity up front with name##_reserve.
+
+Slot maps, hash maps and structs of arrays grow the same way (with the same initialization and name##_reserve), so they refer here.
+
+usage:
+    DECLARE_DYNAMIC_ARRAY(asteroids, asteroid)
+    IMPLEMENT_DYNAMIC_ARRAY(asteroids, asteroid)
+
+    asteroids_append(&state->asteroids, &allocators->perm, new_asteroid);
+
+    // An array that never copies, with room for a million elements:
+    create_bump_allocator(&state->particle_arena, sizeof(particle) * 1000000);
+    particles_append(&state->particles, &state->particle_arena, new_particle);
+*/
+
+#define DYNAMIC_ARRAY_MIN_CAPACITY 16
+
+// Makes room for at least min_capacity elements, in place when the elements are the last allocation in the allocator.
+// Shared by every dynamic array (the macros pass in their element size and alignment).
+result grow_dynamic_array(void** elements, uint32_t count, uint32_t* capacity, bump_allocator* allocator, size_t element_size, size_t alignment, uint32_t min_capacity);
+
+#define DECLARE_DYNAMIC_ARRAY(name, element_type) \
+    typedef struct { \
+        element_type* elements; \
+        uint32_t count; \
+        uint32_t capacity; \
+    } name; \
+    result name##_reserve(name* array, bump_allocator* allocator, uint32_t capacity); \
+    result name##_append(name* array, bump_allocator* allocator, element_type element); \
+    result name##_append_multiple(name* array, bump_allocator* allocator, element_type* elements, uint32_t count); \
+    result name##_insert(name* array, bump_allocator* allocator, uint32_t index, element_type element); \
+    result name##_insert_multiple(name* array, bump_allocator* allocator, uint32_t index, element_type* elements, uint32_t count); \
+    result name##_remove(name* array, uint32_t index); \
+    result name##_remove_swap(name* array, uint32_t index); \
+    DECLARE_ARRAY_REMOVE_IF(name, element_type, "Dynamic array") \
+    bool name##_find(name* array, element_type element, uint32_t* out_index); \
+    static inline void name##_clear(name* array) { \
+        ASSERT(array != NULL, return, "Dynamic array " #name " cannot be NULL"); \
+        array->count = 0; \
+    } \
+    static inline element_type* name##_bounds_checked_lookup(name* array, element_type* fallback, uint32_t index) { \
+        ASSERT(array != NULL, return fallback, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(index < array->count, return fallback, "Index out of bounds: %u. Count = %u", index, array->count); \
+        return &array->elements[index]; \
+    } \
+    static inline result name##_bounds_checked_get(name* array, uint32_t index, element_type* out_element) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(out_element != NULL, return RESULT_FAILURE, "Output element pointer cannot be NULL"); \
+        ASSERT(index < array->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, array->count); \
+        memcpy(out_element, &array->elements[index], sizeof(element_type)); \
+        return RESULT_SUCCESS; \
+    } \
+    static inline result name##_bounds_checked_set(name* array, uint32_t index, element_type value) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(index < array->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, array->count); \
+        memcpy(&array->elements[index], &value, sizeof(element_type)); \
+        return RESULT_SUCCESS; \
+    }
+
+#define IMPLEMENT_DYNAMIC_ARRAY(name, element_type) \
+    result name##_reserve(name* array, bump_allocator* allocator, uint32_t capacity) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        if (capacity <= array->capacity) { \
+            return RESULT_SUCCESS; \
+        } \
+        void* elements = array->elements; \
+        if (grow_dynamic_array(&elements, array->count, &array->capacity, allocator, sizeof(element_type), alignof(element_type), capacity) != RESULT_SUCCESS) { \
+            BUG("Dynamic array " #name " failed to grow to %u elements", capacity); \
+            return RESULT_FAILURE; \
+        } \
+        array->elements = (element_type*)elements; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_insert(name* array, bump_allocator* allocator, uint32_t index, element_type element) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(index <= array->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, array->count); \
+        if (name##_reserve(array, allocator, array->count + 1) != RESULT_SUCCESS) { \
+            return RESULT_FAILURE; \
+        } \
+        if (index < array->count) { \
+            memmove(&array->elements[index + 1], &array->elements[index], (array->count - index) * sizeof(element_type)); \
+        } \
+        memcpy(&array->elements[index], &element, sizeof(element_type)); \
+        ++array->count; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_insert_multiple(name* array, bump_allocator* allocator, uint32_t index, element_type* elements, uint32_t count) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(index <= array->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, array->count); \
+        ASSERT(count <= UINT32_MAX - array->count, return RESULT_FAILURE, "Dynamic array " #name " cannot hold more than %u elements", UINT32_MAX); \
+        if (name##_reserve(array, allocator, array->count + count) != RESULT_SUCCESS) { \
+            return RESULT_FAILURE; \
+        } \
+        if (index < array->count) { \
+            memmove(&array->elements[index + count], &array->elements[index], (array->count - index) * sizeof(element_type)); \
+        } \
+        memcpy(&array->elements[index], elements, count * sizeof(element_type)); \
+        array->count += count; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_append(name* array, bump_allocator* allocator, element_type element) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        if (array->count == array->capacity && name##_reserve(array, allocator, array->count + 1) != RESULT_SUCCESS) { \
+            return RESULT_FAILURE; \
+        } \
+        memcpy(&array->elements[array->count++], &element, sizeof(element_type)); \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_append_multiple(name* array, bump_allocator* allocator, element_type* elements, uint32_t count) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(count <= UINT32_MAX - array->count, return RESULT_FAILURE, "Dynamic array " #name " cannot hold more than %u elements", UINT32_MAX); \
+        if (name##_reserve(array, allocator, array->count + count) != RESULT_SUCCESS) { \
+            return RESULT_FAILURE; \
+        } \
+        memcpy(&array->elements[array->count], elements, count * sizeof(element_type)); \
+        array->count += count; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_remove(name* array, uint32_t index) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(index < array->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, array->count); \
+        if (index != array->count - 1) { \
+            memmove(&array->elements[index], &array->elements[index + 1], (array->count - index - 1) * sizeof(element_type)); \
+        } \
+        --array->count; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_remove_swap(name* array, uint32_t index) { \
+        ASSERT(array != NULL, return RESULT_FAILURE, "Dynamic array " #name " cannot be NULL"); \
+        ASSERT(index < array->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, array->count); \
+        if (index != array->count - 1) { \
+            memcpy(&array->elements[index], &array->elements[array->count - 1], sizeof(element_type)); \
+        } \
+        --array->count; \
+        return RESULT_SUCCESS; \
+    } \
+    bool name##_find(name* array, element_type element, uint32_t* out_index) { \
+        ASSERT(array != NULL, return false, "Dynamic array " #name " cannot be NULL"); \
+        uint32_t index = find_element(array->elements, array->count, &element, sizeof(element_type)); \
+        if (index == array->count) { \
+            return false; \
+        } \
+        if (out_index) { \
+            *out_index = index; \
+        } \
+        return true; \
+    }
+
+#endif // DYNAMIC_ARRAY_H
@@ -5,6 +5,44 @@
 // #define ENABLE_GRID_RENDERER
 // #define ENABLE_CIRCLE_RENDERER
 
+// Records PROFILE_SCOPE/PROFILE_BEGIN/PROFILE_END timings (see profiler.h), the trace is written next to the executable on exit.
+// #define ENABLE_PROFILER
+
+// Keeps rolling frame/update/draw time percentiles (see frame_statistics.h), printed on exit and with FRAME_STATISTICS_DUMP_KEY.
+// #define ENABLE_FRAME_STATISTICS
+
+// Tracks arena high-water marks and usage per allocation tag (see platform_layer.h), reported on exit.
+// #define ENABLE_MEMORY_ACCOUNTING
+
+// Arena sizes (address space is reserved up front, memory is committed as the arenas grow).
+#define PERM_ARENA_CAPACITY (1024ull * 1024 * 1024)
+#define TEMP_ARENA_CAPACITY (64 * 1024 * 1024)
+
+// Temp memory committed above this is given back to the system when temp is reset at the start of the next frame.
+#define TEMP_ARENA_KEEP_COMMITTED_BYTES (16 * 1024 * 1024)
+
+// Frame arenas hold data for FRAME_ARENA_COUNT frames (see memory_allocators). It should be at least the number of frames the GPU can have in flight.
+#define FRAME_ARENA_COUNT 2
+#define FRAME_ARENA_CAPACITY (64 * 1024 * 1024)
+
+// Backs the perm arena with 2 MiB pages. On Windows this commits (and locks) the whole arena up front, and needs the "Lock pages in memory" privilege.
+// #define ENABLE_HUGE_PAGE_ARENAS
+
+// Saves the game's part of the perm arena to PERM_SNAPSHOT_FILE_NAME (next to the executable) with PERM_SNAPSHOT_SAVE_KEY,
+// and restores it with PERM_SNAPSHOT_LOAD_KEY (see save_arena_snapshot). Bump PERM_SNAPSHOT_VERSION when game_state changes.
+// Loading replaces the live game state with the file's, so only enable this for development builds.
+// #define ENABLE_PERM_SNAPSHOTS
+#define PERM_SNAPSHOT_SAVE_KEY KEY_F5
+#define PERM_SNAPSHOT_LOAD_KEY KEY_F9
+#define PERM_SNAPSHOT_FILE_NAME "perm_snapshot.bin"
+#define PERM_SNAPSHOT_VERSION 3
+
+// Restores the perm snapshot (if there is one) straight after init when the game starts.
+// #define LOAD_PERM_SNAPSHOT_ON_LAUNCH
+
+// Snapshots only load into an arena at the address they were saved from, so perm asks for the same address every launch.
+#define PERM_ARENA_BASE_ADDRESS ((void*)0x100000000000ull)
+
 
 
 
@@ -0,0 +1,110 @@
+#include "frame_pacer.h"
+
+static uint64_t milliseconds_to_ticks(double milliseconds) {
+    return (uint64_t)(milliseconds * 0.001 * (double)get_timestamp_frequency());
+}
+
+void create_frame_pacer(frame_pacer* pacer, uint32_t target_frame_rate) {
+    ASSERT(pacer != NULL, return, "Frame pacer cannot be NULL");
+    memset(pacer, 0, sizeof(frame_pacer));
+
+    if (target_frame_rate == 0) {
+        target_frame_rate = DEFAULT_TARGET_FRAME_RATE;
+    }
+
+    if (target_frame_rate != FRAME_RATE_UNLIMITED) {
+        pacer->frame_ticks = get_timestamp_frequency() / target_frame_rate;
+    }
+    pacer->spin_ticks = milliseconds_to_ticks(FRAME_PACER_INITIAL_SPIN_MILLISECONDS);
+}
+
+void wait_for_next_frame(frame_pacer* pacer) {
+    ASSERT(pacer != NULL, return, "Frame pacer cannot be NULL");
+    if (pacer->frame_ticks == 0) {
+        return;
+    }
+
+    uint64_t now = read_timestamp();
+    if (pacer->next_deadline == 0) {
+        pacer->next_deadline = now + pacer->frame_ticks;
+    }
+
+    if (now < pacer->next_deadline) {
+        uint64_t remaining = pacer->next_deadline - now;
+        uint64_t oversleep = 0;
+        if (remaining > pacer->spin_ticks) {
+            uint64_t requested_sleep = remaining - pacer->spin_ticks;
+            sleep_for_ticks(requested_sleep);
+            uint64_t woke = read_timestamp();
+            pacer->total_sleep_ticks += woke - now;
+            oversleep = (woke - now) > requested_sleep ? (woke - now) - requested_sleep : 0;
+            now = woke;
+        }
+
+        // Adapt the spin margin to the OS: grow straight away when it oversleeps, shrink slowly otherwise
+        // (including frames that only spun, so that one bad wake up does not stop the pacer from sleeping for good).
+        uint64_t margin = oversleep + oversleep / 2;
+        if (margin > pacer->spin_ticks) {
+            pacer->spin_ticks = margin;
+        }
+        else {
+            pacer->spin_ticks -= (pacer->spin_ticks - margin) / 16;
+        }
+
+        uint64_t min_spin_ticks = milliseconds_to_ticks(FRAME_PACER_MIN_SPIN_MILLISECONDS);
+        if (pacer->spin_ticks < min_spin_ticks) {
+            pacer->spin_ticks = min_spin_ticks;
+        }
+        if (pacer->spin_ticks > pacer->frame_ticks / 2) {
+            pacer->spin_ticks = pacer->frame_ticks / 2;
+        }
+
+        uint64_t spin_start = now;
+        while (now < pacer->next_deadline) {
+            CPU_RELAX();
+            now = read_timestamp();
+        }
+        pacer->total_spin_ticks += now - spin_start;
+    }
+
+    uint64_t error = now - pacer->next_deadline;
+    ++pacer->frames_paced;
+    pacer->total_error_ticks += error;
+    if (error > pacer->max_error_ticks) {
+        pacer->max_error_ticks = error;
+    }
+    if (error > milliseconds_to_ticks(FRAME_PACER_LATE_MILLISECONDS)) {
+        ++pacer->late_frames;
+    }
+
+    if (error >= pacer->frame_ticks) {
+        // Too far behind, start a new grid from now rather than running the next frames back to back.
+        ++pacer->missed_deadlines;
+        pacer->next_deadline = now + pacer->frame_ticks;
+    }
+    else {
+        pacer->next_deadline += pacer->frame_ticks;
+    }
+}
+
+void print_frame_pacer_report(const frame_pacer* pacer) {
+    ASSERT(pacer != NULL, return, "Frame pacer cannot be NULL");
+    if (pacer->frame_ticks == 0) {
+        printf("Frame pacing: unlimited frame rate\n");
+        fflush(stdout);
+        return;
+    }
+
+    double frames = pacer->frames_paced > 0 ? (double)pacer->frames_paced : 1.0;
+    double waiting_ticks = (double)(pacer->total_sleep_ticks + pacer->total_spin_ticks);
+    printf("Frame pacing: %.2f fps target over %llu frames, error mean %.3f ms, max %.3f ms, %llu late (> %.2f ms), %llu missed deadlines\n",
+        (double)get_timestamp_frequency() / (double)pacer->frame_ticks, (unsigned long long)pacer->frames_paced,
+        timestamp_to_seconds(pacer->total_error_ticks) * 1000.0 / frames, timestamp_to_seconds(pacer->max_error_ticks) * 1000.0,
+        (unsigned long long)pacer->late_frames, FRAME_PACER_LATE_MILLISECONDS, (unsigned long long)pacer->missed_deadlines);
+    printf("Frame pacing: waited %.3f ms per frame, %.1f%% sleeping, %.1f%% spinning (spin margin %.3f ms)\n",
+        timestamp_to_seconds((uint64_t)waiting_ticks) * 1000.0 / frames,
+        waiting_ticks > 0.0 ? 100.0 * (double)pacer->total_sleep_ticks / waiting_ticks : 0.0,
+        waiting_ticks > 0.0 ? 100.0 * (double)pacer->total_spin_ticks / waiting_ticks : 0.0,
+        timestamp_to_seconds(pacer->spin_ticks) * 1000.0);
+    fflush(stdout);
+}
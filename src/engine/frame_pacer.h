@@ -0,0 +1,52 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+#include "platform_layer.h"
+
+/*
+Holds the main loop to a target frame rate without burning a CPU core.
+OS sleeps are cheap but coarse (they can oversleep by a scheduler quantum), and spinning is precise but keeps the core busy.
+So the pacer sleeps until it is close to the next frame's deadline and then spins for the rest.
+The spin margin adapts to how much the OS has been oversleeping, so it stays short on systems with precise timers.
+
+Deadlines are scheduled on a fixed grid (one frame period apart), so small errors do not accumulate. If a frame runs later
+than a whole period the grid is restarted from the current time instead of rushing frames to catch up.
+*/
+
+#ifndef FRAME_PACER_MIN_SPIN_MILLISECONDS
+#define FRAME_PACER_MIN_SPIN_MILLISECONDS 0.25
+#endif
+
+#ifndef FRAME_PACER_INITIAL_SPIN_MILLISECONDS
+#define FRAME_PACER_INITIAL_SPIN_MILLISECONDS 2.0
+#endif
+
+// A frame that starts later than this after its deadline is counted as late in the pacing report.
+#ifndef FRAME_PACER_LATE_MILLISECONDS
+#define FRAME_PACER_LATE_MILLISECONDS 1.0
+#endif
+
+typedef struct {
+    uint64_t frame_ticks; // 0 when the frame rate is unlimited
+    uint64_t spin_ticks;
+    uint64_t next_deadline;
+
+    // Pacing report: how far after its deadline each frame actually started, and where the waiting time went.
+    uint64_t frames_paced;
+    uint64_t late_frames;
+    uint64_t missed_deadlines; // frames that were more than a whole period late (the grid was restarted)
+    uint64_t total_error_ticks;
+    uint64_t max_error_ticks;
+    uint64_t total_sleep_ticks;
+    uint64_t total_spin_ticks;
+} frame_pacer;
+
+// A target_frame_rate of 0 uses DEFAULT_TARGET_FRAME_RATE, and FRAME_RATE_UNLIMITED disables pacing.
+void create_frame_pacer(frame_pacer* pacer, uint32_t target_frame_rate);
+
+// Call once per frame (after presenting), returns when the next frame should start.
+void wait_for_next_frame(frame_pacer* pacer);
+
+// Prints the pacing error and the split of waiting time between sleeping and spinning to stdout.
+void print_frame_pacer_report(const frame_pacer* pacer);
+
+#endif // FRAME_PACER_H
@@ -0,0 +1,157 @@
+#include "frame_statistics.h"
+
+static const char* frame_metric_names[FRAME_METRIC_COUNT] = {
+    [FRAME_METRIC_FRAME] = "frame",
+    [FRAME_METRIC_UPDATE] = "update",
+    [FRAME_METRIC_DRAW] = "draw",
+};
+
+static uint32_t bucket_of(float milliseconds) {
+    if (milliseconds <= 0.0f) {
+        return 0;
+    }
+
+    float bucket = milliseconds / FRAME_STATISTICS_BUCKET_MILLISECONDS;
+    return bucket >= (float)(FRAME_STATISTICS_BUCKET_COUNT - 1) ? FRAME_STATISTICS_BUCKET_COUNT - 1 : (uint32_t)bucket;
+}
+
+result create_frame_statistics(frame_statistics* statistics, bump_allocator* allocator, uint32_t window_frames, float hitch_milliseconds) {
+    ASSERT(statistics != NULL, return RESULT_FAILURE, "Frame statistics cannot be NULL");
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(window_frames > 0, return RESULT_FAILURE, "Frame statistics window must contain at least one frame");
+
+    memset(statistics, 0, sizeof(frame_statistics));
+    statistics->window_frames = window_frames;
+    statistics->hitch_milliseconds = hitch_milliseconds;
+
+    for (uint32_t i = 0; i < FRAME_METRIC_COUNT; ++i) {
+        statistics->metrics[i].samples = (float*)BUMP_ALLOCATE_TAGGED(allocator, alignof(float), sizeof(float) * window_frames, "frame_statistics");
+        if (statistics->metrics[i].samples == NULL) {
+            BUG("Failed to allocate frame statistics window.");
+            return RESULT_FAILURE;
+        }
+    }
+
+    return RESULT_SUCCESS;
+}
+
+void record_frame_statistics(frame_statistics* statistics, float frame_milliseconds, float update_milliseconds, float draw_milliseconds) {
+    ASSERT(statistics != NULL, return, "Frame statistics cannot be NULL");
+    const float milliseconds[FRAME_METRIC_COUNT] = {
+        [FRAME_METRIC_FRAME] = frame_milliseconds,
+        [FRAME_METRIC_UPDATE] = update_milliseconds,
+        [FRAME_METRIC_DRAW] = draw_milliseconds,
+    };
+
+    bool is_window_full = statistics->sample_count == statistics->window_frames;
+    for (uint32_t i = 0; i < FRAME_METRIC_COUNT; ++i) {
+        frame_metric_history* history = &statistics->metrics[i];
+        if (is_window_full) {
+            // The oldest sample leaves the window.
+            --history->buckets[bucket_of(history->samples[statistics->next_sample])];
+        }
+
+        history->samples[statistics->next_sample] = milliseconds[i];
+        ++history->buckets[bucket_of(milliseconds[i])];
+        if (milliseconds[i] > statistics->hitch_milliseconds) {
+            ++history->hitches_since_creation;
+        }
+    }
+
+    if (!is_window_full) {
+        ++statistics->sample_count;
+    }
+
+    statistics->next_sample = (statistics->next_sample + 1) % statistics->window_frames;
+    ++statistics->frames_since_creation;
+}
+
+// Nearest-rank percentile from the histogram, reported as the middle of the bucket (but never above the true maximum).
+static float histogram_percentile(const frame_metric_history* history, uint32_t sample_count, float fraction, float max) {
+    uint32_t rank = (uint32_t)(fraction * (float)sample_count + 0.999f);
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint32_t cumulative = 0;
+    for (uint32_t bucket = 0; bucket < FRAME_STATISTICS_BUCKET_COUNT; ++bucket) {
+        cumulative += history->buckets[bucket];
+        if (cumulative >= rank) {
+            float milliseconds = ((float)bucket + 0.5f) * FRAME_STATISTICS_BUCKET_MILLISECONDS;
+            return (bucket == FRAME_STATISTICS_BUCKET_COUNT - 1 || milliseconds > max) ? max : milliseconds;
+        }
+    }
+
+    return max;
+}
+
+frame_metric_summary summarize_frame_metric(const frame_statistics* statistics, frame_metric metric) {
+    frame_metric_summary summary = { 0 };
+    ASSERT(statistics != NULL, return summary, "Frame statistics cannot be NULL");
+    ASSERT(metric < FRAME_METRIC_COUNT, return summary, "Invalid frame metric: %u", (uint32_t)metric);
+
+    const frame_metric_history* history = &statistics->metrics[metric];
+    summary.hitches_since_creation = history->hitches_since_creation;
+    if (statistics->sample_count == 0) {
+        return summary;
+    }
+
+    for (uint32_t i = 0; i < statistics->sample_count; ++i) {
+        float sample = history->samples[i];
+        if (sample > summary.max) {
+            summary.max = sample;
+        }
+        if (sample > statistics->hitch_milliseconds) {
+            ++summary.hitches;
+        }
+    }
+
+    summary.p50 = histogram_percentile(history, statistics->sample_count, 0.50f, summary.max);
+    summary.p95 = histogram_percentile(history, statistics->sample_count, 0.95f, summary.max);
+    summary.p99 = histogram_percentile(history, statistics->sample_count, 0.99f, summary.max);
+    return summary;
+}
+
+void print_frame_statistics(const frame_statistics* statistics) {
+    ASSERT(statistics != NULL, return, "Frame statistics cannot be NULL");
+
+    printf("Frame statistics over the last %u of %llu frames (ms, hitch > %.2f ms):\n",
+        statistics->sample_count, (unsigned long long)statistics->frames_since_creation, statistics->hitch_milliseconds);
+    printf("%-8s %9s %9s %9s %9s %9s %14s\n", "metric", "p50", "p95", "p99", "max", "hitches", "total hitches");
+    for (uint32_t i = 0; i < FRAME_METRIC_COUNT; ++i) {
+        frame_metric_summary summary = summarize_frame_metric(statistics, (frame_metric)i);
+        printf("%-8s %9.3f %9.3f %9.3f %9.3f %9u %14llu\n", frame_metric_names[i],
+            summary.p50, summary.p95, summary.p99, summary.max, summary.hitches, (unsigned long long)summary.hitches_since_creation);
+    }
+    fflush(stdout);
+}
+
+void draw_frame_statistics_overlay(const frame_statistics* statistics, graphics* graphics, vector2 top_left, float bar_width, vector2int sample_point, vector2int sample_size) {
+    ASSERT(statistics != NULL, return, "Frame statistics cannot be NULL");
+    ASSERT(graphics != NULL, return, "Graphics cannot be NULL");
+
+    const float bar_height = 4.0f;
+    const float row_spacing = 2.0f;
+    const float metric_spacing = 6.0f;
+    float y = top_left.y;
+
+    for (uint32_t i = 0; i < FRAME_METRIC_COUNT; ++i) {
+        frame_metric_summary summary = summarize_frame_metric(statistics, (frame_metric)i);
+        const float values[] = { summary.p50, summary.p95, summary.p99, summary.max };
+        for (uint32_t v = 0; v < ARRAY_LENGTH(values); ++v) {
+            // A full bar is the hitch threshold, anything longer is clamped to twice the width.
+            float fraction = statistics->hitch_milliseconds > 0.0f ? values[v] / statistics->hitch_milliseconds : 0.0f;
+            if (fraction > 2.0f) {
+                fraction = 2.0f;
+            }
+
+            float width = bar_width * fraction;
+            if (width > 0.0f) {
+                vector2 center = { top_left.x + width * 0.5f, y + bar_height * 0.5f };
+                draw_sprite(graphics, center, (vector2) { width, bar_height }, sample_point, sample_size, 0.0f);
+            }
+            y += bar_height + row_spacing;
+        }
+        y += metric_spacing;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef FRAME_STATISTICS_H
+#define FRAME_STATISTICS_H
+#include "engine_config.h"
+#include "platform_layer.h"
+
+/*
+Frame-time statistics. Every frame the frame, update and draw times are recorded into a rolling window of the most recent frames.
+Each metric keeps a histogram of the window (updated as samples enter and leave it), so percentiles are cheap to compute at any time.
+Averages hide hitches, so the report is in percentiles (p50/p95/p99), the maximum, and the number of frames over the hitch threshold.
+*/
+
+#ifndef FRAME_STATISTICS_WINDOW_FRAMES
+#define FRAME_STATISTICS_WINDOW_FRAMES 600 // ten seconds at 60 frames per second
+#endif
+
+#ifndef FRAME_STATISTICS_HITCH_MILLISECONDS
+#define FRAME_STATISTICS_HITCH_MILLISECONDS (FIXED_TIME_STEP * 1000.0f * 1.5f)
+#endif
+
+// Histogram resolution. Samples beyond the last bucket are counted in the last bucket (their exact value is still used for the maximum).
+#define FRAME_STATISTICS_BUCKET_MILLISECONDS 0.1f
+#define FRAME_STATISTICS_BUCKET_COUNT 1024
+
+#define FRAME_STATISTICS_DUMP_KEY KEY_F3
+#define FRAME_STATISTICS_OVERLAY_KEY KEY_F4
+
+// The part of the sprite sheet used to draw the overlay bars.
+#ifndef FRAME_STATISTICS_OVERLAY_SAMPLE_POINT
+#define FRAME_STATISTICS_OVERLAY_SAMPLE_POINT (vector2int){ 0, 0 }
+#define FRAME_STATISTICS_OVERLAY_SAMPLE_SIZE (vector2int){ 1, 1 }
+#endif
+
+typedef enum {
+    FRAME_METRIC_FRAME,
+    FRAME_METRIC_UPDATE,
+    FRAME_METRIC_DRAW,
+    FRAME_METRIC_COUNT,
+} frame_metric;
+
+typedef struct {
+    float* samples; // ring buffer of the last window_frames samples, in milliseconds
+    uint32_t buckets[FRAME_STATISTICS_BUCKET_COUNT];
+    uint64_t hitches_since_creation;
+} frame_metric_history;
+
+typedef struct {
+    frame_metric_history metrics[FRAME_METRIC_COUNT];
+    uint32_t window_frames;
+    uint32_t sample_count; // number of samples in the window, up to window_frames
+    uint32_t next_sample;
+    uint64_t frames_since_creation;
+    float hitch_milliseconds;
+    bool is_overlay_visible;
+} frame_statistics;
+
+typedef struct {
+    float p50;
+    float p95;
+    float p99;
+    float max;
+    uint32_t hitches; // frames in the window that took longer than the hitch threshold
+    uint64_t hitches_since_creation;
+} frame_metric_summary;
+
+result create_frame_statistics(frame_statistics* statistics, bump_allocator* allocator, uint32_t window_frames, float hitch_milliseconds);
+void record_frame_statistics(frame_statistics* statistics, float frame_milliseconds, float update_milliseconds, float draw_milliseconds);
+frame_metric_summary summarize_frame_metric(const frame_statistics* statistics, frame_metric metric);
+
+// Prints a summary of every metric to stdout.
+void print_frame_statistics(const frame_statistics* statistics);
+
+/*
+Draws the summary as bars, one row per metric (p50, p95, p99 and max), scaled so that the hitch threshold is a full bar.
+The engine has no font rendering, so the bars are drawn with a sprite from the sprite sheet (a solid color region works best).
+Uses 4 * FRAME_METRIC_COUNT sprites of the MAX_SPRITES budget.
+*/
+void draw_frame_statistics_overlay(const frame_statistics* statistics, graphics* graphics, vector2 top_left, float bar_width, vector2int sample_point, vector2int sample_size);
+
+#endif // FRAME_STATISTICS_H
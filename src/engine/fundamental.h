@@ -41,6 +41,121 @@
 
 #define STATIC_ASSERT(condition, message) typedef uint8_t static_assertion_##message[(condition) ? 1 : -1];
 
+#if defined(_MSC_VER)
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+// Hint to the CPU that this is a spin-wait loop (saves power, and frees resources for the other hyper-thread).
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define CPU_RELAX() _mm_pause()
+#elif defined(__x86_64__) || defined(__i386__)
+#define CPU_RELAX() __builtin_ia32_pause()
+#elif defined(__aarch64__)
+#define CPU_RELAX() __asm__ volatile("yield")
+#else
+#define CPU_RELAX() ((void)0)
+#endif
+
+// Index of the lowest and the highest set bit. The value must not be zero.
+#if defined(_MSC_VER)
+#include <intrin.h>
+static inline uint32_t lowest_set_bit(uint64_t value) {
+    unsigned long index;
+    _BitScanForward64(&index, value);
+    return (uint32_t)index;
+}
+
+static inline uint32_t highest_set_bit(uint64_t value) {
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return (uint32_t)index;
+}
+#else
+static inline uint32_t lowest_set_bit(uint64_t value) {
+    return (uint32_t)__builtin_ctzll(value);
+}
+
+static inline uint32_t highest_set_bit(uint64_t value) {
+    return 63u - (uint32_t)__builtin_clzll(value);
+}
+#endif
+
+// Number of set bits. Without the POPCNT instruction enabled, GCC and Clang would call a library function, so the bits are added up in place.
+#if defined(_MSC_VER)
+static inline uint32_t count_set_bits(uint64_t value) {
+    return (uint32_t)__popcnt64(value);
+}
+#elif defined(__POPCNT__)
+static inline uint32_t count_set_bits(uint64_t value) {
+    return (uint32_t)__builtin_popcountll(value);
+}
+#else
+static inline uint32_t count_set_bits(uint64_t value) {
+    value -= (value >> 1) & 0x5555555555555555ull;
+    value = (value & 0x3333333333333333ull) + ((value >> 2) & 0x3333333333333333ull);
+    value = (value + (value >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+    return (uint32_t)((value * 0x0101010101010101ull) >> 56);
+}
+#endif
+
+#if defined(_MSC_VER)
+#define FORCE_INLINE __forceinline
+#else
+#define FORCE_INLINE inline __attribute__((always_inline))
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HAS_SSE2
+#endif
+
+// Index of the first element that is bytewise equal to *element, or count if there is none (the same answer as a memcmp loop).
+// Elements of 1, 2, 4 or 8 bytes are compared 64 bytes at a time with SSE2: the bytes are compared, and an element matches
+// when all of its bytes do. It is always inlined, so element_size is a constant and only one path is compiled in.
+static FORCE_INLINE uint32_t find_element(const void* elements, uint32_t count, const void* element, size_t element_size) {
+    const uint8_t* bytes = (const uint8_t*)elements;
+    uint32_t i = 0;
+#ifdef HAS_SSE2
+    if (element_size == 1 || element_size == 2 || element_size == 4 || element_size == 8) {
+        uint64_t value = 0;
+        memcpy(&value, element, element_size < sizeof(value) ? element_size : sizeof(value));
+        uint64_t pattern = element_size == 1 ? value * 0x0101010101010101ull
+            : element_size == 2 ? value * 0x0001000100010001ull
+            : element_size == 4 ? value * 0x0000000100000001ull
+            : value;
+        uint64_t element_starts = element_size == 1 ? ~0ull
+            : element_size == 2 ? 0x5555555555555555ull
+            : element_size == 4 ? 0x1111111111111111ull
+            : 0x0101010101010101ull;
+        __m128i target = _mm_set1_epi64x((long long)pattern);
+        uint32_t per_block = 64 / (uint32_t)element_size;
+        for (; i + per_block <= count; i += per_block) {
+            const __m128i* block = (const __m128i*)(bytes + (size_t)i * element_size);
+            uint64_t equal = (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block), target))
+                | (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 1), target)) << 16
+                | (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 2), target)) << 32
+                | (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128(block + 3), target)) << 48;
+            for (size_t shift = 1; shift < element_size; shift *= 2) {
+                equal &= equal >> shift; // the bit at the start of each element ends up as the AND of all its bytes
+            }
+            equal &= element_starts;
+            if (equal != 0) {
+                return i + lowest_set_bit(equal) / (uint32_t)element_size;
+            }
+        }
+    }
+#endif
+    for (; i < count; ++i) {
+        if (memcmp(bytes + (size_t)i * element_size, element, element_size) == 0) {
+            return i;
+        }
+    }
+    return count;
+}
+
 #ifdef WIN32
 #define DLL_EXPORT __declspec(dllexport)
 #else
@@ -103,6 +218,28 @@ result string_format(string_format_buffer* out_format_string, string format, ...
         .count = ARRAY_LENGTH(array) \
     }
 
+// Declares name##_predicate and name##_remove_if for an array type with elements and count (capped and dynamic arrays).
+// remove_if removes every element the predicate returns true for in one pass, keeping the order of the rest, and returns how many
+// were removed. It is inline so that a predicate known at the call site can be inlined into the loop.
+#define DECLARE_ARRAY_REMOVE_IF(name, element_type, kind) \
+    typedef bool (*name##_predicate)(const element_type* element, void* context); \
+    static inline uint32_t name##_remove_if(name* array, name##_predicate predicate, void* context) { \
+        ASSERT(array != NULL, return 0, kind " " #name " cannot be NULL"); \
+        ASSERT(predicate != NULL, return 0, "Predicate cannot be NULL"); \
+        uint32_t kept = 0; \
+        for (uint32_t i = 0; i < array->count; ++i) { \
+            if (!predicate(&array->elements[i], context)) { \
+                if (kept != i) { \
+                    memcpy(&array->elements[kept], &array->elements[i], sizeof(element_type)); \
+                } \
+                ++kept; \
+            } \
+        } \
+        uint32_t removed = array->count - kept; \
+        array->count = kept; \
+        return removed; \
+    }
+
 #define DECLARE_CAPPED_ARRAY(name, element_type, capacity) \
     typedef struct { \
         element_type elements[capacity]; \
@@ -114,6 +251,7 @@ result string_format(string_format_buffer* out_format_string, string format, ...
     result name##_insert_multiple(name* array, uint32_t index, element_type* elements, uint32_t count); \
     result name##_remove(name* array, uint32_t index); \
     result name##_remove_swap(name* array, uint32_t index); \
+    DECLARE_ARRAY_REMOVE_IF(name, element_type, "Capped array") \
     bool name##_find(name* array, element_type element, uint32_t* out_index); \
     static inline void name##_clear(name* array) { \
         ASSERT(array != NULL, return, "Capped array " #name " cannot be NULL"); \
@@ -178,7 +316,7 @@ result string_format(string_format_buffer* out_format_string, string format, ...
         ASSERT(array != NULL, return RESULT_FAILURE, "Capped array " #name " cannot be NULL"); \
         ASSERT(index < array->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, array->count); \
         if (index != array->count - 1) { \
-            memmove(&array->elements[index], &array->elements[index + 1], (array->count - (index - 1)) * sizeof(element_type)); \
+            memmove(&array->elements[index], &array->elements[index + 1], (array->count - index - 1) * sizeof(element_type)); \
         } \
         --array->count; \
         return RESULT_SUCCESS; \
@@ -194,15 +332,14 @@ result string_format(string_format_buffer* out_format_string, string format, ...
     } \
     bool name##_find(name* array, element_type element, uint32_t* out_index) {\
         ASSERT(array != NULL, return false, "Capped array " #name " cannot be NULL"); \
-        for (uint32_t i = 0; i < array->count; ++i) { \
-            if (memcmp(&array->elements[i], &element, sizeof(element_type)) == 0) { \
-                if (out_index) { \
-                    *out_index = i; \
-                } \
-                return true; \
-            } \
+        uint32_t index = find_element(array->elements, array->count, &element, sizeof(element_type)); \
+        if (index == array->count) { \
+            return false; \
+        } \
+        if (out_index) { \
+            *out_index = index; \
         } \
-        return false; \
+        return true; \
     }
 
 #define MAP_0(action)
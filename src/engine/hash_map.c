@@ -0,0 +1,52 @@
+#include "hash_map.h"
+
+uint32_t get_hash_map_capacity(uint32_t count) {
+    uint64_t capacity = HASH_MAP_GROUP_SIZE;
+    while (capacity * 7 < (uint64_t)count * 8) {
+        capacity *= 2;
+    }
+    ASSERT(capacity <= (1ull << 31), capacity = 1ull << 31, "Hash map cannot hold %u entries", count);
+    return (uint32_t)capacity;
+}
+
+int8_t* create_hash_map_control(bump_allocator* allocator, uint32_t capacity) {
+    DEBUG_ASSERT(capacity % HASH_MAP_GROUP_SIZE == 0 && (capacity & (capacity - 1)) == 0, return NULL,
+        "Hash map capacity %u is not a power of two number of groups", capacity);
+    // Aligned so a group can be loaded with one aligned SIMD load.
+    int8_t* control = (int8_t*)BUMP_ALLOCATE_TAGGED(allocator, HASH_MAP_GROUP_SIZE, capacity, "hash_map");
+    if (control != NULL) {
+        memset(control, HASH_MAP_EMPTY, capacity);
+    }
+    return control;
+}
+
+// The murmur3 finalizer: every bit of the key affects every bit of the hash, so sequential keys spread across groups.
+uint64_t hash_uint64(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xFF51AFD7ED558CCDull;
+    key ^= key >> 33;
+    key *= 0xC4CEB9FE1A85EC53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+// Eight bytes at a time, each mixed in with a multiply, then finalized like hash_uint64.
+uint64_t hash_bytes(const void* data, size_t length) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ ((uint64_t)length * 0xC2B2AE3D27D4EB4Full);
+    while (length >= 8) {
+        uint64_t word;
+        memcpy(&word, bytes, sizeof(word));
+        hash = (hash ^ (word * 0x87C37B91114253D5ull)) * 0x4CF5AD432745937Full;
+        hash ^= hash >> 31;
+        bytes += 8;
+        length -= 8;
+    }
+    if (length > 0) {
+        uint64_t word = 0;
+        memcpy(&word, bytes, length);
+        hash = (hash ^ (word * 0x87C37B91114253D5ull)) * 0x4CF5AD432745937Full;
+        hash ^= hash >> 31;
+    }
+    return hash_uint64(hash);
+}
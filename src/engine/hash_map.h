@@ -0,0 +1,256 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+#include "platform_layer.h"
+
+/*
+An open addressing hash map in a bump allocator, for lookups by key (assets by name, entities by handle, interned strings)
+that would otherwise be a linear scan.
+
+It is laid out like a Swiss table: every slot has a control byte that is either empty, deleted, or 7 bits of the key's hash.
+Slots are probed a group of HASH_MAP_GROUP_SIZE at a time, and one SIMD compare finds every slot in the group whose control byte
+matches, so keys are only compared when their hashes (nearly) match, and a lookup usually touches one group.
+A probe stops at the first group with an empty slot, so removed slots are marked deleted unless their group has an empty slot already.
+
+The map grows like a dynamic array (see dynamic_array.h), to keep at most 7/8 of its slots in use. The hash and equality functions
+are passed to IMPLEMENT_HASH_MAP, and hash_uint32, hash_uint64, hash_pointer and hash_string (with string_equal and the equality
+functions below) cover the usual keys.
+
+usage:
+    DECLARE_HASH_MAP(sound_lookup, string, uint32_t)
+    IMPLEMENT_HASH_MAP(sound_lookup, string, uint32_t, hash_string, string_equal)
+
+    sound_lookup_insert(&lookup, &allocators->perm, (string)CSTR("explosion"), sound_index);
+    uint32_t* found = sound_lookup_find(&lookup, (string)CSTR("explosion"));
+*/
+
+#define HASH_MAP_GROUP_SIZE 16
+#define HASH_MAP_EMPTY ((int8_t)-128)
+#define HASH_MAP_DELETED ((int8_t)-2)
+
+// Bit i is set for every control byte i in the group that equals h2.
+static inline uint32_t hash_map_match_group(const int8_t* control, int8_t h2) {
+#ifdef HAS_SSE2
+    __m128i group = _mm_load_si128((const __m128i*)control);
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(h2)));
+#else
+    uint32_t matches = 0;
+    for (uint32_t i = 0; i < HASH_MAP_GROUP_SIZE; ++i) {
+        matches |= (uint32_t)(control[i] == h2) << i;
+    }
+    return matches;
+#endif
+}
+
+// Empty and deleted control bytes are the only negative ones, so the sign bits find both.
+static inline uint32_t hash_map_match_empty_or_deleted(const int8_t* control) {
+#ifdef HAS_SSE2
+    return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)control));
+#else
+    uint32_t matches = 0;
+    for (uint32_t i = 0; i < HASH_MAP_GROUP_SIZE; ++i) {
+        matches |= (uint32_t)(control[i] < 0) << i;
+    }
+    return matches;
+#endif
+}
+
+static inline uint32_t hash_map_match_empty(const int8_t* control) {
+    return hash_map_match_group(control, HASH_MAP_EMPTY);
+}
+
+// Slots needed to hold count entries at the maximum load (a power of two, at least one group).
+uint32_t get_hash_map_capacity(uint32_t count);
+
+// Allocates the control bytes of a map with capacity slots, all empty.
+int8_t* create_hash_map_control(bump_allocator* allocator, uint32_t capacity);
+
+uint64_t hash_uint64(uint64_t key);
+uint64_t hash_bytes(const void* data, size_t length);
+
+static inline uint64_t hash_uint32(uint32_t key) {
+    return hash_uint64(key);
+}
+
+static inline uint64_t hash_pointer(const void* key) {
+    return hash_uint64((uint64_t)(uintptr_t)key);
+}
+
+static inline uint64_t hash_string(string key) {
+    return hash_bytes(key.text, key.length);
+}
+
+static inline bool uint32_equal(uint32_t a, uint32_t b) {
+    return a == b;
+}
+
+static inline bool uint64_equal(uint64_t a, uint64_t b) {
+    return a == b;
+}
+
+static inline bool pointer_equal(const void* a, const void* b) {
+    return a == b;
+}
+
+#define DECLARE_HASH_MAP(name, key_type, value_type) \
+    typedef struct { \
+        int8_t* control; \
+        key_type* keys; \
+        value_type* values; \
+        uint32_t count; \
+        uint32_t deleted_count; \
+        uint32_t capacity; \
+    } name; \
+    result name##_reserve(name* map, bump_allocator* allocator, uint32_t count); \
+    result name##_insert(name* map, bump_allocator* allocator, key_type key, value_type value); \
+    value_type* name##_find(const name* map, key_type key); \
+    bool name##_remove(name* map, key_type key); \
+    bool name##_next(const name* map, uint32_t* cursor, key_type* out_key, value_type** out_value); \
+    static inline bool name##_contains(const name* map, key_type key) { \
+        return name##_find(map, key) != NULL; \
+    } \
+    static inline void name##_clear(name* map) { \
+        ASSERT(map != NULL, return, "Hash map " #name " cannot be NULL"); \
+        if (map->capacity > 0) { \
+            memset(map->control, HASH_MAP_EMPTY, map->capacity); \
+        } \
+        map->count = 0; \
+        map->deleted_count = 0; \
+    }
+
+#define IMPLEMENT_HASH_MAP(name, key_type, value_type, hash_function, equal_function) \
+    /* Where key is, or the first free slot of its probe sequence (with *out_found false) if it is not in the map. */ \
+    static uint32_t name##_probe(const name* map, key_type key, uint64_t hash, bool* out_found) { \
+        int8_t h2 = (int8_t)(hash & 0x7F); \
+        uint32_t group_mask = map->capacity / HASH_MAP_GROUP_SIZE - 1; \
+        uint32_t group = (uint32_t)(hash >> 7) & group_mask; \
+        uint32_t free_slot = UINT32_MAX; \
+        for (uint32_t probe = 1; probe <= group_mask + 1; ++probe) { \
+            const int8_t* control = map->control + group * HASH_MAP_GROUP_SIZE; \
+            for (uint32_t matches = hash_map_match_group(control, h2); matches != 0; matches &= matches - 1) { \
+                uint32_t slot = group * HASH_MAP_GROUP_SIZE + lowest_set_bit(matches); \
+                if (equal_function(map->keys[slot], key)) { \
+                    *out_found = true; \
+                    return slot; \
+                } \
+            } \
+            uint32_t free_slots = hash_map_match_empty_or_deleted(control); \
+            if (free_slot == UINT32_MAX && free_slots != 0) { \
+                free_slot = group * HASH_MAP_GROUP_SIZE + lowest_set_bit(free_slots); \
+            } \
+            if (hash_map_match_empty(control) != 0) { \
+                break; \
+            } \
+            group = (group + probe) & group_mask; /* triangular steps visit every group once */ \
+        } \
+        *out_found = false; \
+        return free_slot; \
+    } \
+    result name##_reserve(name* map, bump_allocator* allocator, uint32_t count) { \
+        ASSERT(map != NULL, return RESULT_FAILURE, "Hash map " #name " cannot be NULL"); \
+        ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL"); \
+        uint32_t capacity = get_hash_map_capacity(count > map->count ? count : map->count); \
+        if (capacity <= map->capacity && map->deleted_count == 0) { \
+            return RESULT_SUCCESS; \
+        } \
+        if (capacity < map->capacity) { \
+            capacity = map->capacity; \
+        } \
+        name rehashed = { 0 }; \
+        rehashed.capacity = capacity; \
+        rehashed.control = create_hash_map_control(allocator, capacity); \
+        rehashed.keys = (key_type*)BUMP_ALLOCATE_TAGGED(allocator, alignof(key_type), sizeof(key_type) * capacity, "hash_map"); \
+        rehashed.values = (value_type*)BUMP_ALLOCATE_TAGGED(allocator, alignof(value_type), sizeof(value_type) * capacity, "hash_map"); \
+        if (rehashed.control == NULL || rehashed.keys == NULL || rehashed.values == NULL) { \
+            BUG("Hash map " #name " failed to grow to %u slots", capacity); \
+            return RESULT_FAILURE; \
+        } \
+        for (uint32_t i = 0; i < map->capacity; ++i) { \
+            if (map->control[i] >= 0) { \
+                uint64_t hash = hash_function(map->keys[i]); \
+                bool found = false; \
+                uint32_t slot = name##_probe(&rehashed, map->keys[i], hash, &found); \
+                rehashed.control[slot] = (int8_t)(hash & 0x7F); \
+                memcpy(&rehashed.keys[slot], &map->keys[i], sizeof(key_type)); \
+                memcpy(&rehashed.values[slot], &map->values[i], sizeof(value_type)); \
+                ++rehashed.count; \
+            } \
+        } \
+        *map = rehashed; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_insert(name* map, bump_allocator* allocator, key_type key, value_type value) { \
+        ASSERT(map != NULL, return RESULT_FAILURE, "Hash map " #name " cannot be NULL"); \
+        uint64_t hash = hash_function(key); \
+        bool found = false; \
+        uint32_t slot = UINT32_MAX; \
+        if (map->capacity > 0) { \
+            slot = name##_probe(map, key, hash, &found); \
+        } \
+        if (!found && (slot == UINT32_MAX || (map->count + map->deleted_count + 1) * 8 > map->capacity * 7)) { \
+            /* Full (or too many deleted slots): rehash, which also clears out the deleted slots. */ \
+            if (name##_reserve(map, allocator, map->count + 1) != RESULT_SUCCESS) { \
+                return RESULT_FAILURE; \
+            } \
+            slot = name##_probe(map, key, hash, &found); \
+        } \
+        if (!found) { \
+            if (map->control[slot] == HASH_MAP_DELETED) { \
+                --map->deleted_count; \
+            } \
+            map->control[slot] = (int8_t)(hash & 0x7F); \
+            memcpy(&map->keys[slot], &key, sizeof(key_type)); \
+            ++map->count; \
+        } \
+        memcpy(&map->values[slot], &value, sizeof(value_type)); \
+        return RESULT_SUCCESS; \
+    } \
+    value_type* name##_find(const name* map, key_type key) { \
+        ASSERT(map != NULL, return NULL, "Hash map " #name " cannot be NULL"); \
+        if (map->count == 0) { \
+            return NULL; \
+        } \
+        bool found = false; \
+        uint32_t slot = name##_probe(map, key, hash_function(key), &found); \
+        return found ? &map->values[slot] : NULL; \
+    } \
+    bool name##_remove(name* map, key_type key) { \
+        ASSERT(map != NULL, return false, "Hash map " #name " cannot be NULL"); \
+        if (map->count == 0) { \
+            return false; \
+        } \
+        bool found = false; \
+        uint32_t slot = name##_probe(map, key, hash_function(key), &found); \
+        if (!found) { \
+            return false; \
+        } \
+        /* A probe never goes past a group with an empty slot, so the slot can be empty again if its group has one. */ \
+        const int8_t* group = map->control + (slot & ~(uint32_t)(HASH_MAP_GROUP_SIZE - 1)); \
+        if (hash_map_match_empty(group) != 0) { \
+            map->control[slot] = HASH_MAP_EMPTY; \
+        } \
+        else { \
+            map->control[slot] = HASH_MAP_DELETED; \
+            ++map->deleted_count; \
+        } \
+        --map->count; \
+        return true; \
+    } \
+    /* Start with *cursor = 0, and call until it returns false. Inserting or removing while iterating can skip or repeat entries. */ \
+    bool name##_next(const name* map, uint32_t* cursor, key_type* out_key, value_type** out_value) { \
+        ASSERT(map != NULL && cursor != NULL, return false, "Hash map " #name " and cursor cannot be NULL"); \
+        for (; *cursor < map->capacity; ++*cursor) { \
+            if (map->control[*cursor] >= 0) { \
+                if (out_key) { \
+                    memcpy(out_key, &map->keys[*cursor], sizeof(key_type)); \
+                } \
+                if (out_value) { \
+                    *out_value = &map->values[*cursor]; \
+                } \
+                ++*cursor; \
+                return true; \
+            } \
+        } \
+        return false; \
+    }
+
+#endif // HASH_MAP_H
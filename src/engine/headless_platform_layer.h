@@ -0,0 +1,24 @@
+#ifndef HEADLESS_PLATFORM_LAYER_H
+#define HEADLESS_PLATFORM_LAYER_H
+
+/*
+The POSIX platform layer has no window, GPU or audio device. It implements the platform layer interface "headlessly":
+draw_sprite still generates sprite instances (into CPU memory), input can be set directly and sounds are silently ignored.
+This is used to run the engine and game code in benchmarks and tools without a display.
+These functions create and drive the headless replacements for the objects that the Windows game loop owns.
+*/
+
+#include "platform_layer.h"
+#include "sprite_instances.h"
+
+graphics* create_headless_graphics(bump_allocator* allocator, vector2int virtual_resolution, vector2int sprite_sheet_size);
+void begin_headless_frame(graphics* graphics);
+sprite_instances get_headless_sprite_instances(graphics* graphics);
+
+input* create_headless_input(bump_allocator* allocator);
+void set_headless_key(input* input_state, keyboard_key key, bool is_pressed);
+void begin_headless_input_frame(input* input_state);
+
+audio* create_headless_audio(bump_allocator* allocator);
+
+#endif // HEADLESS_PLATFORM_LAYER_H
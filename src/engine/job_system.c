@@ -0,0 +1,490 @@
+#include "job_system.h"
+#include "profiler.h"
+
+STATIC_ASSERT(((JOB_QUEUE_CAPACITY & (JOB_QUEUE_CAPACITY - 1)) == 0), job_queue_capacity_must_be_power_of_two);
+
+IMPLEMENT_MPMC_QUEUE(shared_job_queue, job)
+
+/*
+=====
+    Chase-Lev deque
+=====
+Only the owner calls push_job and pop_job, any thread may call steal_job. Jobs live in [top, bottom).
+*/
+
+static bool push_job(job_queue* queue, const job* new_job) {
+    uint64_t bottom = atomic_load_uint64(&queue->bottom, MEMORY_ORDER_RELAXED);
+    uint64_t top = atomic_load_uint64(&queue->top, MEMORY_ORDER_ACQUIRE);
+    if (bottom - top >= JOB_QUEUE_CAPACITY) {
+        return false;
+    }
+
+    queue->jobs[bottom & (JOB_QUEUE_CAPACITY - 1)] = *new_job;
+    atomic_store_uint64(&queue->bottom, bottom + 1, MEMORY_ORDER_RELEASE);
+    return true;
+}
+
+// The indices are compared as signed numbers, because bottom is briefly one below top when popping from an empty deque.
+static bool pop_job(job_queue* queue, job* out_job) {
+    int64_t bottom = (int64_t)atomic_load_uint64(&queue->bottom, MEMORY_ORDER_RELAXED) - 1;
+    atomic_store_uint64(&queue->bottom, (uint64_t)bottom, MEMORY_ORDER_RELAXED);
+    atomic_fence(MEMORY_ORDER_SEQ_CST); // the new bottom must be visible to thieves before top is read
+    int64_t top = (int64_t)atomic_load_uint64(&queue->top, MEMORY_ORDER_RELAXED);
+
+    if (top > bottom) {
+        atomic_store_uint64(&queue->bottom, (uint64_t)(bottom + 1), MEMORY_ORDER_RELAXED);
+        return false;
+    }
+
+    *out_job = queue->jobs[bottom & (JOB_QUEUE_CAPACITY - 1)];
+    if (top == bottom) {
+        // Last job, race the thieves for it.
+        uint64_t expected = (uint64_t)top;
+        bool won = atomic_compare_exchange_uint64(&queue->top, &expected, (uint64_t)(top + 1), MEMORY_ORDER_SEQ_CST);
+        atomic_store_uint64(&queue->bottom, (uint64_t)(bottom + 1), MEMORY_ORDER_RELAXED);
+        return won;
+    }
+    return true;
+}
+
+static bool steal_job(job_queue* queue, job* out_job) {
+    int64_t top = (int64_t)atomic_load_uint64(&queue->top, MEMORY_ORDER_ACQUIRE);
+    atomic_fence(MEMORY_ORDER_SEQ_CST);
+    int64_t bottom = (int64_t)atomic_load_uint64(&queue->bottom, MEMORY_ORDER_ACQUIRE);
+    if (top >= bottom) {
+        return false;
+    }
+
+    // The copy may be stale if the owner popped this job in the meantime, in that case the exchange fails and it is discarded.
+    *out_job = queue->jobs[top & (JOB_QUEUE_CAPACITY - 1)];
+    uint64_t expected = (uint64_t)top;
+    return atomic_compare_exchange_uint64(&queue->top, &expected, (uint64_t)(top + 1), MEMORY_ORDER_SEQ_CST);
+}
+
+/*
+=====
+    Scheduling
+=====
+*/
+
+static THREAD_LOCAL job_worker* current_worker = NULL;
+
+static job_worker* get_current_worker(job_system* system) {
+    if (current_worker != NULL && current_worker->system == system) {
+        return current_worker;
+    }
+
+    // This thread may be a worker that has only run code from another module so far (such as the hot-reloaded game DLL).
+    uint64_t thread_id = get_current_thread_id();
+    for (uint32_t i = 0; i < system->thread_count; ++i) {
+        if (atomic_load_uint64(&system->workers[i].thread_id, MEMORY_ORDER_ACQUIRE) == thread_id) {
+            current_worker = &system->workers[i];
+            return current_worker;
+        }
+    }
+    return NULL;
+}
+
+static bool take_job(job_system* system, job_worker* worker, job* out_job) {
+    bool found = (worker != NULL && pop_job(&worker->queue, out_job)) || shared_job_queue_pop(&system->shared_jobs, out_job);
+
+    if (!found) {
+        uint32_t first = 0;
+        if (worker != NULL) {
+            // xorshift32
+            worker->random_state ^= worker->random_state << 13;
+            worker->random_state ^= worker->random_state >> 17;
+            worker->random_state ^= worker->random_state << 5;
+            first = worker->random_state % system->thread_count;
+        }
+
+        for (uint32_t i = 0; i < system->thread_count && !found; ++i) {
+            job_worker* victim = &system->workers[(first + i) % system->thread_count];
+            found = victim != worker && steal_job(&victim->queue, out_job);
+        }
+    }
+
+    if (found) {
+        atomic_fetch_add_uint64(&system->queued_jobs, (uint64_t)-1, MEMORY_ORDER_SEQ_CST);
+    }
+    return found;
+}
+
+static void execute_job(const job* job_to_run) {
+    job_to_run->function(job_to_run->data);
+    if (job_to_run->counter != NULL) {
+        atomic_fetch_add_uint64(&job_to_run->counter->remaining, (uint64_t)-1, MEMORY_ORDER_ACQ_REL);
+    }
+}
+
+static void wake_workers(job_system* system, uint32_t job_count) {
+    // Pairs with the sleeping_threads increment in worker_main: either the worker sees the new jobs before it sleeps, or we see it sleeping.
+    atomic_fence(MEMORY_ORDER_SEQ_CST);
+    if (atomic_load_uint32(&system->sleeping_threads, MEMORY_ORDER_SEQ_CST) == 0) {
+        return;
+    }
+
+    lock_mutex(&system->sleep_mutex);
+    if (job_count > 1) {
+        broadcast_condition_variable(&system->wake_up);
+    }
+    else {
+        signal_condition_variable(&system->wake_up);
+    }
+    unlock_mutex(&system->sleep_mutex);
+}
+
+static unsigned long worker_main(void* arg) {
+    job_worker* worker = (job_worker*)arg;
+    job_system* system = worker->system;
+    current_worker = worker;
+    atomic_store_uint64(&worker->thread_id, get_current_thread_id(), MEMORY_ORDER_RELEASE);
+    set_profiler_thread_name("job worker");
+
+    uint32_t idle_spins = 0;
+    while (atomic_load_uint32(&system->is_shutting_down, MEMORY_ORDER_ACQUIRE) == 0) {
+        job next_job;
+        if (take_job(system, worker, &next_job)) {
+            execute_job(&next_job);
+            idle_spins = 0;
+            continue;
+        }
+
+        if (++idle_spins < JOB_SYSTEM_IDLE_SPINS) {
+            CPU_RELAX();
+            continue;
+        }
+
+        lock_mutex(&system->sleep_mutex);
+        atomic_fetch_add_uint32(&system->sleeping_threads, 1, MEMORY_ORDER_SEQ_CST);
+        while (atomic_load_uint64(&system->queued_jobs, MEMORY_ORDER_SEQ_CST) == 0 && atomic_load_uint32(&system->is_shutting_down, MEMORY_ORDER_ACQUIRE) == 0) {
+            wait_condition_variable(&system->wake_up, &system->sleep_mutex);
+        }
+        atomic_fetch_add_uint32(&system->sleeping_threads, (uint32_t)-1, MEMORY_ORDER_RELAXED);
+        unlock_mutex(&system->sleep_mutex);
+        idle_spins = 0;
+    }
+
+    return 0;
+}
+
+/*
+=====
+    Job system
+=====
+*/
+
+// Undoes create_job_system before any worker thread has started: frees the first scratch_count scratch arenas and the sleep primitives.
+static void destroy_unstarted_job_system(job_system* system, uint32_t scratch_count) {
+    for (uint32_t i = 0; i < scratch_count; ++i) {
+        destroy_bump_allocator(&system->workers[i].scratch);
+    }
+    destroy_condition_variable(&system->wake_up);
+    destroy_mutex(&system->sleep_mutex);
+}
+
+result create_job_system(job_system* system, uint32_t thread_count, bump_allocator* allocator) {
+    ASSERT(system != NULL, return RESULT_FAILURE, "Job system cannot be NULL");
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+
+    if (thread_count == 0) {
+        thread_count = get_processor_count();
+    }
+    if (thread_count > JOB_SYSTEM_MAX_THREADS) {
+        thread_count = JOB_SYSTEM_MAX_THREADS;
+    }
+
+    memset(system, 0, sizeof(job_system));
+    system->thread_count = thread_count;
+
+    if (create_mutex(&system->sleep_mutex) != RESULT_SUCCESS) {
+        BUG("Failed to create job system synchronization primitives.");
+        return RESULT_FAILURE;
+    }
+    if (init_condition_variable(&system->wake_up) != RESULT_SUCCESS) {
+        BUG("Failed to create job system synchronization primitives.");
+        destroy_mutex(&system->sleep_mutex);
+        return RESULT_FAILURE;
+    }
+
+    if (shared_job_queue_create(&system->shared_jobs, allocator, JOB_QUEUE_CAPACITY) != RESULT_SUCCESS) {
+        BUG("Failed to allocate the job system's shared queue.");
+        destroy_unstarted_job_system(system, 0);
+        return RESULT_FAILURE;
+    }
+
+    for (uint32_t i = 0; i < thread_count; ++i) {
+        job_worker* worker = &system->workers[i];
+        worker->system = system;
+        worker->index = i;
+        worker->random_state = 0x9E3779B9u * (i + 1);
+        worker->queue.jobs = (job*)BUMP_ALLOCATE_TAGGED(allocator, JOB_SYSTEM_CACHE_LINE, sizeof(job) * JOB_QUEUE_CAPACITY, "job_system");
+        if (worker->queue.jobs == NULL) {
+            BUG("Failed to allocate job queue for thread %u.", i);
+            destroy_unstarted_job_system(system, i);
+            return RESULT_FAILURE;
+        }
+        if (create_bump_allocator(&worker->scratch, JOB_SCRATCH_ARENA_CAPACITY) != RESULT_SUCCESS) {
+            BUG("Failed to reserve scratch arena for job thread %u.", i);
+            destroy_unstarted_job_system(system, i);
+            return RESULT_FAILURE;
+        }
+    }
+
+    current_worker = &system->workers[0];
+    atomic_store_uint64(&system->workers[0].thread_id, get_current_thread_id(), MEMORY_ORDER_RELEASE);
+    for (uint32_t i = 1; i < thread_count; ++i) {
+        if (create_thread(&system->workers[i].thread, worker_main, &system->workers[i]) != RESULT_SUCCESS) {
+            BUG("Failed to create job worker thread %u.", i);
+            // Only the threads before this one are running, but every scratch arena was reserved.
+            for (uint32_t j = i; j < thread_count; ++j) {
+                destroy_bump_allocator(&system->workers[j].scratch);
+            }
+            system->thread_count = i;
+            destroy_job_system(system);
+            return RESULT_FAILURE;
+        }
+    }
+
+    return RESULT_SUCCESS;
+}
+
+void destroy_job_system(job_system* system) {
+    ASSERT(system != NULL, return, "Job system cannot be NULL");
+    DEBUG_ASSERT(atomic_load_uint64(&system->queued_jobs, MEMORY_ORDER_ACQUIRE) == 0, , "Destroying job system with %llu jobs still queued",
+        (unsigned long long)atomic_load_uint64(&system->queued_jobs, MEMORY_ORDER_RELAXED));
+
+    lock_mutex(&system->sleep_mutex);
+    atomic_store_uint32(&system->is_shutting_down, 1, MEMORY_ORDER_RELEASE);
+    broadcast_condition_variable(&system->wake_up);
+    unlock_mutex(&system->sleep_mutex);
+
+    for (uint32_t i = 1; i < system->thread_count; ++i) {
+        join_thread(&system->workers[i].thread);
+        destroy_thread(&system->workers[i].thread);
+    }
+
+    for (uint32_t i = 0; i < system->thread_count; ++i) {
+        destroy_bump_allocator(&system->workers[i].scratch);
+    }
+
+    if (current_worker == &system->workers[0]) {
+        current_worker = NULL;
+    }
+
+    destroy_condition_variable(&system->wake_up);
+    destroy_mutex(&system->sleep_mutex);
+}
+
+void run_jobs(job_system* system, const job* jobs, uint32_t count, job_counter* counter) {
+    ASSERT(system != NULL, return, "Job system cannot be NULL");
+    ASSERT(jobs != NULL || count == 0, return, "Jobs cannot be NULL");
+    if (count == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        ASSERT(jobs[i].function != NULL, return, "Job %u has no function", i);
+    }
+
+    if (counter != NULL) {
+        atomic_fetch_add_uint64(&counter->remaining, count, MEMORY_ORDER_RELAXED);
+    }
+
+    // Counted before the jobs are pushed, so that a worker never goes to sleep while one of them is in a queue.
+    atomic_fetch_add_uint64(&system->queued_jobs, count, MEMORY_ORDER_SEQ_CST);
+
+    job_worker* worker = get_current_worker(system);
+    uint32_t queued = 0;
+    job batch[64];
+    for (uint32_t first = 0; first < count; first += ARRAY_LENGTH(batch)) {
+        uint32_t batch_count = count - first < ARRAY_LENGTH(batch) ? count - first : ARRAY_LENGTH(batch);
+        for (uint32_t i = 0; i < batch_count; ++i) {
+            batch[i] = jobs[first + i];
+            batch[i].counter = counter;
+        }
+
+        uint32_t pushed = 0;
+        if (worker != NULL) {
+            while (pushed < batch_count && push_job(&worker->queue, &batch[pushed])) {
+                ++pushed;
+            }
+        }
+        else {
+            // Jobs from outside the job system go into the shared queue a batch at a time, with one compare-exchange per batch.
+            pushed = shared_job_queue_push_multiple(&system->shared_jobs, batch, batch_count);
+        }
+        queued += pushed;
+
+        // The queue is full, so do the rest of the work now instead.
+        for (uint32_t i = pushed; i < batch_count; ++i) {
+            atomic_fetch_add_uint64(&system->queued_jobs, (uint64_t)-1, MEMORY_ORDER_RELAXED);
+            execute_job(&batch[i]);
+        }
+    }
+
+    if (queued > 0) {
+        wake_workers(system, queued);
+    }
+}
+
+void wait_for_counter(job_system* system, job_counter* counter) {
+    ASSERT(system != NULL, return, "Job system cannot be NULL");
+    ASSERT(counter != NULL, return, "Job counter cannot be NULL");
+
+    job_worker* worker = get_current_worker(system);
+    uint32_t idle_spins = 0;
+    while (atomic_load_uint64(&counter->remaining, MEMORY_ORDER_ACQUIRE) != 0) {
+        job next_job;
+        if (take_job(system, worker, &next_job)) {
+            execute_job(&next_job);
+            idle_spins = 0;
+        }
+        else if (++idle_spins < JOB_SYSTEM_IDLE_SPINS) {
+            CPU_RELAX();
+        }
+        else {
+            // The remaining jobs are running on other threads, give them the core instead of spinning until they finish.
+            yield_thread();
+        }
+    }
+}
+
+/*
+=====
+    Scratch arenas
+=====
+*/
+
+bump_allocator* get_job_scratch_arena(job_system* system) {
+    ASSERT(system != NULL, return NULL, "Job system cannot be NULL");
+    job_worker* worker = get_current_worker(system);
+    return worker != NULL ? &worker->scratch : NULL;
+}
+
+void* job_scratch_allocate(job_system* system, size_t alignment, size_t bytes) {
+    bump_allocator* scratch = get_job_scratch_arena(system);
+    ASSERT(scratch != NULL, return NULL, "Scratch memory can only be allocated by job system threads");
+    return bump_allocate(scratch, alignment, bytes);
+}
+
+void reset_job_scratch_arenas(job_system* system) {
+    ASSERT(system != NULL, return, "Job system cannot be NULL");
+    DEBUG_ASSERT(get_current_worker(system) == &system->workers[0], return, "Scratch arenas must be reset by the thread that created the job system");
+    DEBUG_ASSERT(atomic_load_uint64(&system->queued_jobs, MEMORY_ORDER_ACQUIRE) == 0, return, "Scratch arenas cannot be reset while jobs are queued");
+
+    for (uint32_t i = 0; i < system->thread_count; ++i) {
+        reset_bump_allocator(&system->workers[i].scratch);
+    }
+    ++system->scratch_frame;
+}
+
+scratch_result make_scratch_result(job_system* system, void* data, size_t bytes) {
+    scratch_result result = { 0 };
+    ASSERT(system != NULL, return result, "Job system cannot be NULL");
+    job_worker* worker = get_current_worker(system);
+    ASSERT(worker != NULL, return result, "Scratch results can only be made by job system threads");
+
+    uint8_t* begin = (uint8_t*)worker->scratch.base;
+    ASSERT(bytes == 0 || ((uint8_t*)data >= begin && (uint8_t*)data + bytes <= begin + worker->scratch.used_bytes), return result,
+        "Scratch result data is not in the calling thread's scratch arena");
+
+    result.data = data;
+    result.bytes = bytes;
+    result.frame = system->scratch_frame;
+    result.owner = worker->index;
+    return result;
+}
+
+void* get_scratch_result(job_system* system, scratch_result result) {
+    ASSERT(system != NULL, return NULL, "Job system cannot be NULL");
+    ASSERT(result.frame == system->scratch_frame, return NULL,
+        "Scratch result from frame %u was read after the scratch arenas were reset (frame %u)", result.frame, system->scratch_frame);
+    return result.data;
+}
+
+void* copy_scratch_result(job_system* system, scratch_result result, bump_allocator* destination) {
+    ASSERT(destination != NULL, return NULL, "Destination allocator cannot be NULL");
+    void* data = get_scratch_result(system, result);
+    if (data == NULL || result.bytes == 0) {
+        return NULL;
+    }
+
+    void* copy = BUMP_ALLOCATE_TAGGED(destination, 16, result.bytes, "scratch_results");
+    ASSERT(copy != NULL, return NULL, "Failed to allocate %zu bytes for scratch result copy", result.bytes);
+    memcpy(copy, data, result.bytes);
+    return copy;
+}
+
+/*
+=====
+    Parallel for
+=====
+*/
+
+typedef struct {
+    parallel_for_function function;
+    void* context;
+    uint32_t begin;
+    uint32_t end;
+} parallel_for_range;
+
+static void parallel_for_job(void* data) {
+    parallel_for_range* range = (parallel_for_range*)data;
+    range->function(range->context, range->begin, range->end);
+}
+
+void parallel_for(job_system* system, const void* elements, uint32_t count, uint32_t element_size, uint32_t min_grain, parallel_for_function function, void* context) {
+    ASSERT(function != NULL, return, "Parallel for function cannot be NULL");
+    ASSERT(element_size > 0, return, "Element size cannot be 0");
+    if (count == 0) {
+        return;
+    }
+
+    uint32_t thread_count = system != NULL ? system->thread_count : 1;
+    uint32_t grain = (count + thread_count * PARALLEL_FOR_RANGES_PER_THREAD - 1) / (thread_count * PARALLEL_FOR_RANGES_PER_THREAD);
+    uint32_t max_ranges_grain = (count + PARALLEL_FOR_MAX_RANGES - 1) / PARALLEL_FOR_MAX_RANGES;
+    if (grain < min_grain) {
+        grain = min_grain;
+    }
+    if (grain < max_ranges_grain) {
+        grain = max_ranges_grain;
+    }
+
+    // Round ranges up to whole cache lines, and find how many elements come before the first cache line boundary.
+    uint32_t lead = 0;
+    if (element_size < JOB_SYSTEM_CACHE_LINE && JOB_SYSTEM_CACHE_LINE % element_size == 0) {
+        uint32_t elements_per_line = JOB_SYSTEM_CACHE_LINE / element_size;
+        grain = (grain + elements_per_line - 1) / elements_per_line * elements_per_line;
+
+        uint32_t misalignment = (uint32_t)((uintptr_t)elements % JOB_SYSTEM_CACHE_LINE);
+        if (misalignment != 0 && (JOB_SYSTEM_CACHE_LINE - misalignment) % element_size == 0) {
+            lead = (JOB_SYSTEM_CACHE_LINE - misalignment) / element_size;
+        }
+    }
+
+    if (system == NULL || thread_count == 1 || count <= grain + lead) {
+        function(context, 0, count);
+        return;
+    }
+
+    parallel_for_range ranges[PARALLEL_FOR_MAX_RANGES + 1];
+    job jobs[PARALLEL_FOR_MAX_RANGES + 1];
+    uint32_t range_count = 0;
+    for (uint32_t begin = 0; begin < count; ++range_count) {
+        uint32_t end = range_count == 0 ? lead + grain : begin + grain;
+        if (end > count || count - end < grain / 4) {
+            end = count; // merge a small tail into the last range
+        }
+
+        ranges[range_count] = (parallel_for_range){ .function = function, .context = context, .begin = begin, .end = end };
+        jobs[range_count] = (job){ .function = parallel_for_job, .data = &ranges[range_count] };
+        begin = end;
+    }
+
+    // The calling thread takes the first range itself rather than queueing it and stealing it back.
+    job_counter counter = { 0 };
+    run_jobs(system, jobs + 1, range_count - 1, &counter);
+    parallel_for_job(&ranges[0]);
+    wait_for_counter(system, &counter);
+}
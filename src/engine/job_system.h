@@ -0,0 +1,176 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+#include "platform_layer.h"
+#include "concurrent_queue.h"
+
+/*
+A work-stealing job system. A job is a function pointer and a data pointer, jobs are submitted in batches and waited on with a counter.
+
+Every thread of the job system (the thread that created it, plus the worker threads) owns a lock-free deque (a Chase-Lev deque).
+The owner pushes and pops jobs at the bottom of its own deque, and idle threads steal from the top of the other deques,
+so jobs that spawn more jobs keep their data hot on the same core while the rest of the work spreads out.
+Threads that are not part of the job system submit into a shared lock-free queue (an MPMC queue) instead.
+Workers that run out of work spin for a little while and then sleep on a condition variable until more jobs are submitted.
+
+Waiting on a counter does not block: the waiting thread runs other jobs until the counter reaches zero.
+
+usage:
+    job_counter counter = { 0 };
+    job jobs[64];
+    for (uint32_t i = 0; i < 64; ++i) {
+        jobs[i] = (job){ .function = integrate_chunk, .data = &chunks[i] };
+    }
+    run_jobs(system, jobs, 64, &counter);
+    wait_for_counter(system, &counter);
+
+Every thread of the job system also owns a scratch arena (see "Scratch arenas" below), so jobs can allocate without locks.
+
+With hot reloading the game DLL has its own copy of this file (and of its thread locals), so the first call from game code
+on each thread finds its worker by thread id instead.
+*/
+
+#ifndef JOB_SYSTEM_MAX_THREADS
+#define JOB_SYSTEM_MAX_THREADS 64
+#endif
+
+// Jobs per thread deque, and in the shared queue. A submission that does not fit runs immediately on the submitting thread.
+#ifndef JOB_QUEUE_CAPACITY
+#define JOB_QUEUE_CAPACITY 4096
+#endif
+
+// Address space reserved for each thread's scratch arena (pages are only committed as they are used).
+#ifndef JOB_SCRATCH_ARENA_CAPACITY
+#define JOB_SCRATCH_ARENA_CAPACITY (64 * 1024 * 1024)
+#endif
+
+// How many times an idle worker looks for work before it goes to sleep (or a thread waiting for a counter yields its core).
+#ifndef JOB_SYSTEM_IDLE_SPINS
+#define JOB_SYSTEM_IDLE_SPINS 2048
+#endif
+
+#define JOB_SYSTEM_CACHE_LINE 64
+
+// The number of jobs that have been submitted with the counter and have not finished yet.
+typedef struct {
+    atomic_uint64 remaining;
+} job_counter;
+
+typedef void (*job_function)(void* data);
+
+typedef struct {
+    job_function function;
+    void* data;
+    job_counter* counter;
+} job;
+
+DECLARE_MPMC_QUEUE(shared_job_queue, job)
+
+typedef struct {
+    // top and bottom are written by different threads, so they are kept on separate cache lines.
+    alignas(JOB_SYSTEM_CACHE_LINE) atomic_uint64 top;
+    alignas(JOB_SYSTEM_CACHE_LINE) atomic_uint64 bottom;
+    job* jobs;
+} job_queue;
+
+typedef struct {
+    job_queue queue;
+    bump_allocator scratch;
+    thread thread;
+    atomic_uint64 thread_id;
+    job_system* system;
+    uint32_t index;
+    uint32_t random_state; // picks which deque to steal from first
+} job_worker;
+
+struct job_system {
+    job_worker workers[JOB_SYSTEM_MAX_THREADS]; // worker 0 is the thread that created the job system
+    uint32_t thread_count;
+    uint32_t scratch_frame; // incremented every time the scratch arenas are reset
+
+    alignas(JOB_SYSTEM_CACHE_LINE) atomic_uint64 queued_jobs; // submitted and not yet taken by a thread
+    atomic_uint32 sleeping_threads;
+    atomic_uint32 is_shutting_down;
+    mutex sleep_mutex;
+    condition_variable wake_up;
+
+    shared_job_queue shared_jobs; // jobs submitted by threads that are not part of the job system
+};
+
+// thread_count includes the calling thread, 0 uses one thread per processor.
+result create_job_system(job_system* system, uint32_t thread_count, bump_allocator* allocator);
+void destroy_job_system(job_system* system);
+
+// Queues a batch of jobs. Each job's counter is replaced with the given counter (which may be NULL for fire-and-forget jobs).
+void run_jobs(job_system* system, const job* jobs, uint32_t count, job_counter* counter);
+
+// Runs queued jobs on the calling thread until every job submitted with the counter has finished.
+void wait_for_counter(job_system* system, job_counter* counter);
+
+/*
+=====
+    Scratch arenas
+=====
+Memory for a job's intermediate results. Each thread allocates from its own arena, so this needs no locks,
+and everything is freed at once when the main thread calls reset_job_scratch_arenas at the start of the frame.
+
+A job can hand memory from its scratch arena back to whoever waits for it with a scratch_result. The result remembers which frame
+it was made in, so reading it after the arenas have been reset is caught instead of reading memory that has been reused.
+Copy it into another arena (copy_scratch_result) to keep it for longer.
+*/
+
+typedef struct {
+    void* data;
+    size_t bytes;
+    uint32_t frame;
+    uint32_t owner; // index of the thread whose scratch arena holds the data
+} scratch_result;
+
+// The calling thread's scratch arena, or NULL when the calling thread is not part of the job system.
+bump_allocator* get_job_scratch_arena(job_system* system);
+void* job_scratch_allocate(job_system* system, size_t alignment, size_t bytes);
+
+// Frees every thread's scratch memory. Call from the thread that created the job system while no jobs are running.
+void reset_job_scratch_arenas(job_system* system);
+
+// data must have been allocated from the calling thread's scratch arena this frame.
+scratch_result make_scratch_result(job_system* system, void* data, size_t bytes);
+
+// Returns the result's data, or NULL (with a bug report) if the scratch arenas were reset since it was made.
+void* get_scratch_result(job_system* system, scratch_result result);
+void* copy_scratch_result(job_system* system, scratch_result result, bump_allocator* destination);
+
+/*
+=====
+    Parallel for
+=====
+Splits [0, count) into ranges and calls the function once per range, spread over the job system's threads, returning when all are done.
+The ranges start on cache line boundaries of the elements (when the element size allows it), so two threads never write to the same line.
+Ranges are sized for a few per thread (so a slow range can be balanced by stealing), but never below min_grain elements:
+set it to roughly how many elements are worth the overhead of a job (a few microseconds of work).
+If the whole loop fits in one range, or system is NULL, the function is called once on the calling thread instead.
+
+usage:
+    static void integrate_asteroids(void* context, uint32_t begin, uint32_t end) { ... }
+    PARALLEL_FOR_EACH(jobs, &state->asteroids, 256, integrate_asteroids, state);
+*/
+
+#ifndef PARALLEL_FOR_RANGES_PER_THREAD
+#define PARALLEL_FOR_RANGES_PER_THREAD 4
+#endif
+
+#define PARALLEL_FOR_MAX_RANGES (PARALLEL_FOR_RANGES_PER_THREAD * JOB_SYSTEM_MAX_THREADS)
+
+typedef void (*parallel_for_function)(void* context, uint32_t begin, uint32_t end);
+
+void parallel_for(job_system* system, const void* elements, uint32_t count, uint32_t element_size, uint32_t min_grain, parallel_for_function function, void* context);
+
+// Works with anything that has elements and count members (capped arrays and slices).
+#define PARALLEL_FOR_EACH(system, container, min_grain, function, context) \
+    parallel_for((system), (container)->elements, (container)->count, (uint32_t)sizeof((container)->elements[0]), (min_grain), (function), (context))
+
+// For struct-of-arrays containers (soa.h): the rows are split on whole cache lines of the given column.
+// Pass the narrowest column the function writes, then the ranges cover whole cache lines of the wider columns too.
+#define PARALLEL_FOR_EACH_COLUMN(system, soa, column, min_grain, function, context) \
+    parallel_for((system), (soa)->column, (soa)->count, (uint32_t)sizeof((soa)->column[0]), (min_grain), (function), (context))
+
+#endif // JOB_SYSTEM_H
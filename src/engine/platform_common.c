@@ -0,0 +1,343 @@
+#include "platform_layer.h"
+
+/*
+Parts of the platform layer interface that do not depend on the operating system.
+These are implemented once here instead of once per platform layer (windows_platform_layer.c, posix_platform_layer.c).
+*/
+
+/*
+=============================================================================================================================
+    Memory Allocation
+=============================================================================================================================
+*/
+
+result create_bump_allocator(bump_allocator* allocator, size_t capacity) {
+    return create_bump_allocator_with_options(allocator, capacity, NULL);
+}
+
+size_t get_bump_allocator_commit_bytes(const bump_allocator* allocator, size_t new_used_bytes) {
+    size_t needed = new_used_bytes - allocator->next_page_bytes;
+    size_t growth = allocator->next_page_bytes < allocator->max_commit_bytes ? allocator->next_page_bytes : allocator->max_commit_bytes;
+    size_t commit_bytes = needed;
+    if (commit_bytes < allocator->min_commit_bytes) {
+        commit_bytes = allocator->min_commit_bytes;
+    }
+    if (commit_bytes < growth) {
+        commit_bytes = growth;
+    }
+
+    commit_bytes = (commit_bytes + (allocator->page_size - 1)) & ~(allocator->page_size - 1);
+    if (commit_bytes > allocator->capacity - allocator->next_page_bytes) {
+        commit_bytes = allocator->capacity - allocator->next_page_bytes;
+    }
+    return commit_bytes;
+}
+
+result create_frame_arenas(memory_allocators* allocators, size_t capacity, const bump_allocator_options* options) {
+    ASSERT(allocators != NULL, return RESULT_FAILURE, "Memory allocators cannot be NULL");
+    allocators->frame_number = 0;
+    for (uint32_t i = 0; i < FRAME_ARENA_COUNT; ++i) {
+        if (create_bump_allocator_with_options(&allocators->frames[i], capacity, options) != RESULT_SUCCESS) {
+            BUG("Failed to create frame arena %u", i);
+            return RESULT_FAILURE;
+        }
+    }
+    return RESULT_SUCCESS;
+}
+
+void destroy_frame_arenas(memory_allocators* allocators) {
+    ASSERT(allocators != NULL, return, "Memory allocators cannot be NULL");
+    for (uint32_t i = 0; i < FRAME_ARENA_COUNT; ++i) {
+        destroy_bump_allocator(&allocators->frames[i]);
+    }
+}
+
+void advance_frame_arenas(memory_allocators* allocators) {
+    ASSERT(allocators != NULL, return, "Memory allocators cannot be NULL");
+    ++allocators->frame_number;
+    reset_bump_allocator(get_frame_arena(allocators));
+}
+
+size_t begin_arena_snapshot_region(bump_allocator* allocator) {
+    ASSERT(allocator != NULL, return 0, "Allocator cannot be NULL");
+    // An empty allocation aligned to the page size pads the arena to the next page.
+    bump_allocate(allocator, allocator->page_size, 0);
+    return allocator->used_bytes;
+}
+
+arena_snapshot_header make_arena_snapshot_header(const bump_allocator* allocator, size_t begin, const void* root, uint32_t version) {
+    arena_snapshot_header header = { 0 };
+    header.magic = ARENA_SNAPSHOT_MAGIC;
+    header.version = version;
+    header.base = (uint64_t)(uintptr_t)allocator->base;
+    header.begin = begin;
+    header.end = allocator->used_bytes;
+    header.root_offset = (uint64_t)((const uint8_t*)root - (const uint8_t*)allocator->base);
+    return header;
+}
+
+result check_arena_snapshot_header(const bump_allocator* allocator, size_t begin, uint32_t version, const arena_snapshot_header* header, string path) {
+    if (header->magic != ARENA_SNAPSHOT_MAGIC) {
+        BUG("%.*s is not an arena snapshot", path.length, path.text);
+        return RESULT_FAILURE;
+    }
+    if (header->version != version) {
+        BUG("Arena snapshot %.*s has version %u, expected %u", path.length, path.text, header->version, version);
+        return RESULT_FAILURE;
+    }
+    if (header->base != (uint64_t)(uintptr_t)allocator->base || header->begin != begin) {
+        BUG("Arena snapshot %.*s was saved from an arena at %p (region at %llu), this one is at %p (region at %zu)", path.length, path.text,
+            (void*)(uintptr_t)header->base, (unsigned long long)header->begin, allocator->base, begin);
+        return RESULT_FAILURE;
+    }
+    if (header->end < header->begin || header->end > allocator->capacity || header->root_offset < header->begin || header->root_offset >= header->end) {
+        BUG("Arena snapshot %.*s does not fit in the arena", path.length, path.text);
+        return RESULT_FAILURE;
+    }
+    return RESULT_SUCCESS;
+}
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+
+void* bump_allocate_tagged(bump_allocator* allocator, size_t alignment, size_t bytes, const char* tag) {
+    ASSERT(allocator != NULL, return NULL, "Allocator cannot be NULL");
+    allocator->accounting.current_tag = tag;
+    void* allocation = bump_allocate(allocator, alignment, bytes);
+    allocator->accounting.current_tag = NULL;
+    return allocation;
+}
+
+static memory_tag_usage* find_memory_tag(bump_allocator_accounting* accounting, const char* tag) {
+    // Long tags (like file paths from MEMORY_TAG_HERE) keep their end, which is the part that tells them apart.
+    size_t length = strlen(tag);
+    if (length >= MEMORY_TAG_NAME_LENGTH) {
+        tag += length - (MEMORY_TAG_NAME_LENGTH - 1);
+    }
+
+    for (uint32_t i = 0; i < accounting->tag_count; ++i) {
+        if (strncmp(accounting->tags[i].name, tag, MEMORY_TAG_NAME_LENGTH) == 0) {
+            return &accounting->tags[i];
+        }
+    }
+
+    if (accounting->tag_count == MEMORY_ACCOUNTING_MAX_TAGS) {
+        memory_tag_usage* other = &accounting->tags[MEMORY_ACCOUNTING_MAX_TAGS - 1];
+        snprintf(other->name, MEMORY_TAG_NAME_LENGTH, "other");
+        return other;
+    }
+
+    memory_tag_usage* usage = &accounting->tags[accounting->tag_count++];
+    snprintf(usage->name, MEMORY_TAG_NAME_LENGTH, "%s", tag);
+    return usage;
+}
+
+void record_bump_allocation(bump_allocator* allocator, size_t previous_used_bytes) {
+    bump_allocator_accounting* accounting = &allocator->accounting;
+    if (allocator->used_bytes > accounting->high_water_bytes) {
+        accounting->high_water_bytes = allocator->used_bytes;
+    }
+
+    // Alignment padding is counted against the allocation that needed it.
+    memory_tag_usage* usage = find_memory_tag(accounting, accounting->current_tag != NULL ? accounting->current_tag : "untagged");
+    usage->bytes += allocator->used_bytes - previous_used_bytes;
+    ++usage->allocation_count;
+    if (usage->bytes > usage->peak_bytes) {
+        usage->peak_bytes = usage->bytes;
+    }
+}
+
+void record_bump_allocator_reset(bump_allocator* allocator) {
+    bump_allocator_accounting* accounting = &allocator->accounting;
+    accounting->previous_high_water_bytes = accounting->high_water_bytes;
+    if (accounting->high_water_bytes > accounting->peak_high_water_bytes) {
+        accounting->peak_high_water_bytes = accounting->high_water_bytes;
+    }
+    accounting->high_water_bytes = 0;
+    ++accounting->reset_count;
+    for (uint32_t i = 0; i < accounting->tag_count; ++i) {
+        accounting->tags[i].bytes = 0;
+    }
+}
+
+void print_memory_report(const char* name, const bump_allocator* allocator) {
+    ASSERT(allocator != NULL, return, "Allocator cannot be NULL");
+    const bump_allocator_accounting* accounting = &allocator->accounting;
+    const double megabyte = 1024.0 * 1024.0;
+    size_t peak = accounting->peak_high_water_bytes > accounting->high_water_bytes ? accounting->peak_high_water_bytes : accounting->high_water_bytes;
+
+    printf("Memory report for %s (%llu resets)\n", name, (unsigned long long)accounting->reset_count);
+    printf("  capacity %10.2f MB, committed %10.2f MB, used %10.2f MB\n",
+        (double)allocator->capacity / megabyte, (double)allocator->next_page_bytes / megabyte, (double)allocator->used_bytes / megabyte);
+    printf("  high-water: current %.2f MB, previous %.2f MB, peak %.2f MB (%.1f%% of capacity)\n",
+        (double)accounting->high_water_bytes / megabyte, (double)accounting->previous_high_water_bytes / megabyte,
+        (double)peak / megabyte, allocator->capacity > 0 ? 100.0 * (double)peak / (double)allocator->capacity : 0.0);
+    printf("  %-32s %12s %12s %12s\n", "tag", "bytes", "peak_bytes", "allocations");
+    for (uint32_t i = 0; i < accounting->tag_count; ++i) {
+        const memory_tag_usage* usage = &accounting->tags[i];
+        printf("  %-32s %12zu %12zu %12llu\n", usage->name, usage->bytes, usage->peak_bytes, (unsigned long long)usage->allocation_count);
+    }
+    fflush(stdout);
+}
+
+#endif // ENABLE_MEMORY_ACCOUNTING
+
+/*
+=============================================================================================================================
+    Time
+=============================================================================================================================
+*/
+
+uint64_t timestamp_to_nanoseconds(uint64_t ticks) {
+    uint64_t frequency = get_timestamp_frequency();
+    // Split into whole seconds and the remainder, so the multiplication cannot overflow.
+    return (ticks / frequency) * 1000000000ull + ((ticks % frequency) * 1000000000ull) / frequency;
+}
+
+double timestamp_to_seconds(uint64_t ticks) {
+    return (double)ticks / (double)get_timestamp_frequency();
+}
+
+result create_clock(clock* clock) {
+    ASSERT(clock != NULL, return RESULT_FAILURE, "Clock cannot be NULL");
+    ASSERT(get_timestamp_frequency() != 0, return RESULT_FAILURE, "High resolution timestamps are not supported.");
+
+    memset(clock, 0, sizeof(*clock));
+    clock->creation_timestamp = read_timestamp();
+    clock->previous_update_timestamp = clock->creation_timestamp;
+    return RESULT_SUCCESS;
+}
+
+void update_clock(clock* clock) {
+    ASSERT(clock != NULL, return, "Clock cannot be NULL");
+
+    uint64_t now = read_timestamp();
+    clock->ticks_since_previous_update = now - clock->previous_update_timestamp;
+    clock->time_since_previous_update = (float)timestamp_to_seconds(clock->ticks_since_previous_update);
+    clock->time_since_creation = timestamp_to_seconds(now - clock->creation_timestamp);
+    clock->previous_update_timestamp = now;
+}
+
+/*
+=============================================================================================================================
+    String Manipulation (depending on memory allocation)
+=============================================================================================================================
+*/
+
+string concat(string a, string b, bump_allocator* allocator) {
+    ASSERT(allocator != NULL, return ((string) {
+        .text = NULL, .length = 0
+    }), "Allocator cannot be NULL");
+    uint32_t total_length = a.length + b.length;
+    char* combined_text = (char*)BUMP_ALLOCATE_TAGGED(allocator, 1, total_length + 1, "strings");
+    if (combined_text == NULL) {
+        BUG("Failed to allocate memory for concatenated string.");
+        return (string) {
+            .text = NULL, .length = 0
+        };
+    }
+    memcpy(combined_text, a.text, a.length);
+    memcpy(combined_text + a.length, b.text, b.length);
+    combined_text[total_length] = '\0';
+    return (string) {
+        .text = combined_text, .length = total_length
+    };
+}
+
+result append_last_string(string* original, string to_append, bump_allocator* allocator) {
+    ASSERT(original != NULL, return RESULT_FAILURE, "Original string pointer cannot be NULL");
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(original->text == (const char*)((uint8_t*)allocator->base + (allocator->used_bytes - original->length)), return RESULT_FAILURE, "Original string must be the last allocation in the bump allocator to use string_append");
+
+    char* new_text = (char*)BUMP_ALLOCATE_TAGGED(allocator, 1, to_append.length, "strings");
+    if (new_text == NULL) {
+        BUG("Failed to allocate memory for string append.");
+        return RESULT_FAILURE;
+    }
+    memcpy(new_text, to_append.text, to_append.length);
+    original->length += to_append.length;
+    return RESULT_SUCCESS;
+}
+
+/*
+=============================================================================================================================
+    Multi-threading
+=============================================================================================================================
+*/
+
+#define SPINLOCK_MAX_BACKOFF 64
+
+bool try_lock_spinlock(spinlock* lock) {
+    ASSERT(lock != NULL, return false, "Spinlock cannot be NULL");
+    return atomic_load_uint32(&lock->is_locked, MEMORY_ORDER_RELAXED) == 0
+        && atomic_exchange_uint32(&lock->is_locked, 1, MEMORY_ORDER_ACQUIRE) == 0;
+}
+
+void lock_spinlock(spinlock* lock) {
+    ASSERT(lock != NULL, return, "Spinlock cannot be NULL");
+    uint32_t backoff = 1;
+    while (atomic_exchange_uint32(&lock->is_locked, 1, MEMORY_ORDER_ACQUIRE) != 0) {
+        // Wait with plain loads until the lock looks free, so that waiting threads do not keep stealing the cache line from the owner.
+        while (atomic_load_uint32(&lock->is_locked, MEMORY_ORDER_RELAXED) != 0) {
+            if (backoff <= SPINLOCK_MAX_BACKOFF) {
+                for (uint32_t i = 0; i < backoff; ++i) {
+                    CPU_RELAX();
+                }
+                backoff *= 2;
+            }
+            else {
+                yield_thread();
+            }
+        }
+    }
+}
+
+void unlock_spinlock(spinlock* lock) {
+    ASSERT(lock != NULL, return, "Spinlock cannot be NULL");
+    DEBUG_ASSERT(atomic_load_uint32(&lock->is_locked, MEMORY_ORDER_RELAXED) != 0, return, "Unlocking a spinlock that is not locked");
+    atomic_store_uint32(&lock->is_locked, 0, MEMORY_ORDER_RELEASE);
+}
+
+result init_semaphore(semaphore* s, uint32_t initial_count) {
+    ASSERT(s != NULL, return RESULT_FAILURE, "Semaphore cannot be NULL");
+    atomic_store_uint32(&s->count, initial_count, MEMORY_ORDER_RELAXED);
+    atomic_store_uint32(&s->waiters, 0, MEMORY_ORDER_RELAXED);
+    return RESULT_SUCCESS;
+}
+
+bool try_wait_semaphore(semaphore* s) {
+    ASSERT(s != NULL, return false, "Semaphore cannot be NULL");
+    uint32_t count = atomic_load_uint32(&s->count, MEMORY_ORDER_RELAXED);
+    while (count > 0) {
+        if (atomic_compare_exchange_uint32(&s->count, &count, count - 1, MEMORY_ORDER_ACQUIRE)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void wait_semaphore(semaphore* s) {
+    ASSERT(s != NULL, return, "Semaphore cannot be NULL");
+    while (!try_wait_semaphore(s)) {
+        // Registering as a waiter before checking the count again pairs with signal_semaphore reading waiters after it adds to the count.
+        atomic_fetch_add_uint32(&s->waiters, 1, MEMORY_ORDER_SEQ_CST);
+        wait_on_address(&s->count, 0);
+        atomic_fetch_add_uint32(&s->waiters, (uint32_t)-1, MEMORY_ORDER_RELAXED);
+    }
+}
+
+void signal_semaphore(semaphore* s, uint32_t count) {
+    ASSERT(s != NULL, return, "Semaphore cannot be NULL");
+    if (count == 0) {
+        return;
+    }
+
+    atomic_fetch_add_uint32(&s->count, count, MEMORY_ORDER_SEQ_CST);
+    if (atomic_load_uint32(&s->waiters, MEMORY_ORDER_SEQ_CST) > 0) {
+        if (count == 1) {
+            wake_one_on_address(&s->count);
+        }
+        else {
+            wake_all_on_address(&s->count);
+        }
+    }
+}
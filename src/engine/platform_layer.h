@@ -4,6 +4,7 @@
 #include <stdalign.h>
 #include <stdbool.h>
 #include "fundamental.h"
+#include "engine_config.h"
 #include "geometry.h"
 
 typedef struct input input;
@@ -16,29 +17,253 @@ typedef struct audio audio;
 =============================================================================================================================
 */
 
+/*
+A bump allocator reserves its whole capacity of address space up front, and commits (backs with memory) pages as it grows.
+Each commit is at least min_commit_bytes, and grows geometrically with the committed size (up to max_commit_bytes per commit),
+so a large arena grows in a handful of system calls instead of one per page.
+
+With huge pages the arena is backed by 2 MiB pages (large pages on Windows, transparent huge pages on Linux) where the system allows it,
+which cuts TLB misses for big arenas. On Windows large pages need the "Lock pages in memory" privilege and are committed all at once;
+without the privilege the allocator falls back to normal pages.
+*/
+
+#ifndef BUMP_ALLOCATOR_MIN_COMMIT_BYTES
+#define BUMP_ALLOCATOR_MIN_COMMIT_BYTES (64 * 1024)
+#endif
+
+#ifndef BUMP_ALLOCATOR_MAX_COMMIT_BYTES
+#define BUMP_ALLOCATOR_MAX_COMMIT_BYTES (64 * 1024 * 1024)
+#endif
+
+#define BUMP_ALLOCATOR_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+// Zero for any member uses the default.
+typedef struct {
+    size_t min_commit_bytes;
+    size_t max_commit_bytes;
+    size_t decommit_above_bytes; // resetting gives back committed memory above this size (0 never decommits)
+    void* preferred_base; // reserve the arena at this address if it is free, so its snapshots can be loaded (see save_arena_snapshot)
+    bool use_huge_pages;
+} bump_allocator_options;
+
+/*
+Memory accounting (when ENABLE_MEMORY_ACCOUNTING is defined, see engine_config.h) records how much of each arena is used and by whom:
+the high-water mark of every frame (the most used between two resets), the highest of those overall, and bytes per tag.
+Allocate with BUMP_ALLOCATE_TAGGED to name who the memory is for (a subsystem, or MEMORY_TAG_HERE for the call site);
+plain bump_allocate counts as "untagged". Tag usage counts bytes allocated since the last reset, so memory given back by
+an arena scope stays counted until the reset. When accounting is disabled all of this compiles away.
+*/
+
+#ifndef MEMORY_ACCOUNTING_MAX_TAGS
+#define MEMORY_ACCOUNTING_MAX_TAGS 32
+#endif
+
+#define MEMORY_TAG_NAME_LENGTH 32
+#define MEMORY_TAG_HERE __FILE__ ":" TOSTRING(__LINE__)
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+
+typedef struct {
+    char name[MEMORY_TAG_NAME_LENGTH]; // copied, so tags from the game DLL stay readable after a hot reload
+    size_t bytes; // since the last reset
+    size_t peak_bytes; // the most bytes between two resets
+    uint64_t allocation_count;
+} memory_tag_usage;
+
+typedef struct {
+    const char* current_tag;
+    size_t high_water_bytes; // since the last reset
+    size_t previous_high_water_bytes; // between the last two resets (the last frame, for temp)
+    size_t peak_high_water_bytes;
+    uint64_t reset_count;
+    uint32_t tag_count;
+    memory_tag_usage tags[MEMORY_ACCOUNTING_MAX_TAGS]; // the last tag also counts every tag that did not fit
+} bump_allocator_accounting;
+
+#endif // ENABLE_MEMORY_ACCOUNTING
+
 typedef struct {
     void* base;
-    size_t next_page_bytes;
+    size_t next_page_bytes; // committed bytes
     size_t used_bytes;
     size_t capacity;
+    size_t page_size;
+    size_t min_commit_bytes;
+    size_t max_commit_bytes;
+    size_t decommit_above_bytes;
+    uint32_t commit_count; // system calls made to commit memory
+    uint32_t scope_depth; // arena scopes that have begun and not ended yet
+    bool uses_huge_pages;
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    bump_allocator_accounting accounting;
+#endif
 } bump_allocator;
 
 result create_bump_allocator(bump_allocator* allocator, size_t capacity);
+result create_bump_allocator_with_options(bump_allocator* allocator, size_t capacity, const bump_allocator_options* options);
 void destroy_bump_allocator(bump_allocator* allocator);
 void* bump_allocate(bump_allocator* allocator, size_t alignment, size_t bytes);
 
+// Gives committed memory above keep_bytes (and above what is in use) back to the system.
+void decommit_bump_allocator(bump_allocator* allocator, size_t keep_bytes);
+
+// How much bump_allocate should commit to reach new_used_bytes (shared by the platform layers).
+size_t get_bump_allocator_commit_bytes(const bump_allocator* allocator, size_t new_used_bytes);
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+
+void* bump_allocate_tagged(bump_allocator* allocator, size_t alignment, size_t bytes, const char* tag);
+#define BUMP_ALLOCATE_TAGGED(allocator, alignment, bytes, tag) bump_allocate_tagged(allocator, alignment, bytes, tag)
+
+// Called by the platform layers' bump_allocate and by reset_bump_allocator.
+void record_bump_allocation(bump_allocator* allocator, size_t previous_used_bytes);
+void record_bump_allocator_reset(bump_allocator* allocator);
+
+// Prints capacity, committed and used bytes, the high-water marks and the usage of every tag to stdout.
+void print_memory_report(const char* name, const bump_allocator* allocator);
+
+#else
+
+#define BUMP_ALLOCATE_TAGGED(allocator, alignment, bytes, tag) bump_allocate(allocator, alignment, bytes)
+
+static inline void print_memory_report(const char* name, const bump_allocator* allocator) {
+    (void)name;
+    (void)allocator;
+}
+
+#endif // ENABLE_MEMORY_ACCOUNTING
+
 static inline void reset_bump_allocator(bump_allocator* allocator) {
+    DEBUG_ASSERT(allocator->scope_depth == 0, , "Bump allocator reset with %u arena scope(s) still open", allocator->scope_depth);
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    record_bump_allocator_reset(allocator);
+#endif
     allocator->used_bytes = 0;
+    allocator->scope_depth = 0;
+    if (allocator->decommit_above_bytes != 0 && allocator->next_page_bytes > allocator->decommit_above_bytes) {
+        decommit_bump_allocator(allocator, allocator->decommit_above_bytes);
+    }
+}
+
+/*
+Arena scopes free everything allocated since the scope began, so a function can use the temp allocator for scratch space
+without keeping it until the end of the frame. Scopes nest, and must end in the reverse order they began (checked in debug builds).
+Nothing allocated inside a scope can be used after it ends, so results that outlive it belong in a different allocator.
+
+usage:
+    arena_scope scope = arena_scope_begin(temp);
+    string path = concat(directory, file_name, temp);
+    ...
+    arena_scope_end(scope);
+*/
+typedef struct {
+    bump_allocator* allocator;
+    size_t used_bytes;
+    uint32_t depth;
+} arena_scope;
+
+static inline arena_scope arena_scope_begin(bump_allocator* allocator) {
+    arena_scope scope = { allocator, allocator->used_bytes, ++allocator->scope_depth };
+    return scope;
+}
+
+static inline void arena_scope_end(arena_scope scope) {
+    bump_allocator* allocator = scope.allocator;
+    DEBUG_ASSERT(scope.depth == allocator->scope_depth, return,
+        "Arena scope %u ended while scope %u is the innermost one (scopes must end in reverse order)", scope.depth, allocator->scope_depth);
+    DEBUG_ASSERT(scope.used_bytes <= allocator->used_bytes, return, "Bump allocator was reset inside an arena scope");
+    allocator->used_bytes = scope.used_bytes;
+    --allocator->scope_depth;
 }
 
+// Runs the following statement or block inside an arena scope. Leaving it with return or goto skips the end of the scope, break is fine.
+#define ARENA_SCOPE(bump) ARENA_SCOPE_IMPL(bump, __LINE__)
+#define ARENA_SCOPE_IMPL(bump, line) ARENA_SCOPE_LOOP(bump, CONCATENATE(arena_scope_, line), CONCATENATE(arena_scope_once_, line))
+#define ARENA_SCOPE_LOOP(bump, scope, once) \
+    for (arena_scope scope = arena_scope_begin(bump); scope.allocator != NULL; arena_scope_end(scope), scope.allocator = NULL) \
+        for (int once = 0; !once; once = 1)
+
+/*
+Arena snapshots save part of an arena to a file so it can be loaded straight back into memory later (on the next launch, or to
+restore a saved state on demand) without any deserialization. A snapshot covers the arena from the start of a snapshot region up to
+what is in use, and is loaded back at the same address, so pointers inside the region stay valid. That needs the arena to be reserved
+at the same base every time (see bump_allocator_options.preferred_base) and to have the same layout up to the region.
+
+Everything in the region must be plain data: no OS handles, no pointers out of the region, and no function pointers (the game DLL
+moves on hot reload). Bump the version whenever the layout of the region changes, snapshots with a different version are not loaded.
+
+On POSIX the file is mapped copy-on-write over the region, so loading is one system call and pages are read in as they are touched.
+On Windows it is read into the region (mapping a file into part of a reservation needs the placeholder APIs of newer Windows 10 builds).
+
+usage:
+    size_t region = begin_arena_snapshot_region(&allocators->perm);
+    game_state* state = (game_state*)bump_allocate(&allocators->perm, alignof(game_state), sizeof(game_state));
+    ...
+    save_arena_snapshot(&allocators->perm, region, state, GAME_STATE_VERSION, path);
+    ...
+    load_arena_snapshot(&allocators->perm, region, GAME_STATE_VERSION, path, (void**)&state);
+*/
+
+#define ARENA_SNAPSHOT_MAGIC 0x50534E41u // "ANSP"
+
+// The region is stored this far into the file, which is a multiple of the page size (and of the Windows allocation granularity) so it can be mapped.
+#define ARENA_SNAPSHOT_DATA_OFFSET (64 * 1024)
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t base;
+    uint64_t begin; // offsets of the region in the arena
+    uint64_t end;
+    uint64_t root_offset;
+} arena_snapshot_header;
+
+// Pads the arena to a page boundary, and returns the offset of the snapshot region that starts there.
+size_t begin_arena_snapshot_region(bump_allocator* allocator);
+
+// Writes the arena from begin up to what is in use to path, with root (which must be in the region) for load_arena_snapshot to return.
+result save_arena_snapshot(const bump_allocator* allocator, size_t begin, const void* root, uint32_t version, string path);
+
+// Replaces everything in the arena from begin on with the snapshot at path, and returns its root. Nothing changes if the snapshot
+// has a different version, or was saved from an arena at another address or with the region at another offset.
+result load_arena_snapshot(bump_allocator* allocator, size_t begin, uint32_t version, string path, void** out_root);
+
+// Shared by the platform layers.
+arena_snapshot_header make_arena_snapshot_header(const bump_allocator* allocator, size_t begin, const void* root, uint32_t version);
+result check_arena_snapshot_header(const bump_allocator* allocator, size_t begin, uint32_t version, const arena_snapshot_header* header, string path);
+
 typedef struct memory_allocators {
     /* Temporary memory allocator, used for allocations that last for one frame. */
     bump_allocator temp;
 
     /* Permanent memory allocator, used for allocations that last for the entire program lifetime. */
     bump_allocator perm;
+
+    /* Frame memory allocators, used for allocations that are made in one frame and used in a later one (render snapshots,
+       deferred audio commands, data the GPU is still reading). They are used in turn, one per frame, so the data of frame N
+       stays valid until frame N + FRAME_ARENA_COUNT begins and its arena is reset. See get_frame_arena. */
+    bump_allocator frames[FRAME_ARENA_COUNT];
+    uint64_t frame_number;
 } memory_allocators;
 
+result create_frame_arenas(memory_allocators* allocators, size_t capacity, const bump_allocator_options* options);
+void destroy_frame_arenas(memory_allocators* allocators);
+
+// Moves on to the next frame, resetting the frame arena that was used FRAME_ARENA_COUNT frames ago.
+void advance_frame_arenas(memory_allocators* allocators);
+
+// The frame arena of the current frame.
+static inline bump_allocator* get_frame_arena(memory_allocators* allocators) {
+    return &allocators->frames[allocators->frame_number % FRAME_ARENA_COUNT];
+}
+
+// The frame arena of a frame that began frames_ago frames before this one (its data is still valid while frames_ago < FRAME_ARENA_COUNT).
+static inline bump_allocator* get_past_frame_arena(memory_allocators* allocators, uint32_t frames_ago) {
+    DEBUG_ASSERT(frames_ago < FRAME_ARENA_COUNT, return NULL,
+        "Frame arena from %u frames ago has already been reset (there are %d frame arenas)", frames_ago, FRAME_ARENA_COUNT);
+    return &allocators->frames[(allocators->frame_number - frames_ago) % FRAME_ARENA_COUNT];
+}
+
 
 /*
 =============================================================================================================================
@@ -59,17 +284,31 @@ result append_last_string(string* original, string to_append, bump_allocator* al
 =============================================================================================================================
 */
 
+/*
+Timestamps are raw 64-bit ticks of the platform's monotonic high-resolution counter (from an unspecified starting point).
+Reading one is cheap enough to use in profilers and job systems, and differences between them are exact, so precision
+does not degrade however long the program has been running. Convert differences to time units only when needed.
+*/
+uint64_t read_timestamp(void);
+uint64_t get_timestamp_frequency(void); // ticks per second
+uint64_t timestamp_to_nanoseconds(uint64_t ticks);
+double timestamp_to_seconds(uint64_t ticks);
+
 typedef struct {
-    float frequency;
-    float previous_update_time;
-    float time_since_previous_update;
-    float creation_time;
-    float time_since_creation;
+    uint64_t creation_timestamp;
+    uint64_t previous_update_timestamp;
+    uint64_t ticks_since_previous_update;
+    double time_since_creation; // seconds
+    float time_since_previous_update; // seconds
 } clock;
 
 result create_clock(clock* clock);
 void update_clock(clock* clock);
 
+// Puts the calling thread to sleep for at least the given number of ticks. This is a coarse OS sleep, it may oversleep
+// by a scheduler quantum (see frame_pacer.h for waits that need to be precise).
+void sleep_for_ticks(uint64_t ticks);
+
 /*
 =============================================================================================================================
     Graphics
@@ -104,6 +343,12 @@ static inline color color_from_uint32(uint32_t rgba) {
 #define FIXED_TIME_STEP (1.0f / 60.0f)
 #define MAX_UPDATES_PER_FRAME 5
 
+#ifndef DEFAULT_TARGET_FRAME_RATE
+#define DEFAULT_TARGET_FRAME_RATE 60
+#endif
+
+#define FRAME_RATE_UNLIMITED UINT32_MAX
+
 #ifndef MAX_SPRITES
 #define MAX_SPRITES 128
 #endif
@@ -144,6 +389,21 @@ vector2int get_virtual_resolution(graphics* graphics);
 #define AUDIO_DEFAULT_VOLUME 1.0f
 #endif
 
+// Horizontal distance (in listener screen units) at which a positional sound is panned fully to one side.
+#ifndef AUDIO_PAN_DISTANCE
+#define AUDIO_PAN_DISTANCE 512.0f
+#endif
+
+// Positional sounds closer than this distance to the listener are played at full volume.
+#ifndef AUDIO_ATTENUATION_MIN_DISTANCE
+#define AUDIO_ATTENUATION_MIN_DISTANCE 128.0f
+#endif
+
+// How quickly positional sounds fade beyond AUDIO_ATTENUATION_MIN_DISTANCE (inverse distance rolloff).
+#ifndef AUDIO_ATTENUATION_ROLLOFF
+#define AUDIO_ATTENUATION_ROLLOFF 1.0f
+#endif
+
 typedef enum {
     PLAYING_SOUND_NONE = 0,
     PLAYING_SOUND_LOOPING = 1 << 0,
@@ -152,6 +412,14 @@ typedef enum {
 
 result play_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration);
 
+/*
+Positional sounds are panned and attenuated relative to the audio listener.
+The pan and gain of every positional voice is computed in one batch per audio update (not per play/draw call),
+so you only need to move the listener once per frame (usually to the same camera that you draw with).
+*/
+result play_sound_at(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration, vector2 world_position);
+void set_audio_listener(audio* audio, camera_2d listener);
+
 typedef enum {
     STOPPING_ALL_INSTANCES,
     STOPPING_FIRST_FOUND,
@@ -304,6 +572,222 @@ bool file_exists(string path);
 result read_entire_file(string path, bump_allocator* allocator, string* out_file_contents);
 result write_entire_file(string path, const void* data, size_t size);
 
+/*
+=============================================================================================================================
+    Atomics
+=============================================================================================================================
+Atomic integers and pointers with explicit memory orders, in the spirit of C11 <stdatomic.h> (which MSVC does not fully support in C).
+They are inline so that they compile down to single instructions. An order that is not valid for an operation (such as a release load)
+is strengthened to the nearest valid one.
+*/
+
+typedef enum {
+    MEMORY_ORDER_RELAXED,
+    MEMORY_ORDER_ACQUIRE,
+    MEMORY_ORDER_RELEASE,
+    MEMORY_ORDER_ACQ_REL,
+    MEMORY_ORDER_SEQ_CST,
+} memory_ordering;
+
+typedef struct {
+    volatile uint32_t value;
+} atomic_uint32;
+
+typedef struct {
+    alignas(8) volatile uint64_t value;
+} atomic_uint64;
+
+typedef struct {
+    void* volatile value;
+} atomic_pointer;
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+
+// x86 and x64 only reorder stores after loads, so acquire and release just need to stop the compiler from reordering.
+#if defined(_M_ARM64)
+#define ATOMIC_ACQUIRE_RELEASE_BARRIER() __dmb(_ARM64_BARRIER_ISH)
+#else
+#define ATOMIC_ACQUIRE_RELEASE_BARRIER() _ReadWriteBarrier()
+#endif
+
+static inline uint32_t atomic_load_uint32(const atomic_uint32* atomic, memory_ordering order) {
+    uint32_t value = atomic->value;
+    if (order != MEMORY_ORDER_RELAXED) {
+        ATOMIC_ACQUIRE_RELEASE_BARRIER();
+    }
+    return value;
+}
+
+static inline void atomic_store_uint32(atomic_uint32* atomic, uint32_t value, memory_ordering order) {
+    if (order == MEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchange((volatile long*)&atomic->value, (long)value);
+        return;
+    }
+    if (order != MEMORY_ORDER_RELAXED) {
+        ATOMIC_ACQUIRE_RELEASE_BARRIER();
+    }
+    atomic->value = value;
+}
+
+static inline uint32_t atomic_exchange_uint32(atomic_uint32* atomic, uint32_t value, memory_ordering order) {
+    (void)order;
+    return (uint32_t)_InterlockedExchange((volatile long*)&atomic->value, (long)value);
+}
+
+static inline bool atomic_compare_exchange_uint32(atomic_uint32* atomic, uint32_t* expected, uint32_t desired, memory_ordering order) {
+    (void)order;
+    uint32_t previous = (uint32_t)_InterlockedCompareExchange((volatile long*)&atomic->value, (long)desired, (long)*expected);
+    bool exchanged = previous == *expected;
+    *expected = previous;
+    return exchanged;
+}
+
+static inline uint32_t atomic_fetch_add_uint32(atomic_uint32* atomic, uint32_t addend, memory_ordering order) {
+    (void)order;
+    return (uint32_t)_InterlockedExchangeAdd((volatile long*)&atomic->value, (long)addend);
+}
+
+static inline uint64_t atomic_load_uint64(const atomic_uint64* atomic, memory_ordering order) {
+    uint64_t value = atomic->value;
+    if (order != MEMORY_ORDER_RELAXED) {
+        ATOMIC_ACQUIRE_RELEASE_BARRIER();
+    }
+    return value;
+}
+
+static inline void atomic_store_uint64(atomic_uint64* atomic, uint64_t value, memory_ordering order) {
+    if (order == MEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchange64((volatile long long*)&atomic->value, (long long)value);
+        return;
+    }
+    if (order != MEMORY_ORDER_RELAXED) {
+        ATOMIC_ACQUIRE_RELEASE_BARRIER();
+    }
+    atomic->value = value;
+}
+
+static inline uint64_t atomic_exchange_uint64(atomic_uint64* atomic, uint64_t value, memory_ordering order) {
+    (void)order;
+    return (uint64_t)_InterlockedExchange64((volatile long long*)&atomic->value, (long long)value);
+}
+
+static inline bool atomic_compare_exchange_uint64(atomic_uint64* atomic, uint64_t* expected, uint64_t desired, memory_ordering order) {
+    (void)order;
+    uint64_t previous = (uint64_t)_InterlockedCompareExchange64((volatile long long*)&atomic->value, (long long)desired, (long long)*expected);
+    bool exchanged = previous == *expected;
+    *expected = previous;
+    return exchanged;
+}
+
+static inline uint64_t atomic_fetch_add_uint64(atomic_uint64* atomic, uint64_t addend, memory_ordering order) {
+    (void)order;
+    return (uint64_t)_InterlockedExchangeAdd64((volatile long long*)&atomic->value, (long long)addend);
+}
+
+static inline void* atomic_load_pointer(const atomic_pointer* atomic, memory_ordering order) {
+    void* value = atomic->value;
+    if (order != MEMORY_ORDER_RELAXED) {
+        ATOMIC_ACQUIRE_RELEASE_BARRIER();
+    }
+    return value;
+}
+
+static inline void atomic_store_pointer(atomic_pointer* atomic, void* value, memory_ordering order) {
+    if (order == MEMORY_ORDER_SEQ_CST) {
+        _InterlockedExchangePointer((void* volatile*)&atomic->value, value);
+        return;
+    }
+    if (order != MEMORY_ORDER_RELAXED) {
+        ATOMIC_ACQUIRE_RELEASE_BARRIER();
+    }
+    atomic->value = value;
+}
+
+static inline void* atomic_exchange_pointer(atomic_pointer* atomic, void* value, memory_ordering order) {
+    (void)order;
+    return _InterlockedExchangePointer((void* volatile*)&atomic->value, value);
+}
+
+static inline bool atomic_compare_exchange_pointer(atomic_pointer* atomic, void** expected, void* desired, memory_ordering order) {
+    (void)order;
+    void* previous = _InterlockedCompareExchangePointer((void* volatile*)&atomic->value, desired, *expected);
+    bool exchanged = previous == *expected;
+    *expected = previous;
+    return exchanged;
+}
+
+static inline void atomic_fence(memory_ordering order) {
+    if (order == MEMORY_ORDER_SEQ_CST) {
+#if defined(_M_ARM64)
+        __dmb(_ARM64_BARRIER_ISH);
+#else
+        _mm_mfence();
+#endif
+    }
+    else if (order != MEMORY_ORDER_RELAXED) {
+        ATOMIC_ACQUIRE_RELEASE_BARRIER();
+    }
+}
+
+#else
+
+static inline int atomic_order_for_load(memory_ordering order) {
+    return order == MEMORY_ORDER_RELAXED ? __ATOMIC_RELAXED : order == MEMORY_ORDER_SEQ_CST ? __ATOMIC_SEQ_CST : __ATOMIC_ACQUIRE;
+}
+
+static inline int atomic_order_for_store(memory_ordering order) {
+    return order == MEMORY_ORDER_RELAXED ? __ATOMIC_RELAXED : order == MEMORY_ORDER_SEQ_CST ? __ATOMIC_SEQ_CST : __ATOMIC_RELEASE;
+}
+
+static inline int atomic_order_for_read_modify_write(memory_ordering order) {
+    switch (order) {
+    case MEMORY_ORDER_RELAXED: return __ATOMIC_RELAXED;
+    case MEMORY_ORDER_ACQUIRE: return __ATOMIC_ACQUIRE;
+    case MEMORY_ORDER_RELEASE: return __ATOMIC_RELEASE;
+    case MEMORY_ORDER_ACQ_REL: return __ATOMIC_ACQ_REL;
+    default: return __ATOMIC_SEQ_CST;
+    }
+}
+
+// The order used when a compare-exchange fails cannot be a release order.
+static inline int atomic_order_for_failure(memory_ordering order) {
+    return order == MEMORY_ORDER_SEQ_CST ? __ATOMIC_SEQ_CST : order == MEMORY_ORDER_RELAXED || order == MEMORY_ORDER_RELEASE ? __ATOMIC_RELAXED : __ATOMIC_ACQUIRE;
+}
+
+#define IMPLEMENT_ATOMIC_OPERATIONS(name, atomic_type, value_type) \
+    static inline value_type atomic_load_##name(const atomic_type* atomic, memory_ordering order) { \
+        return __atomic_load_n(&atomic->value, atomic_order_for_load(order)); \
+    } \
+    static inline void atomic_store_##name(atomic_type* atomic, value_type value, memory_ordering order) { \
+        __atomic_store_n(&atomic->value, value, atomic_order_for_store(order)); \
+    } \
+    static inline value_type atomic_exchange_##name(atomic_type* atomic, value_type value, memory_ordering order) { \
+        return __atomic_exchange_n(&atomic->value, value, atomic_order_for_read_modify_write(order)); \
+    } \
+    static inline bool atomic_compare_exchange_##name(atomic_type* atomic, value_type* expected, value_type desired, memory_ordering order) { \
+        return __atomic_compare_exchange_n(&atomic->value, expected, desired, false, atomic_order_for_read_modify_write(order), atomic_order_for_failure(order)); \
+    }
+
+IMPLEMENT_ATOMIC_OPERATIONS(uint32, atomic_uint32, uint32_t)
+IMPLEMENT_ATOMIC_OPERATIONS(uint64, atomic_uint64, uint64_t)
+IMPLEMENT_ATOMIC_OPERATIONS(pointer, atomic_pointer, void*)
+#undef IMPLEMENT_ATOMIC_OPERATIONS
+
+static inline uint32_t atomic_fetch_add_uint32(atomic_uint32* atomic, uint32_t addend, memory_ordering order) {
+    return __atomic_fetch_add(&atomic->value, addend, atomic_order_for_read_modify_write(order));
+}
+
+static inline uint64_t atomic_fetch_add_uint64(atomic_uint64* atomic, uint64_t addend, memory_ordering order) {
+    return __atomic_fetch_add(&atomic->value, addend, atomic_order_for_read_modify_write(order));
+}
+
+static inline void atomic_fence(memory_ordering order) {
+    __atomic_thread_fence(atomic_order_for_read_modify_write(order));
+}
+
+#endif
+
 /*
 =============================================================================================================================
     Multi-threading
@@ -314,6 +798,9 @@ typedef union {
 #ifdef _WIN32
     uint64_t alignment_dummy;
     uint8_t internals[8];
+#elif defined(__unix__) || defined(__APPLE__)
+    uint64_t alignment_dummy;
+    uint8_t internals[64];
 #else
 #error Unsupported platform for mutex structure
 #endif
@@ -323,14 +810,22 @@ typedef union {
 #ifdef _WIN32
     uint64_t alignment_dummy;
     uint8_t internals[8];
+#elif defined(__unix__) || defined(__APPLE__)
+    uint64_t alignment_dummy;
+    uint8_t internals[32];
 #else
 #error Unsupported platform for thread structure
 #endif
 } thread;
 
 typedef union {
+#ifdef _WIN32
     uint64_t alignment_dummy;
     uint8_t internals[8];
+#else
+    uint64_t alignment_dummy;
+    uint8_t internals[64];
+#endif
 } condition_variable;
 
 result create_mutex(mutex* m);
@@ -343,26 +838,93 @@ result join_thread(thread* t);
 void destroy_thread(thread* t);
 
 result init_condition_variable(condition_variable* cv);
+void destroy_condition_variable(condition_variable* cv);
 result signal_condition_variable(condition_variable* cv);
+result broadcast_condition_variable(condition_variable* cv); // wakes every waiting thread
 result wait_condition_variable(condition_variable* cv, mutex* m);
 
+// The number of logical processors available to the process (at least 1).
+uint32_t get_processor_count(void);
+
+// Gives the rest of the calling thread's time slice to another thread that is ready to run.
+void yield_thread(void);
+
+// An identifier for the calling thread, unique among the threads that are running.
+uint64_t get_current_thread_id(void);
+
+/*
+Futex-style waiting on an address: wait_on_address blocks while the value at the address equals expected,
+until another thread changes it and calls one of the wake functions. It can also return spuriously, so always wait in a loop.
+These only enter the kernel when a thread actually has to sleep, which makes them the building block for the locks below.
+*/
+void wait_on_address(atomic_uint32* address, uint32_t expected);
+void wake_one_on_address(atomic_uint32* address);
+void wake_all_on_address(atomic_uint32* address);
+
+/*
+A spinlock for very short critical sections. Waiting threads spin with exponential backoff,
+and start yielding their time slice when the lock is held for longer. Initialize with { 0 }.
+*/
+typedef struct {
+    atomic_uint32 is_locked;
+} spinlock;
+
+bool try_lock_spinlock(spinlock* lock);
+void lock_spinlock(spinlock* lock);
+void unlock_spinlock(spinlock* lock);
+
+// A counting semaphore. Waiting is a compare-exchange while the count is positive, and only sleeps (with wait_on_address) when it is zero.
+typedef struct {
+    atomic_uint32 count;
+    atomic_uint32 waiters;
+} semaphore;
+
+result init_semaphore(semaphore* s, uint32_t initial_count);
+void wait_semaphore(semaphore* s);
+bool try_wait_semaphore(semaphore* s);
+void signal_semaphore(semaphore* s, uint32_t count);
+
+// A reader-writer lock: any number of threads can hold it shared, or one thread exclusively.
+typedef union {
+#ifdef _WIN32
+    uint64_t alignment_dummy;
+    uint8_t internals[8];
+#elif defined(__unix__) || defined(__APPLE__)
+    uint64_t alignment_dummy;
+    uint8_t internals[256];
+#else
+#error Unsupported platform for rwlock structure
+#endif
+} rwlock;
+
+result create_rwlock(rwlock* lock);
+result lock_rwlock_shared(rwlock* lock);
+result unlock_rwlock_shared(rwlock* lock);
+result lock_rwlock_exclusive(rwlock* lock);
+result unlock_rwlock_exclusive(rwlock* lock);
+void destroy_rwlock(rwlock* lock);
+
 /*
 =============================================================================================================================
     Game Loop Parameters
 =============================================================================================================================
 */
 
+typedef struct job_system job_system; // see job_system.h
+
 typedef struct {
     void* game_state;
     audio* audio;
     memory_allocators* memory_allocators;
     input* input;
+    job_system* jobs;
     float delta_time;
 } update_params;
 
 typedef struct {
     void* game_state;
     bump_allocator* temp_allocator;
+    bump_allocator* frame_allocator; // the current frame arena, for data that has to outlive the frame (see get_frame_arena)
     graphics* graphics;
     float delta_time;
 } draw_params;
@@ -392,6 +954,12 @@ typedef struct {
     You need to provide your desired virtual resolution here and the platform layer will handle the rest (scaling up while keeping the aspect ratio the same, letterboxing as needed and so on).
     */
     vector2int virtual_resolution;
+
+    /*
+    The main loop sleeps between frames to hold this frame rate, instead of spinning a CPU core at 100% (see frame_pacer.h).
+    Leave as 0 for DEFAULT_TARGET_FRAME_RATE, or use FRAME_RATE_UNLIMITED to render as fast as possible.
+    */
+    uint32_t target_frame_rate;
 } init_out_params;
 
 
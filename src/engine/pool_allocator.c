@@ -0,0 +1,150 @@
+#include "pool_allocator.h"
+
+result create_pool_allocator(pool_allocator* pool, bump_allocator* allocator, size_t block_size, size_t alignment, uint32_t capacity) {
+    ASSERT(pool != NULL, return RESULT_FAILURE, "Pool allocator cannot be NULL");
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Bump allocator cannot be NULL");
+    ASSERT(alignment && (alignment & (alignment - 1)) == 0, return RESULT_FAILURE, "Pool alignment must be a power of two");
+    ASSERT(capacity > 0, return RESULT_FAILURE, "Pool capacity must be greater than zero");
+    memset(pool, 0, sizeof(pool_allocator));
+
+    // Every block has to be able to hold the free list link, at the link's alignment.
+    if (alignment < alignof(pool_block)) {
+        alignment = alignof(pool_block);
+    }
+    if (block_size < sizeof(pool_block)) {
+        block_size = sizeof(pool_block);
+    }
+    block_size = (block_size + (alignment - 1)) & ~(alignment - 1);
+
+    pool->blocks = (uint8_t*)BUMP_ALLOCATE_TAGGED(allocator, alignment, block_size * capacity, "pool_allocator");
+    ASSERT(pool->blocks != NULL, return RESULT_FAILURE, "Failed to allocate %u pool blocks of %zu bytes", capacity, block_size);
+    pool->block_size = block_size;
+    pool->capacity = capacity;
+    return RESULT_SUCCESS;
+}
+
+void reset_pool_allocator(pool_allocator* pool) {
+    ASSERT(pool != NULL, return, "Pool allocator cannot be NULL");
+    lock_spinlock(&pool->lock);
+    pool->free_list = NULL;
+    pool->carved_count = 0;
+    pool->in_use = 0;
+    unlock_spinlock(&pool->lock);
+}
+
+// Takes up to count blocks from the pool while holding the lock. Returns how many it took.
+static uint32_t take_blocks(pool_allocator* pool, pool_block** out_blocks, uint32_t count) {
+    uint32_t taken = 0;
+    lock_spinlock(&pool->lock);
+    while (taken < count && pool->free_list != NULL) {
+        out_blocks[taken++] = pool->free_list;
+        pool->free_list = pool->free_list->next;
+    }
+    while (taken < count && pool->carved_count < pool->capacity) {
+        out_blocks[taken++] = (pool_block*)(pool->blocks + (size_t)pool->carved_count * pool->block_size);
+        ++pool->carved_count;
+    }
+
+    pool->in_use += taken;
+    if (pool->in_use > pool->peak_in_use) {
+        pool->peak_in_use = pool->in_use;
+    }
+    pool->allocation_count += taken;
+    if (taken == 0) {
+        ++pool->failed_allocation_count;
+    }
+    unlock_spinlock(&pool->lock);
+    return taken;
+}
+
+static void return_blocks(pool_allocator* pool, pool_block** blocks, uint32_t count) {
+    if (count == 0) {
+        return;
+    }
+
+    // Link the blocks up before taking the lock, so the lock is only held to splice them in.
+    for (uint32_t i = 0; i + 1 < count; ++i) {
+        blocks[i]->next = blocks[i + 1];
+    }
+
+    lock_spinlock(&pool->lock);
+    DEBUG_ASSERT(pool->in_use >= count, , "More blocks returned to the pool than were taken from it");
+    blocks[count - 1]->next = pool->free_list;
+    pool->free_list = blocks[0];
+    pool->in_use -= count;
+    unlock_spinlock(&pool->lock);
+}
+
+#ifndef NDEBUG
+static bool is_valid_block(const pool_allocator* pool, const void* block) {
+    return pool_owns(pool, block) && ((size_t)((const uint8_t*)block - pool->blocks) % pool->block_size) == 0;
+}
+#endif
+
+void* pool_allocate(pool_allocator* pool) {
+    ASSERT(pool != NULL, return NULL, "Pool allocator cannot be NULL");
+    pool_block* block = NULL;
+    take_blocks(pool, &block, 1);
+    return block;
+}
+
+void pool_free(pool_allocator* pool, void* block) {
+    ASSERT(pool != NULL, return, "Pool allocator cannot be NULL");
+    if (block == NULL) {
+        return;
+    }
+
+    DEBUG_ASSERT(is_valid_block(pool, block), return, "Freed pointer %p is not a block of this pool", block);
+    pool_block* freed = (pool_block*)block;
+    return_blocks(pool, &freed, 1);
+}
+
+void* pool_cache_allocate(pool_allocator* pool, pool_cache* cache) {
+    ASSERT(pool != NULL, return NULL, "Pool allocator cannot be NULL");
+    ASSERT(cache != NULL, return NULL, "Pool cache cannot be NULL");
+
+    if (cache->count == 0) {
+        cache->count = take_blocks(pool, cache->blocks, POOL_CACHE_CAPACITY / 2);
+        if (cache->count == 0) {
+            return NULL;
+        }
+    }
+    return cache->blocks[--cache->count];
+}
+
+void pool_cache_free(pool_allocator* pool, pool_cache* cache, void* block) {
+    ASSERT(pool != NULL, return, "Pool allocator cannot be NULL");
+    ASSERT(cache != NULL, return, "Pool cache cannot be NULL");
+    if (block == NULL) {
+        return;
+    }
+
+    DEBUG_ASSERT(is_valid_block(pool, block), return, "Freed pointer %p is not a block of this pool", block);
+    if (cache->count == POOL_CACHE_CAPACITY) {
+        // Keep the most recently freed half (the warmest in cache) and give the older half back.
+        return_blocks(pool, cache->blocks, POOL_CACHE_CAPACITY / 2);
+        memmove(cache->blocks, cache->blocks + POOL_CACHE_CAPACITY / 2, sizeof(pool_block*) * (POOL_CACHE_CAPACITY / 2));
+        cache->count = POOL_CACHE_CAPACITY / 2;
+    }
+    cache->blocks[cache->count++] = (pool_block*)block;
+}
+
+void flush_pool_cache(pool_allocator* pool, pool_cache* cache) {
+    ASSERT(pool != NULL, return, "Pool allocator cannot be NULL");
+    ASSERT(cache != NULL, return, "Pool cache cannot be NULL");
+    return_blocks(pool, cache->blocks, cache->count);
+    cache->count = 0;
+}
+
+pool_statistics get_pool_statistics(pool_allocator* pool) {
+    pool_statistics statistics = { 0 };
+    ASSERT(pool != NULL, return statistics, "Pool allocator cannot be NULL");
+    lock_spinlock(&pool->lock);
+    statistics.capacity = pool->capacity;
+    statistics.in_use = pool->in_use;
+    statistics.peak_in_use = pool->peak_in_use;
+    statistics.allocation_count = pool->allocation_count;
+    statistics.failed_allocation_count = pool->failed_allocation_count;
+    unlock_spinlock(&pool->lock);
+    return statistics;
+}
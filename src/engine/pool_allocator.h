@@ -0,0 +1,86 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+#include "platform_layer.h"
+
+/*
+A pool of fixed-size blocks carved from a bump allocator, for objects that are created and destroyed individually
+(projectiles, particles, voices) without fragmenting the arena or leaking until it is reset.
+
+Free blocks form an intrusive linked list (the link is stored in the free block itself), so allocating and freeing are O(1).
+The whole block range (block_size * capacity) is taken from the bump allocator when the pool is created, so size the pool for
+its peak. Blocks are only linked into the free list the first time they are needed, so creating a large pool is still O(1).
+Allocating from a full pool returns NULL and is counted in the statistics: it is up to the caller to recycle something.
+
+The pool is safe to use from any thread (a spinlock guards the free list). Threads that allocate and free a lot can keep a
+pool_cache, which hands out blocks without locking and only goes back to the pool to refill or flush half of it at a time.
+
+usage:
+    pool_allocator projectile_pool;
+    create_pool_allocator(&projectile_pool, &allocators->perm, sizeof(projectile), alignof(projectile), MAX_PROJECTILES);
+    projectile* proj = (projectile*)pool_allocate(&projectile_pool);
+    ...
+    pool_free(&projectile_pool, proj);
+*/
+
+// Blocks a pool_cache holds before it returns half of them to the pool.
+#ifndef POOL_CACHE_CAPACITY
+#define POOL_CACHE_CAPACITY 64
+#endif
+
+typedef struct pool_block {
+    struct pool_block* next;
+} pool_block;
+
+typedef struct {
+    uint8_t* blocks;
+    size_t block_size;
+    uint32_t capacity;
+
+    spinlock lock; // guards everything below
+    pool_block* free_list;
+    uint32_t carved_count; // blocks at the start of the range that have been handed out at least once
+
+    // Statistics. Blocks sitting in a pool_cache count as in use.
+    uint32_t in_use;
+    uint32_t peak_in_use;
+    uint64_t allocation_count;
+    uint64_t failed_allocation_count;
+} pool_allocator;
+
+typedef struct {
+    uint32_t capacity;
+    uint32_t in_use;
+    uint32_t peak_in_use;
+    uint64_t allocation_count; // blocks taken from the pool (a cache refill counts each block)
+    uint64_t failed_allocation_count;
+} pool_statistics;
+
+// Owned by one thread. Initialize with { 0 }, and flush it before the thread exits or the pool is reset.
+typedef struct {
+    uint32_t count;
+    pool_block* blocks[POOL_CACHE_CAPACITY];
+} pool_cache;
+
+// Reserves capacity blocks of at least block_size bytes (rounded up to the alignment) from the allocator.
+result create_pool_allocator(pool_allocator* pool, bump_allocator* allocator, size_t block_size, size_t alignment, uint32_t capacity);
+
+// Frees every block at once. No cache may still hold blocks from the pool.
+void reset_pool_allocator(pool_allocator* pool);
+
+void* pool_allocate(pool_allocator* pool);
+void pool_free(pool_allocator* pool, void* block);
+
+void* pool_cache_allocate(pool_allocator* pool, pool_cache* cache);
+void pool_cache_free(pool_allocator* pool, pool_cache* cache, void* block);
+
+// Returns every block held by the cache to the pool.
+void flush_pool_cache(pool_allocator* pool, pool_cache* cache);
+
+pool_statistics get_pool_statistics(pool_allocator* pool);
+
+static inline bool pool_owns(const pool_allocator* pool, const void* block) {
+    const uint8_t* address = (const uint8_t*)block;
+    return address >= pool->blocks && address < pool->blocks + pool->block_size * pool->capacity;
+}
+
+#endif // POOL_ALLOCATOR_H
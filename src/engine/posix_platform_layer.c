@@ -0,0 +1,855 @@
+#define _GNU_SOURCE
+
+// <time.h> declares a clock() function that conflicts with the engine's clock type, so it is renamed while the system headers are included.
+#define clock posix_clock
+#include <time.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#undef clock
+
+#include "platform_layer.h"
+#include "headless_platform_layer.h"
+#include "bitset.h"
+
+/*
+=============================================================================================================================
+    Memory Allocation
+=============================================================================================================================
+*/
+
+static void apply_bump_allocator_options(bump_allocator* allocator, const bump_allocator_options* options) {
+    allocator->min_commit_bytes = options != NULL && options->min_commit_bytes != 0 ? options->min_commit_bytes : BUMP_ALLOCATOR_MIN_COMMIT_BYTES;
+    allocator->max_commit_bytes = options != NULL && options->max_commit_bytes != 0 ? options->max_commit_bytes : BUMP_ALLOCATOR_MAX_COMMIT_BYTES;
+    allocator->decommit_above_bytes = options != NULL ? options->decommit_above_bytes : 0;
+}
+
+result create_bump_allocator_with_options(bump_allocator* allocator, size_t capacity, const bump_allocator_options* options) {
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    memset(allocator, 0, sizeof(*allocator));
+    apply_bump_allocator_options(allocator, options);
+    bool use_huge_pages = options != NULL && options->use_huge_pages;
+    allocator->page_size = use_huge_pages ? BUMP_ALLOCATOR_HUGE_PAGE_SIZE : (size_t)sysconf(_SC_PAGESIZE);
+    capacity = (capacity + (allocator->page_size - 1)) & ~(allocator->page_size - 1);
+
+    // Reserve the address space without any access, pages are committed (made read/write) as the allocator grows.
+    // Huge pages need the range to be aligned to the huge page size, so reserve a little more and unmap what is left over.
+    size_t reserve_bytes = use_huge_pages ? capacity + BUMP_ALLOCATOR_HUGE_PAGE_SIZE : capacity;
+    void* reserved = MAP_FAILED;
+    if (options != NULL && options->preferred_base != NULL) {
+        // Without MAP_FIXED_NOREPLACE the address is only a hint, so check it was taken.
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE;
+#if defined(MAP_FIXED_NOREPLACE)
+        flags |= MAP_FIXED_NOREPLACE;
+#endif
+        reserved = mmap(options->preferred_base, reserve_bytes, PROT_NONE, flags, -1, 0);
+        if (reserved != MAP_FAILED && reserved != options->preferred_base) {
+            munmap(reserved, reserve_bytes);
+            reserved = MAP_FAILED;
+        }
+    }
+    if (reserved == MAP_FAILED) {
+        reserved = mmap(NULL, reserve_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    }
+    if (reserved == MAP_FAILED) {
+        BUG("Failed to reserve virtual memory for bump allocator. Error: %d", errno);
+        return RESULT_FAILURE;
+    }
+
+    uint8_t* base = (uint8_t*)reserved;
+    if (use_huge_pages) {
+        base = (uint8_t*)(((uintptr_t)reserved + (BUMP_ALLOCATOR_HUGE_PAGE_SIZE - 1)) & ~(uintptr_t)(BUMP_ALLOCATOR_HUGE_PAGE_SIZE - 1));
+        size_t head_bytes = (size_t)(base - (uint8_t*)reserved);
+        if (head_bytes > 0) {
+            munmap(reserved, head_bytes);
+        }
+        if (reserve_bytes - head_bytes > capacity) {
+            munmap(base + capacity, reserve_bytes - head_bytes - capacity);
+        }
+
+#if defined(MADV_HUGEPAGE)
+        // Transparent huge pages rather than MAP_HUGETLB: hugetlbfs needs a pool of pages set aside by the administrator.
+        allocator->uses_huge_pages = madvise(base, capacity, MADV_HUGEPAGE) == 0;
+#endif
+    }
+
+    allocator->base = base;
+    allocator->capacity = capacity;
+    return RESULT_SUCCESS;
+}
+
+void destroy_bump_allocator(bump_allocator* allocator) {
+    ASSERT(allocator != NULL, return, "Allocator cannot be NULL");
+    if (allocator->base) {
+        munmap(allocator->base, allocator->capacity);
+        memset(allocator, 0, sizeof(*allocator));
+    }
+}
+
+void* bump_allocate(bump_allocator* allocator, size_t alignment, size_t bytes) {
+    ASSERT(allocator != NULL, return NULL, "Allocator cannot be NULL");
+    ASSERT(alignment && (alignment & (alignment - 1)) == 0, alignment = 1, "alignment must be a power of two");
+
+    size_t aligned = (allocator->used_bytes + (alignment - 1)) & ~(alignment - 1);
+    size_t new_used_bytes = aligned + bytes;
+    if (new_used_bytes > allocator->capacity) {
+        BUG("Out of memory for bump allocator.");
+        return NULL;
+    }
+
+    if (new_used_bytes > allocator->next_page_bytes) {
+        // Need to commit more memory.
+        size_t commit_size = get_bump_allocator_commit_bytes(allocator, new_used_bytes);
+        if (mprotect((uint8_t*)allocator->base + allocator->next_page_bytes, commit_size, PROT_READ | PROT_WRITE) != 0) {
+            BUG("Failed to commit more memory for bump allocator.");
+            return NULL;
+        }
+
+        allocator->next_page_bytes += commit_size;
+        ++allocator->commit_count;
+    }
+
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    size_t previous_used_bytes = allocator->used_bytes;
+    allocator->used_bytes = new_used_bytes;
+    record_bump_allocation(allocator, previous_used_bytes);
+#else
+    allocator->used_bytes = new_used_bytes;
+#endif
+    return (uint8_t*)allocator->base + aligned;
+}
+
+void decommit_bump_allocator(bump_allocator* allocator, size_t keep_bytes) {
+    ASSERT(allocator != NULL, return, "Allocator cannot be NULL");
+    if (keep_bytes < allocator->used_bytes) {
+        keep_bytes = allocator->used_bytes;
+    }
+    keep_bytes = (keep_bytes + (allocator->page_size - 1)) & ~(allocator->page_size - 1);
+    if (keep_bytes >= allocator->next_page_bytes) {
+        return;
+    }
+
+    // MADV_DONTNEED drops the pages (they read back as zero), and PROT_NONE catches use of memory that is no longer committed.
+    uint8_t* decommit_start = (uint8_t*)allocator->base + keep_bytes;
+    size_t decommit_bytes = allocator->next_page_bytes - keep_bytes;
+    if (madvise(decommit_start, decommit_bytes, MADV_DONTNEED) != 0 || mprotect(decommit_start, decommit_bytes, PROT_NONE) != 0) {
+        BUG("Failed to decommit bump allocator memory. Error: %d", errno);
+        return;
+    }
+    allocator->next_page_bytes = keep_bytes;
+}
+
+result save_arena_snapshot(const bump_allocator* allocator, size_t begin, const void* root, uint32_t version, string path) {
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(begin <= allocator->used_bytes, return RESULT_FAILURE, "Snapshot region begins after the end of the arena");
+    arena_snapshot_header header = make_arena_snapshot_header(allocator, begin, root, version);
+    ASSERT(header.root_offset >= begin && header.root_offset < header.end, return RESULT_FAILURE, "Snapshot root is not in the snapshot region");
+
+    // The snapshot is written next to the file and renamed over it. The region may be mapped from the old file (see load_arena_snapshot),
+    // and truncating that file would pull the pages out from under the mapping; the renamed-over file lives on while it is mapped.
+    char temporary_path[PATH_MAX];
+    int temporary_length = snprintf(temporary_path, sizeof(temporary_path), "%.*s.tmp", (int)path.length, path.text);
+    ASSERT(temporary_length > 0 && (size_t)temporary_length < sizeof(temporary_path), return RESULT_FAILURE, "Arena snapshot path is too long: %.*s", path.length, path.text);
+    int file_handle = open(temporary_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file_handle < 0) {
+        BUG("Failed to open file for writing: %s", temporary_path);
+        return RESULT_FAILURE;
+    }
+
+    // The gap between the header and the region is left as a hole in the file.
+    const uint8_t* region = (const uint8_t*)allocator->base + begin;
+    size_t region_bytes = (size_t)(header.end - header.begin);
+    bool written = pwrite(file_handle, &header, sizeof(header), 0) == (ssize_t)sizeof(header);
+    size_t total_written = 0;
+    while (written && total_written < region_bytes) {
+        ssize_t bytes_written = pwrite(file_handle, region + total_written, region_bytes - total_written, (off_t)(ARENA_SNAPSHOT_DATA_OFFSET + total_written));
+        written = bytes_written > 0;
+        total_written += written ? (size_t)bytes_written : 0;
+    }
+
+    close(file_handle);
+    if (!written || rename(temporary_path, path.text) != 0) {
+        BUG("Failed to write arena snapshot: %.*s. Error: %d", path.length, path.text, errno);
+        unlink(temporary_path);
+        return RESULT_FAILURE;
+    }
+    return RESULT_SUCCESS;
+}
+
+result load_arena_snapshot(bump_allocator* allocator, size_t begin, uint32_t version, string path, void** out_root) {
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(out_root != NULL, return RESULT_FAILURE, "Output root cannot be NULL");
+    ASSERT(begin <= allocator->used_bytes, return RESULT_FAILURE, "Snapshot region begins after the end of the arena");
+    ASSERT((begin & (allocator->page_size - 1)) == 0, return RESULT_FAILURE, "Snapshot region does not begin on a page (see begin_arena_snapshot_region)");
+    DEBUG_ASSERT(allocator->scope_depth == 0, return RESULT_FAILURE, "Arena snapshot loaded with %u arena scope(s) still open", allocator->scope_depth);
+
+    int file_handle = open(path.text, O_RDONLY);
+    if (file_handle < 0) {
+        BUG("Failed to open file for reading: %.*s", path.length, path.text);
+        return RESULT_FAILURE;
+    }
+
+    arena_snapshot_header header;
+    struct stat file_info;
+    if (pread(file_handle, &header, sizeof(header), 0) != (ssize_t)sizeof(header) || fstat(file_handle, &file_info) != 0) {
+        BUG("Failed to read arena snapshot: %.*s", path.length, path.text);
+        close(file_handle);
+        return RESULT_FAILURE;
+    }
+    if (check_arena_snapshot_header(allocator, begin, version, &header, path) != RESULT_SUCCESS) {
+        close(file_handle);
+        return RESULT_FAILURE;
+    }
+    if ((uint64_t)file_info.st_size < ARENA_SNAPSHOT_DATA_OFFSET + (header.end - header.begin)) {
+        BUG("Arena snapshot is shorter than its header says: %.*s", path.length, path.text);
+        close(file_handle);
+        return RESULT_FAILURE;
+    }
+
+    // Map the file copy-on-write over the region, so changes made after loading never reach the file.
+    // The file must not shrink while it is mapped, which is why save_arena_snapshot replaces it instead of rewriting it.
+    size_t system_page_size = (size_t)sysconf(_SC_PAGESIZE);
+    size_t map_bytes = ((size_t)(header.end - header.begin) + (system_page_size - 1)) & ~(system_page_size - 1);
+    void* region = (uint8_t*)allocator->base + begin;
+    void* mapped = mmap(region, map_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, file_handle, ARENA_SNAPSHOT_DATA_OFFSET);
+    close(file_handle);
+    if (mapped == MAP_FAILED) {
+        BUG("Failed to map arena snapshot: %.*s. Error: %d", path.length, path.text, errno);
+        return RESULT_FAILURE;
+    }
+
+    if (begin + map_bytes > allocator->next_page_bytes) {
+        allocator->next_page_bytes = begin + map_bytes;
+    }
+    allocator->used_bytes = (size_t)header.end;
+    *out_root = (uint8_t*)allocator->base + header.root_offset;
+    return RESULT_SUCCESS;
+}
+
+/*
+=============================================================================================================================
+    Time
+=============================================================================================================================
+*/
+
+// CLOCK_MONOTONIC already counts in nanoseconds, so one tick is one nanosecond.
+uint64_t read_timestamp(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+uint64_t get_timestamp_frequency(void) {
+    return 1000000000ull;
+}
+
+void sleep_for_ticks(uint64_t ticks) {
+    struct timespec duration = { .tv_sec = (time_t)(ticks / 1000000000ull), .tv_nsec = (long)(ticks % 1000000000ull) };
+    // Continue sleeping for the remaining time when interrupted by a signal.
+    while (nanosleep(&duration, &duration) != 0 && errno == EINTR) {
+    }
+}
+
+/*
+=============================================================================================================================
+    File I/O
+=============================================================================================================================
+*/
+
+string get_executable_directory(bump_allocator* allocator) {
+    char* path = (char*)bump_allocate(allocator, 1, PATH_MAX);
+    if (path == NULL) {
+        BUG("Failed to allocate memory for executable path.");
+        return (string) {
+            .text = "", .length = 0
+        };
+    }
+
+    ssize_t read_length = readlink("/proc/self/exe", path, PATH_MAX - 1);
+    size_t length = read_length > 0 ? (size_t)read_length : 0;
+    path[length] = '\0';
+    allocator->used_bytes -= (PATH_MAX - length - 1); // Free unused memory from bump allocator.
+
+    // cut the executable name from the path:
+    for (size_t i = length; i > 0; --i) {
+        if (path[i - 1] == '/') {
+            length = i;
+            break;
+        }
+    }
+
+    if (length == 0 || length >= PATH_MAX - 1) {
+        BUG("Failed to get executable path.");
+        return (string) {
+            .text = "", .length = 0
+        };
+    }
+
+    return (string) {
+        .text = path, .length = (uint32_t)length
+    };
+}
+
+static bool file_name_has_extension(const char* file_name, string extension) {
+    size_t file_name_length = strlen(file_name);
+    return file_name_length >= extension.length && memcmp(file_name + file_name_length - extension.length, extension.text, extension.length) == 0;
+}
+
+static bool is_regular_file(const char* path) {
+    struct stat file_info;
+    return stat(path, &file_info) == 0 && S_ISREG(file_info.st_mode);
+}
+
+IMPLEMENT_CAPPED_ARRAY(file_names, string, MAX_FILE_NAMES)
+result find_files_with_extension(string directory, string extension, bump_allocator* allocator, file_names* out_file_names) {
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(out_file_names != NULL, return RESULT_FAILURE, "Output file names cannot be NULL");
+    ASSERT(extension.length > 0, return RESULT_FAILURE, "Extension cannot be empty");
+    memset(out_file_names, 0, sizeof(*out_file_names));
+
+    char search_path[PATH_MAX];
+    snprintf(search_path, PATH_MAX, "%.*s", directory.length, directory.text);
+    DIR* directory_handle = opendir(search_path);
+    if (directory_handle == NULL) {
+        return RESULT_SUCCESS; // No files found is not an error
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(directory_handle)) != NULL) {
+        if (!file_name_has_extension(entry->d_name, extension)) {
+            continue;
+        }
+
+        // Found a file, construct the full path:
+        size_t full_path_length = directory.length + strlen(entry->d_name);
+        char* full_path = (char*)bump_allocate(allocator, 1, full_path_length + 1);
+        if (full_path == NULL) {
+            BUG("Failed to allocate memory for full path.");
+            closedir(directory_handle);
+            return RESULT_FAILURE;
+        }
+
+        snprintf(full_path, full_path_length + 1, "%.*s%s", directory.length, directory.text, entry->d_name);
+        if (!is_regular_file(full_path)) {
+            allocator->used_bytes -= full_path_length + 1;
+            continue;
+        }
+
+        string file_name = {
+            .text = full_path,
+            .length = (uint32_t)full_path_length
+        };
+
+        file_names_append(out_file_names, file_name);
+    }
+
+    closedir(directory_handle);
+    return RESULT_SUCCESS;
+}
+
+result find_first_file_with_extension(string directory, string extension, bump_allocator* allocator, string* out_full_path) {
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(out_full_path != NULL, return RESULT_FAILURE, "Output full path cannot be NULL");
+    ASSERT(extension.length > 0, return RESULT_FAILURE, "Extension cannot be empty");
+
+    file_names found_file_names;
+    if (find_files_with_extension(directory, extension, allocator, &found_file_names) != RESULT_SUCCESS || found_file_names.count == 0) {
+        BUG("Failed to find any files in directory: %.*s", directory.length, directory.text);
+        return RESULT_FAILURE;
+    }
+
+    *out_full_path = found_file_names.elements[0];
+    return RESULT_SUCCESS;
+}
+
+bool file_exists(string path) {
+    return access(path.text, F_OK) == 0;
+}
+
+result read_entire_file(string path, bump_allocator* allocator, string* out_file_contents) {
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(out_file_contents != NULL, return RESULT_FAILURE, "Output file contents cannot be NULL");
+
+    int file_handle = open(path.text, O_RDONLY);
+    if (file_handle < 0) {
+        BUG("Failed to open file for reading: %.*s", path.length, path.text);
+        return RESULT_FAILURE;
+    }
+
+    struct stat file_info;
+    if (fstat(file_handle, &file_info) != 0) {
+        BUG("Failed to get file size for reading: %.*s", path.length, path.text);
+        close(file_handle);
+        return RESULT_FAILURE;
+    }
+
+    if ((uint64_t)file_info.st_size > UINT32_MAX) {
+        BUG("File too large to read into memory: %.*s", path.length, path.text);
+        close(file_handle);
+        return RESULT_FAILURE;
+    }
+
+    size_t file_size = (size_t)file_info.st_size;
+    void* buffer = BUMP_ALLOCATE_TAGGED(allocator, alignof(void*), file_size, "files");
+    if (buffer == NULL) {
+        BUG("Failed to allocate memory for reading file: %.*s", path.length, path.text);
+        close(file_handle);
+        return RESULT_FAILURE;
+    }
+
+    size_t total_read = 0;
+    while (total_read < file_size) {
+        ssize_t bytes_read = read(file_handle, (uint8_t*)buffer + total_read, file_size - total_read);
+        if (bytes_read <= 0) {
+            BUG("Failed to read file: %.*s", path.length, path.text);
+            close(file_handle);
+            return RESULT_FAILURE;
+        }
+        total_read += (size_t)bytes_read;
+    }
+
+    close(file_handle);
+    out_file_contents->text = (const char*)buffer;
+    out_file_contents->length = (uint32_t)file_size;
+    return RESULT_SUCCESS;
+}
+
+result write_entire_file(string path, const void* data, size_t size) {
+    ASSERT(data != NULL, return RESULT_FAILURE, "Data pointer cannot be NULL");
+    ASSERT(size > 0, return RESULT_FAILURE, "Size must be greater than zero");
+
+    int file_handle = open(path.text, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file_handle < 0) {
+        BUG("Failed to open file for writing: %.*s", path.length, path.text);
+        return RESULT_FAILURE;
+    }
+
+    size_t total_written = 0;
+    while (total_written < size) {
+        ssize_t bytes_written = write(file_handle, (const uint8_t*)data + total_written, size - total_written);
+        if (bytes_written <= 0) {
+            BUG("Failed to write file: %.*s", path.length, path.text);
+            close(file_handle);
+            return RESULT_FAILURE;
+        }
+        total_written += (size_t)bytes_written;
+    }
+
+    close(file_handle);
+    return RESULT_SUCCESS;
+}
+
+/*
+=============================================================================================================================
+    Input (headless)
+=============================================================================================================================
+*/
+
+DECLARE_BITSET(key_bitset, 256)
+
+typedef struct input {
+    key_bitset keys_pressed;
+    key_bitset keys_modified_this_frame;
+    int32_t mouse_x;
+    int32_t mouse_y;
+    bool closed_window;
+} input;
+
+input* create_headless_input(bump_allocator* allocator) {
+    ASSERT(allocator != NULL, return NULL, "Allocator cannot be NULL");
+    input* input_state = (input*)bump_allocate(allocator, alignof(input), sizeof(input));
+    ASSERT(input_state != NULL, return NULL, "Failed to allocate headless input");
+    memset(input_state, 0, sizeof(*input_state));
+    return input_state;
+}
+
+void set_headless_key(input* input_state, keyboard_key key, bool is_pressed) {
+    ASSERT(input_state != NULL, return, "Input state cannot be NULL");
+    ASSERT(key >= 0 && key < 256, return, "Key %d out of range", key);
+    key_bitset_assign(&input_state->keys_pressed, key, is_pressed);
+    key_bitset_set(&input_state->keys_modified_this_frame, key);
+}
+
+void begin_headless_input_frame(input* input_state) {
+    ASSERT(input_state != NULL, return, "Input state cannot be NULL");
+    key_bitset_clear_all(&input_state->keys_modified_this_frame);
+}
+
+bool is_key_down(input* input_state, keyboard_key key) {
+    ASSERT(input_state != NULL, return false, "Input state cannot be NULL");
+    ASSERT(key >= 0 && key < 256, return false, "Key %d out of range", key);
+    return key_bitset_test(&input_state->keys_pressed, key) && key_bitset_test(&input_state->keys_modified_this_frame, key);
+}
+
+bool is_key_held_down(input* input_state, keyboard_key key) {
+    ASSERT(input_state != NULL, return false, "Input state cannot be NULL");
+    ASSERT(key >= 0 && key < 256, return false, "Key %d out of range", key);
+    return key_bitset_test(&input_state->keys_pressed, key);
+}
+
+bool is_key_up(input* input_state, keyboard_key key) {
+    ASSERT(input_state != NULL, return false, "Input state cannot be NULL");
+    ASSERT(key >= 0 && key < 256, return false, "Key %d out of range", key);
+    return !key_bitset_test(&input_state->keys_pressed, key) && key_bitset_test(&input_state->keys_modified_this_frame, key);
+}
+
+/*
+=============================================================================================================================
+    Graphics (headless)
+=============================================================================================================================
+*/
+
+typedef struct graphics {
+    vector2int sprite_sheet_size;
+    vector2int virtual_resolution;
+    sprite_instances sprite_instances;
+    color background_color;
+} graphics;
+
+graphics* create_headless_graphics(bump_allocator* allocator, vector2int virtual_resolution, vector2int sprite_sheet_size) {
+    ASSERT(allocator != NULL, return NULL, "Allocator cannot be NULL");
+    ASSERT(virtual_resolution.x > 0 && virtual_resolution.y > 0, return NULL, "Virtual resolution must be positive");
+    ASSERT(sprite_sheet_size.x > 0 && sprite_sheet_size.y > 0, return NULL, "Sprite sheet size must be positive");
+
+    graphics* headless_graphics = (graphics*)bump_allocate(allocator, alignof(graphics), sizeof(graphics));
+    ASSERT(headless_graphics != NULL, return NULL, "Failed to allocate headless graphics");
+    memset(headless_graphics, 0, sizeof(*headless_graphics));
+
+    headless_graphics->sprite_instances.elements = (sprite_instance*)bump_allocate(allocator, alignof(sprite_instance), sizeof(sprite_instance) * MAX_SPRITES);
+    ASSERT(headless_graphics->sprite_instances.elements != NULL, return NULL, "Failed to allocate headless sprite instances");
+    headless_graphics->virtual_resolution = virtual_resolution;
+    headless_graphics->sprite_sheet_size = sprite_sheet_size;
+    return headless_graphics;
+}
+
+void begin_headless_frame(graphics* graphics) {
+    ASSERT(graphics != NULL, return, "Graphics pointer cannot be NULL");
+    graphics->sprite_instances.count = 0;
+}
+
+sprite_instances get_headless_sprite_instances(graphics* graphics) {
+    ASSERT(graphics != NULL, return ((sprite_instances) { 0 }), "Graphics pointer cannot be NULL");
+    return graphics->sprite_instances;
+}
+
+void draw_background_color(graphics* graphics, float r, float g, float b, float a) {
+    ASSERT(graphics != NULL, return, "Graphics pointer cannot be NULL");
+    graphics->background_color = (color){ r, g, b, a };
+}
+
+void draw_sprite(graphics* graphics, vector2 position, vector2 scale, vector2int sample_point, vector2int sample_scale, float rotation) {
+    ASSERT(graphics != NULL, return, "Graphics pointer cannot be NULL");
+    ASSERT(graphics->sprite_instances.elements != NULL, return, "Sprite instances array not initialized");
+    ASSERT(graphics->sprite_instances.count < MAX_SPRITES, return, "Exceeded maximum number of sprites per frame (either increase MAX_SPRITES or draw less sprites per frame)");
+
+    sprite_instance* instance = &graphics->sprite_instances.elements[graphics->sprite_instances.count];
+    ++graphics->sprite_instances.count;
+    write_sprite_instance(instance, graphics->virtual_resolution, graphics->sprite_sheet_size, position, scale, sample_point, sample_scale, rotation);
+}
+
+void draw_projected_sprite(graphics* graphics, const camera_2d* projection_camera, vector2 world_position, vector2 world_scale, vector2int sample_point, vector2int sample_scale, float rotation) {
+    ASSERT(graphics != NULL, return, "Graphics pointer cannot be NULL");
+    ASSERT(projection_camera != NULL, return, "Projection camera pointer cannot be NULL");
+
+    vector2 screen_position;
+    vector2 screen_scale;
+    project_2d_point(*projection_camera, world_position, &screen_position);
+    project_2d_scale(*projection_camera, world_scale, &screen_scale);
+    draw_sprite(graphics, screen_position, screen_scale, sample_point, sample_scale, rotation);
+}
+
+vector2int get_virtual_resolution(graphics* graphics) {
+    ASSERT(graphics != NULL, return ((vector2int) {
+        0, 0
+    }), "Graphics pointer cannot be NULL");
+    return graphics->virtual_resolution;
+}
+
+vector2int get_actual_resolution(graphics* graphics) {
+    // There is no window, so the actual resolution is the virtual resolution.
+    return get_virtual_resolution(graphics);
+}
+
+/*
+=============================================================================================================================
+    Audio (headless)
+=============================================================================================================================
+*/
+
+typedef struct audio {
+    camera_2d listener;
+} audio;
+
+audio* create_headless_audio(bump_allocator* allocator) {
+    ASSERT(allocator != NULL, return NULL, "Allocator cannot be NULL");
+    audio* headless_audio = (audio*)bump_allocate(allocator, alignof(audio), sizeof(audio));
+    ASSERT(headless_audio != NULL, return NULL, "Failed to allocate headless audio");
+    memset(headless_audio, 0, sizeof(*headless_audio));
+    headless_audio->listener.zoom = 1.0f;
+    return headless_audio;
+}
+
+// There is no audio device, so sounds are accepted and silently dropped.
+result play_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration) {
+    ASSERT(audio != NULL, return RESULT_FAILURE, "Audio pointer cannot be NULL");
+    (void)sound_index;
+    (void)flags;
+    (void)fade_in_duration;
+    return RESULT_SUCCESS;
+}
+
+result play_sound_at(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration, vector2 world_position) {
+    (void)world_position;
+    return play_sound(audio, sound_index, flags, fade_in_duration);
+}
+
+void set_audio_listener(audio* audio, camera_2d listener) {
+    ASSERT(audio != NULL, return, "Audio pointer cannot be NULL");
+    audio->listener = listener;
+}
+
+void stop_sound(audio* audio, uint32_t sound_index, stopping_mode mode, float fade_out_duration) {
+    ASSERT(audio != NULL, return, "Audio pointer cannot be NULL");
+    (void)sound_index;
+    (void)mode;
+    (void)fade_out_duration;
+}
+
+/*
+=============================================================================================================================
+    Multi-threading
+=============================================================================================================================
+*/
+
+STATIC_ASSERT((sizeof(mutex) >= sizeof(pthread_mutex_t)), mutex_size_must_fit_pthread_mutex);
+STATIC_ASSERT((alignof(mutex) >= alignof(pthread_mutex_t)), mutex_alignment_must_match_pthread_mutex);
+
+result create_mutex(mutex* m) {
+    ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
+    int error = pthread_mutex_init((pthread_mutex_t*)m->internals, NULL);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to create mutex, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+result lock_mutex(mutex* m) {
+    ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
+    int error = pthread_mutex_lock((pthread_mutex_t*)m->internals);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to lock mutex, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+result unlock_mutex(mutex* m) {
+    ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
+    int error = pthread_mutex_unlock((pthread_mutex_t*)m->internals);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to unlock mutex, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+void destroy_mutex(mutex* m) {
+    ASSERT(m != NULL, return, "Mutex pointer cannot be NULL");
+    int error = pthread_mutex_destroy((pthread_mutex_t*)m->internals);
+    (void)error; // only checked in debug builds
+    DEBUG_ASSERT(error == 0, return, "Failed to destroy mutex");
+}
+
+// The thread structure holds the start routine as well as the handle, because pthreads expects a different signature.
+typedef struct {
+    pthread_t handle;
+    unsigned long (*start_routine)(void*);
+    void* arg;
+} posix_thread;
+
+STATIC_ASSERT((sizeof(thread) >= sizeof(posix_thread)), thread_size_must_fit_posix_thread);
+STATIC_ASSERT((alignof(thread) >= alignof(posix_thread)), thread_alignment_must_match_posix_thread);
+
+static void* posix_thread_start(void* arg) {
+    posix_thread* t = (posix_thread*)arg;
+    return (void*)(uintptr_t)t->start_routine(t->arg);
+}
+
+result create_thread(thread* t, unsigned long(*start_routine)(void*), void* arg) {
+    ASSERT(t != NULL, return RESULT_FAILURE, "Thread pointer cannot be NULL");
+    posix_thread* internals = (posix_thread*)t->internals;
+    internals->start_routine = start_routine;
+    internals->arg = arg;
+    if (pthread_create(&internals->handle, NULL, posix_thread_start, internals) != 0) {
+        BUG("Failed to create thread.");
+        return RESULT_FAILURE;
+    }
+    return RESULT_SUCCESS;
+}
+
+result join_thread(thread* t) {
+    ASSERT(t != NULL, return RESULT_FAILURE, "Thread pointer cannot be NULL");
+    posix_thread* internals = (posix_thread*)t->internals;
+    int error = pthread_join(internals->handle, NULL);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to join thread, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+void destroy_thread(thread* t) {
+    ASSERT(t != NULL, return, "Thread pointer cannot be NULL");
+    // Joined pthreads release their resources automatically.
+    memset(t, 0, sizeof(*t));
+}
+
+STATIC_ASSERT((sizeof(condition_variable) >= sizeof(pthread_cond_t)), condition_variable_size_must_fit_pthread_cond);
+STATIC_ASSERT((alignof(condition_variable) >= alignof(pthread_cond_t)), condition_variable_alignment_must_match_pthread_cond);
+
+result init_condition_variable(condition_variable* cv) {
+    ASSERT(cv != NULL, return RESULT_FAILURE, "Condition variable pointer cannot be NULL");
+    int error = pthread_cond_init((pthread_cond_t*)cv->internals, NULL);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to initialize condition variable, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+void destroy_condition_variable(condition_variable* cv) {
+    ASSERT(cv != NULL, return, "Condition variable pointer cannot be NULL");
+    pthread_cond_destroy((pthread_cond_t*)cv->internals);
+}
+
+result signal_condition_variable(condition_variable* cv) {
+    ASSERT(cv != NULL, return RESULT_FAILURE, "Condition variable pointer cannot be NULL");
+    pthread_cond_signal((pthread_cond_t*)cv->internals);
+    return RESULT_SUCCESS;
+}
+
+result broadcast_condition_variable(condition_variable* cv) {
+    ASSERT(cv != NULL, return RESULT_FAILURE, "Condition variable pointer cannot be NULL");
+    pthread_cond_broadcast((pthread_cond_t*)cv->internals);
+    return RESULT_SUCCESS;
+}
+
+result wait_condition_variable(condition_variable* cv, mutex* m) {
+    ASSERT(cv != NULL, return RESULT_FAILURE, "Condition variable pointer cannot be NULL");
+    ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
+    pthread_cond_wait((pthread_cond_t*)cv->internals, (pthread_mutex_t*)m->internals);
+    return RESULT_SUCCESS;
+}
+
+uint32_t get_processor_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+void yield_thread(void) {
+    sched_yield();
+}
+
+uint64_t get_current_thread_id(void) {
+    return (uint64_t)(uintptr_t)pthread_self();
+}
+
+#if defined(__linux__)
+void wait_on_address(atomic_uint32* address, uint32_t expected) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    // Returns straight away (EAGAIN) if the value has already changed, and on EINTR the caller's loop checks again.
+    syscall(SYS_futex, (uint32_t*)&address->value, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0);
+}
+
+void wake_one_on_address(atomic_uint32* address) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    syscall(SYS_futex, (uint32_t*)&address->value, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void wake_all_on_address(atomic_uint32* address) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    syscall(SYS_futex, (uint32_t*)&address->value, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+#else
+// No public futex on this platform: addresses are hashed to a fixed set of mutex and condition variable pairs instead.
+#define ADDRESS_WAIT_BUCKET_COUNT 64
+
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+} address_wait_buckets[ADDRESS_WAIT_BUCKET_COUNT];
+static pthread_once_t address_wait_buckets_once = PTHREAD_ONCE_INIT;
+
+static void init_address_wait_buckets(void) {
+    for (uint32_t i = 0; i < ADDRESS_WAIT_BUCKET_COUNT; ++i) {
+        pthread_mutex_init(&address_wait_buckets[i].mutex, NULL);
+        pthread_cond_init(&address_wait_buckets[i].condition, NULL);
+    }
+}
+
+static uint32_t address_wait_bucket(atomic_uint32* address) {
+    pthread_once(&address_wait_buckets_once, init_address_wait_buckets);
+    return (uint32_t)(((uintptr_t)address >> 2) % ADDRESS_WAIT_BUCKET_COUNT);
+}
+
+void wait_on_address(atomic_uint32* address, uint32_t expected) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    uint32_t bucket = address_wait_bucket(address);
+    pthread_mutex_lock(&address_wait_buckets[bucket].mutex);
+    if (atomic_load_uint32(address, MEMORY_ORDER_SEQ_CST) == expected) {
+        pthread_cond_wait(&address_wait_buckets[bucket].condition, &address_wait_buckets[bucket].mutex);
+    }
+    pthread_mutex_unlock(&address_wait_buckets[bucket].mutex);
+}
+
+void wake_one_on_address(atomic_uint32* address) {
+    // Other addresses share the bucket, so every waiter is woken to recheck its own value.
+    wake_all_on_address(address);
+}
+
+void wake_all_on_address(atomic_uint32* address) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    uint32_t bucket = address_wait_bucket(address);
+    pthread_mutex_lock(&address_wait_buckets[bucket].mutex);
+    pthread_cond_broadcast(&address_wait_buckets[bucket].condition);
+    pthread_mutex_unlock(&address_wait_buckets[bucket].mutex);
+}
+#endif
+
+STATIC_ASSERT((sizeof(rwlock) >= sizeof(pthread_rwlock_t)), rwlock_size_must_fit_pthread_rwlock);
+STATIC_ASSERT((alignof(rwlock) >= alignof(pthread_rwlock_t)), rwlock_alignment_must_match_pthread_rwlock);
+
+result create_rwlock(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    int error = pthread_rwlock_init((pthread_rwlock_t*)lock->internals, NULL);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to create reader-writer lock, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+result lock_rwlock_shared(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    int error = pthread_rwlock_rdlock((pthread_rwlock_t*)lock->internals);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to lock reader-writer lock for reading, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+result unlock_rwlock_shared(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    int error = pthread_rwlock_unlock((pthread_rwlock_t*)lock->internals);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to unlock reader-writer lock, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+result lock_rwlock_exclusive(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    int error = pthread_rwlock_wrlock((pthread_rwlock_t*)lock->internals);
+    ASSERT(error == 0, return RESULT_FAILURE, "Failed to lock reader-writer lock for writing, error code: %d", error);
+    return RESULT_SUCCESS;
+}
+
+result unlock_rwlock_exclusive(rwlock* lock) {
+    return unlock_rwlock_shared(lock); // pthreads uses the same function for both
+}
+
+void destroy_rwlock(rwlock* lock) {
+    ASSERT(lock != NULL, return, "Reader-writer lock pointer cannot be NULL");
+    int error = pthread_rwlock_destroy((pthread_rwlock_t*)lock->internals);
+    (void)error; // only checked in debug builds
+    DEBUG_ASSERT(error == 0, return, "Failed to destroy reader-writer lock");
+}
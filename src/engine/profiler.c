@@ -0,0 +1,206 @@
+#include "profiler.h"
+
+#ifdef ENABLE_PROFILER
+#include <stdio.h>
+
+STATIC_ASSERT(((PROFILER_EVENTS_PER_THREAD & (PROFILER_EVENTS_PER_THREAD - 1)) == 0), profiler_events_per_thread_must_be_power_of_two);
+
+typedef struct {
+    profile_event events[PROFILER_EVENTS_PER_THREAD];
+    uint64_t events_written; // never wraps, the ring buffer index is events_written % PROFILER_EVENTS_PER_THREAD
+    const char* open_names[PROFILER_MAX_DEPTH];
+    uint64_t open_start_timestamps[PROFILER_MAX_DEPTH];
+    uint32_t depth;
+    const char* thread_name;
+} profiler_thread_buffer;
+
+typedef struct {
+    bump_allocator memory;
+    profiler_thread_buffer* buffer;
+} profiler_thread_slot;
+
+static struct {
+    profiler_thread_slot threads[PROFILER_MAX_THREADS];
+    atomic_uint32 thread_count;
+} profiler;
+
+static THREAD_LOCAL profiler_thread_buffer* thread_buffer = NULL;
+static THREAD_LOCAL bool thread_registration_failed = false;
+
+static profiler_thread_buffer* get_thread_buffer(void) {
+    if (thread_buffer != NULL || thread_registration_failed) {
+        return thread_buffer;
+    }
+
+    // First event on this thread, claim a slot for its ring buffer.
+    thread_registration_failed = true;
+    uint32_t index = atomic_fetch_add_uint32(&profiler.thread_count, 1, MEMORY_ORDER_ACQ_REL);
+    ASSERT(index < PROFILER_MAX_THREADS, return NULL, "Too many threads are using the profiler, increase PROFILER_MAX_THREADS (%d)", PROFILER_MAX_THREADS);
+
+    profiler_thread_slot* slot = &profiler.threads[index];
+    if (create_bump_allocator(&slot->memory, sizeof(profiler_thread_buffer) + 64) != RESULT_SUCCESS) {
+        BUG("Failed to reserve memory for profiler thread buffer.");
+        return NULL;
+    }
+
+    profiler_thread_buffer* buffer = (profiler_thread_buffer*)bump_allocate(&slot->memory, 64, sizeof(profiler_thread_buffer));
+    ASSERT(buffer != NULL, return NULL, "Failed to allocate profiler thread buffer.");
+    memset(buffer, 0, sizeof(profiler_thread_buffer));
+    slot->buffer = buffer;
+
+    thread_registration_failed = false;
+    thread_buffer = buffer;
+    return buffer;
+}
+
+void profile_begin(const char* name) {
+    profiler_thread_buffer* buffer = get_thread_buffer();
+    if (buffer == NULL) {
+        return;
+    }
+
+    // Scopes nested deeper than PROFILER_MAX_DEPTH are still counted (so they end correctly) but not recorded.
+    if (buffer->depth < PROFILER_MAX_DEPTH) {
+        buffer->open_names[buffer->depth] = name;
+        buffer->open_start_timestamps[buffer->depth] = read_timestamp();
+    }
+    ++buffer->depth;
+}
+
+void profile_end(void) {
+    uint64_t end_timestamp = read_timestamp();
+    profiler_thread_buffer* buffer = thread_buffer;
+    if (buffer == NULL) {
+        return;
+    }
+
+    ASSERT(buffer->depth > 0, return, "PROFILE_END without a matching PROFILE_BEGIN.");
+    --buffer->depth;
+    if (buffer->depth >= PROFILER_MAX_DEPTH) {
+        return;
+    }
+
+    profile_event* event = &buffer->events[buffer->events_written & (PROFILER_EVENTS_PER_THREAD - 1)];
+    event->name = buffer->open_names[buffer->depth];
+    event->start_timestamp = buffer->open_start_timestamps[buffer->depth];
+    event->duration_ticks = end_timestamp - event->start_timestamp;
+    ++buffer->events_written;
+}
+
+void set_profiler_thread_name(const char* name) {
+    profiler_thread_buffer* buffer = get_thread_buffer();
+    if (buffer != NULL) {
+        buffer->thread_name = name;
+    }
+}
+
+/*
+=============================================================================================================================
+    Chrome trace-event export
+=============================================================================================================================
+*/
+
+// Upper bound on the JSON text for one event, not counting its name.
+#define PROFILER_JSON_EVENT_BYTES 128
+
+static uint32_t get_thread_count(void) {
+    uint32_t count = atomic_load_uint32(&profiler.thread_count, MEMORY_ORDER_ACQUIRE);
+    return count > PROFILER_MAX_THREADS ? PROFILER_MAX_THREADS : (uint32_t)count;
+}
+
+static uint64_t get_first_event_index(uint64_t events_written) {
+    return events_written > PROFILER_EVENTS_PER_THREAD ? events_written - PROFILER_EVENTS_PER_THREAD : 0;
+}
+
+// Writes the name as a JSON string (escaping quotes and backslashes), returns the number of bytes written.
+static size_t write_json_string(char* out, const char* text) {
+    size_t length = 0;
+    out[length++] = '"';
+    for (const char* c = text != NULL ? text : "unnamed"; *c != '\0'; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out[length++] = '\\';
+        }
+        out[length++] = ((unsigned char)*c < ' ') ? ' ' : *c;
+    }
+    out[length++] = '"';
+    return length;
+}
+
+static size_t json_string_bound(const char* text) {
+    return (text != NULL ? strlen(text) : 7) * 2 + 2;
+}
+
+/*
+The trace is exported while other threads may still be recording. Those threads keep overwriting their oldest events, so the
+exported events of a thread may be a mix of older and newer ones and an event may be torn. The text cannot overflow though: both
+passes use the same snapshot of the event counts, and every event is checked against the room left before it is written.
+Export at shutdown (or while the other threads are idle) for a consistent trace.
+*/
+result export_profiler_trace(string path, bump_allocator* temp_allocator) {
+    ASSERT(temp_allocator != NULL, return RESULT_FAILURE, "Temp allocator cannot be NULL");
+    uint32_t thread_count = get_thread_count();
+
+    // Work out the size of the text up front, and the earliest timestamp (trace timestamps are relative to it).
+    // Each thread's buffer and event count are read once here and reused when writing, so both passes agree on what is exported.
+    profiler_thread_buffer* buffers[PROFILER_MAX_THREADS];
+    uint64_t events_written[PROFILER_MAX_THREADS];
+    size_t capacity = 64;
+    uint64_t earliest_timestamp = UINT64_MAX;
+    for (uint32_t t = 0; t < thread_count; ++t) {
+        profiler_thread_buffer* buffer = profiler.threads[t].buffer;
+        buffers[t] = buffer;
+        events_written[t] = buffer != NULL ? buffer->events_written : 0;
+        if (buffer == NULL) {
+            continue;
+        }
+
+        capacity += PROFILER_JSON_EVENT_BYTES + json_string_bound(buffer->thread_name);
+        for (uint64_t i = get_first_event_index(events_written[t]); i < events_written[t]; ++i) {
+            profile_event* event = &buffer->events[i & (PROFILER_EVENTS_PER_THREAD - 1)];
+            capacity += PROFILER_JSON_EVENT_BYTES + json_string_bound(event->name);
+            if (event->start_timestamp < earliest_timestamp) {
+                earliest_timestamp = event->start_timestamp;
+            }
+        }
+    }
+
+    char* text = (char*)bump_allocate(temp_allocator, 1, capacity);
+    ASSERT(text != NULL, return RESULT_FAILURE, "Failed to allocate %zu bytes for the profiler trace.", capacity);
+
+    size_t length = 0;
+    bool is_first_event = true;
+    length += (size_t)snprintf(text + length, capacity - length, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (uint32_t t = 0; t < thread_count; ++t) {
+        profiler_thread_buffer* buffer = buffers[t];
+        if (buffer == NULL) {
+            continue;
+        }
+
+        if (buffer->thread_name != NULL) {
+            length += (size_t)snprintf(text + length, capacity - length, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":",
+                is_first_event ? "" : ",", t);
+            length += write_json_string(text + length, buffer->thread_name);
+            length += (size_t)snprintf(text + length, capacity - length, "}}");
+            is_first_event = false;
+        }
+
+        for (uint64_t i = get_first_event_index(events_written[t]); i < events_written[t]; ++i) {
+            // A copy, so a thread overwriting the event cannot change its name between measuring and writing it.
+            profile_event event = buffer->events[i & (PROFILER_EVENTS_PER_THREAD - 1)];
+            if (capacity - length < PROFILER_JSON_EVENT_BYTES + json_string_bound(event.name) + sizeof("\n]}\n")) {
+                break;
+            }
+            length += (size_t)snprintf(text + length, capacity - length, "%s\n{\"name\":", is_first_event ? "" : ",");
+            length += write_json_string(text + length, event.name);
+            length += (size_t)snprintf(text + length, capacity - length, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                t, timestamp_to_seconds(event.start_timestamp - earliest_timestamp) * 1e6, timestamp_to_seconds(event.duration_ticks) * 1e6);
+            is_first_event = false;
+        }
+    }
+    length += (size_t)snprintf(text + length, capacity - length, "\n]}\n");
+    DEBUG_ASSERT(length < capacity, return RESULT_FAILURE, "Profiler trace text overflowed its buffer.");
+
+    return write_entire_file(path, text, length);
+}
+
+#endif // ENABLE_PROFILER
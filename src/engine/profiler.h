@@ -0,0 +1,82 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include "engine_config.h"
+#include "platform_layer.h"
+
+/*
+A scoped CPU profiler. Timed scopes are recorded into a ring buffer owned by the thread that recorded them,
+so recording never takes a lock. Older events are overwritten once a thread's ring buffer is full.
+
+    PROFILE_SCOPE("update") {
+        ...
+    }
+
+    PROFILE_BEGIN("draw");
+    ...
+    PROFILE_END();
+
+The recorded events can be exported as Chrome trace-event JSON (open in chrome://tracing or https://ui.perfetto.dev).
+Scope names must be string literals (or otherwise outlive the profiler), only the pointer is stored.
+
+When ENABLE_PROFILER is not defined (see engine_config.h) the macros compile away entirely.
+Note that with hot reloading the game DLL has its own copy of the profiler, so scopes inside the game are not
+exported by the engine. Scopes around the calls into the game are recorded as normal.
+*/
+
+#ifndef PROFILER_EVENTS_PER_THREAD
+#define PROFILER_EVENTS_PER_THREAD 65536 // must be a power of two
+#endif
+
+#ifndef PROFILER_MAX_THREADS
+#define PROFILER_MAX_THREADS 64
+#endif
+
+#ifndef PROFILER_MAX_DEPTH
+#define PROFILER_MAX_DEPTH 64
+#endif
+
+// Times are raw timestamp ticks (see read_timestamp), they are converted when exported.
+typedef struct {
+    const char* name;
+    uint64_t start_timestamp;
+    uint64_t duration_ticks;
+} profile_event;
+
+#ifdef ENABLE_PROFILER
+
+void profile_begin(const char* name);
+void profile_end(void);
+
+// Optional, names the calling thread in exported traces.
+void set_profiler_thread_name(const char* name);
+
+// Writes the recorded events as Chrome trace-event JSON. The temp allocator is used to build the file contents.
+result export_profiler_trace(string path, bump_allocator* temp_allocator);
+
+#define PROFILE_BEGIN(name) profile_begin(name)
+#define PROFILE_END() profile_end()
+
+// Times the statement or block that follows. Do not leave the block with return, break or goto (the scope would not end).
+#define PROFILE_SCOPE(name) PROFILE_SCOPE_IMPL(name, __LINE__)
+#define PROFILE_SCOPE_IMPL(name, line) PROFILE_SCOPE_LOOP(name, CONCATENATE(profile_scope_, line))
+#define PROFILE_SCOPE_LOOP(name, once) for (int once = (profile_begin(name), 0); !once; once = (profile_end(), 1))
+
+#else
+
+#define PROFILE_BEGIN(name) ((void)0)
+#define PROFILE_END() ((void)0)
+#define PROFILE_SCOPE(name)
+
+static inline void set_profiler_thread_name(const char* name) {
+    (void)name;
+}
+
+static inline result export_profiler_trace(string path, bump_allocator* temp_allocator) {
+    (void)path;
+    (void)temp_allocator;
+    return RESULT_SUCCESS;
+}
+
+#endif // ENABLE_PROFILER
+
+#endif // PROFILER_H
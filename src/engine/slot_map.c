@@ -0,0 +1,80 @@
+#include "slot_map.h"
+#include "dynamic_array.h"
+
+result reserve_slot_map(slot_map_lookup* lookup, void** elements, uint32_t count, bump_allocator* allocator, size_t element_size, size_t alignment, uint32_t capacity) {
+    ASSERT(lookup != NULL && elements != NULL, return RESULT_FAILURE, "Slot map cannot be NULL");
+    if (lookup->slots == NULL) {
+        lookup->free_slot = SLOT_MAP_MAX_SLOTS;
+    }
+
+    // The elements and their handles grow the same way, but may not end up with the same capacity (see grow_dynamic_array).
+    uint32_t element_capacity = lookup->capacity;
+    uint32_t handle_capacity = lookup->capacity;
+    void* handles = lookup->handles;
+    if (grow_dynamic_array(elements, count, &element_capacity, allocator, element_size, alignment, capacity) != RESULT_SUCCESS
+        || grow_dynamic_array(&handles, count, &handle_capacity, allocator, sizeof(slot_handle), alignof(slot_handle), element_capacity) != RESULT_SUCCESS) {
+        return RESULT_FAILURE;
+    }
+    lookup->handles = (slot_handle*)handles;
+    lookup->capacity = element_capacity < handle_capacity ? element_capacity : handle_capacity;
+    return RESULT_SUCCESS;
+}
+
+slot_handle add_slot_map_handle(slot_map_lookup* lookup, bump_allocator* allocator, uint32_t dense_index) {
+    ASSERT(lookup != NULL, return SLOT_HANDLE_NONE, "Slot map cannot be NULL");
+    DEBUG_ASSERT(dense_index < lookup->capacity, return SLOT_HANDLE_NONE, "Slot map has no room for element %u", dense_index);
+
+    uint32_t slot = lookup->free_slot;
+    if (slot != SLOT_MAP_MAX_SLOTS) {
+        lookup->free_slot = lookup->slots[slot].index;
+    }
+    else {
+        ASSERT(lookup->slot_count < SLOT_MAP_MAX_SLOTS, return SLOT_HANDLE_NONE, "Slot map cannot have more than %u slots", SLOT_MAP_MAX_SLOTS);
+        void* slots = lookup->slots;
+        if (grow_dynamic_array(&slots, lookup->slot_count, &lookup->slot_capacity, allocator, sizeof(slot_map_slot), alignof(slot_map_slot), lookup->slot_count + 1) != RESULT_SUCCESS) {
+            BUG("Slot map failed to grow to %u slots", lookup->slot_count + 1);
+            return SLOT_HANDLE_NONE;
+        }
+        lookup->slots = (slot_map_slot*)slots;
+        slot = lookup->slot_count++;
+        lookup->slots[slot].generation = 1;
+    }
+
+    lookup->slots[slot].index = dense_index;
+    slot_handle handle = (lookup->slots[slot].generation << SLOT_MAP_INDEX_BITS) | slot;
+    lookup->handles[dense_index] = handle;
+    return handle;
+}
+
+static void free_slot_map_slot(slot_map_lookup* lookup, uint32_t slot) {
+    slot_map_slot* freed = &lookup->slots[slot];
+    if (freed->generation == SLOT_MAP_MAX_GENERATION) {
+        // Reusing the slot would make its generation wrap around and old handles valid again, so it is retired instead:
+        // it stays off the free list, and generation 0 is one no handle can match (find_slot_map_index rejects it).
+        freed->generation = 0;
+        return;
+    }
+    ++freed->generation;
+    freed->index = lookup->free_slot;
+    lookup->free_slot = slot;
+}
+
+void remove_slot_map_handle(slot_map_lookup* lookup, uint32_t dense_index, uint32_t count) {
+    ASSERT(lookup != NULL, return, "Slot map cannot be NULL");
+    ASSERT(dense_index < count, return, "Index out of bounds: %u. Count = %u", dense_index, count);
+    free_slot_map_slot(lookup, lookup->handles[dense_index] & (SLOT_MAP_MAX_SLOTS - 1));
+
+    uint32_t last = count - 1;
+    if (dense_index != last) {
+        slot_handle moved = lookup->handles[last];
+        lookup->handles[dense_index] = moved;
+        lookup->slots[moved & (SLOT_MAP_MAX_SLOTS - 1)].index = dense_index;
+    }
+}
+
+void clear_slot_map_handles(slot_map_lookup* lookup, uint32_t count) {
+    ASSERT(lookup != NULL, return, "Slot map cannot be NULL");
+    for (uint32_t i = 0; i < count; ++i) {
+        free_slot_map_slot(lookup, lookup->handles[i] & (SLOT_MAP_MAX_SLOTS - 1));
+    }
+}
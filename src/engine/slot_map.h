@@ -0,0 +1,149 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+#include "platform_layer.h"
+
+/*
+A slot map keeps elements packed in a dense array (iterate elements[0..count) like an array, or split it with PARALLEL_FOR_EACH)
+and hands out a slot_handle for each one that stays valid until that element is removed, however the array is shuffled in between.
+Insert, remove and lookup by handle are O(1): a handle names a slot, and the slot holds the element's current index in the dense array.
+Removing an element moves the last element into its place and updates that element's slot.
+
+A handle also holds the generation of its slot, which is bumped every time the slot is freed, so a handle to a removed element
+(a stale handle) finds nothing rather than whatever was put in the slot afterwards. A slot whose generation runs out is retired
+instead of reused. No handle is valid with generation 0, so SLOT_HANDLE_NONE (or any zeroed handle) means "no element".
+
+The arrays grow like a dynamic array (see dynamic_array.h), so a map in perm survives hot reloads and perm snapshots, and handles are
+plain integers that can be stored anywhere.
+
+usage:
+    DECLARE_SLOT_MAP(asteroids, asteroid)
+    IMPLEMENT_SLOT_MAP(asteroids, asteroid)
+
+    slot_handle target = asteroids_insert(&state->asteroids, perm, new_asteroid);
+    ...
+    asteroid* ast = asteroids_get(&state->asteroids, target); // NULL once the asteroid has been removed
+*/
+
+typedef uint32_t slot_handle;
+
+#define SLOT_HANDLE_NONE 0u
+
+// The low bits of a handle are the slot, the high bits its generation (never 0, so no valid handle is SLOT_HANDLE_NONE).
+#ifndef SLOT_MAP_INDEX_BITS
+#define SLOT_MAP_INDEX_BITS 22
+#endif
+#define SLOT_MAP_MAX_SLOTS (1u << SLOT_MAP_INDEX_BITS)
+#define SLOT_MAP_MAX_GENERATION ((1u << (32 - SLOT_MAP_INDEX_BITS)) - 1)
+
+typedef struct {
+    uint32_t generation; // 0 once the slot is retired
+    uint32_t index; // where the element is in the dense array, or the next free slot when the slot is free
+} slot_map_slot;
+
+// The part of a slot map that does not depend on the element type, shared by every slot map.
+typedef struct {
+    slot_handle* handles; // handles[i] is the handle of elements[i]
+    slot_map_slot* slots;
+    uint32_t capacity; // of the elements and handles
+    uint32_t slot_count;
+    uint32_t slot_capacity;
+    uint32_t free_slot; // first slot of the free list, or SLOT_MAP_MAX_SLOTS when there are none
+} slot_map_lookup;
+
+// Makes room for capacity elements (the map's elements array is grown with the handles).
+result reserve_slot_map(slot_map_lookup* lookup, void** elements, uint32_t count, bump_allocator* allocator, size_t element_size, size_t alignment, uint32_t capacity);
+
+// Gives the element at dense_index a slot, and returns its handle (SLOT_HANDLE_NONE if there are no slots left).
+slot_handle add_slot_map_handle(slot_map_lookup* lookup, bump_allocator* allocator, uint32_t dense_index);
+
+// Frees the slot of the element at dense_index and moves the last handle into its place. The caller moves the element.
+void remove_slot_map_handle(slot_map_lookup* lookup, uint32_t dense_index, uint32_t count);
+
+// Frees the slots of all count elements.
+void clear_slot_map_handles(slot_map_lookup* lookup, uint32_t count);
+
+static inline bool find_slot_map_index(const slot_map_lookup* lookup, slot_handle handle, uint32_t* out_index) {
+    uint32_t slot = handle & (SLOT_MAP_MAX_SLOTS - 1);
+    uint32_t generation = handle >> SLOT_MAP_INDEX_BITS;
+    if (generation == 0 || slot >= lookup->slot_count || lookup->slots[slot].generation != generation) {
+        return false;
+    }
+    *out_index = lookup->slots[slot].index;
+    return true;
+}
+
+#define DECLARE_SLOT_MAP(name, element_type) \
+    typedef struct { \
+        element_type* elements; \
+        uint32_t count; \
+        slot_map_lookup lookup; \
+    } name; \
+    result name##_reserve(name* map, bump_allocator* allocator, uint32_t capacity); \
+    slot_handle name##_insert(name* map, bump_allocator* allocator, element_type element); \
+    bool name##_remove(name* map, slot_handle handle); \
+    result name##_remove_at(name* map, uint32_t index); \
+    static inline element_type* name##_get(name* map, slot_handle handle) { \
+        ASSERT(map != NULL, return NULL, "Slot map " #name " cannot be NULL"); \
+        uint32_t index = 0; \
+        return find_slot_map_index(&map->lookup, handle, &index) ? &map->elements[index] : NULL; \
+    } \
+    static inline bool name##_contains(name* map, slot_handle handle) { \
+        return name##_get(map, handle) != NULL; \
+    } \
+    static inline slot_handle name##_handle_at(name* map, uint32_t index) { \
+        ASSERT(map != NULL, return SLOT_HANDLE_NONE, "Slot map " #name " cannot be NULL"); \
+        ASSERT(index < map->count, return SLOT_HANDLE_NONE, "Index out of bounds: %u. Count = %u", index, map->count); \
+        return map->lookup.handles[index]; \
+    } \
+    static inline void name##_clear(name* map) { \
+        ASSERT(map != NULL, return, "Slot map " #name " cannot be NULL"); \
+        clear_slot_map_handles(&map->lookup, map->count); \
+        map->count = 0; \
+    }
+
+#define IMPLEMENT_SLOT_MAP(name, element_type) \
+    result name##_reserve(name* map, bump_allocator* allocator, uint32_t capacity) { \
+        ASSERT(map != NULL, return RESULT_FAILURE, "Slot map " #name " cannot be NULL"); \
+        if (capacity <= map->lookup.capacity) { \
+            return RESULT_SUCCESS; \
+        } \
+        void* elements = map->elements; \
+        if (reserve_slot_map(&map->lookup, &elements, map->count, allocator, sizeof(element_type), alignof(element_type), capacity) != RESULT_SUCCESS) { \
+            BUG("Slot map " #name " failed to grow to %u elements", capacity); \
+            return RESULT_FAILURE; \
+        } \
+        map->elements = (element_type*)elements; \
+        return RESULT_SUCCESS; \
+    } \
+    slot_handle name##_insert(name* map, bump_allocator* allocator, element_type element) { \
+        ASSERT(map != NULL, return SLOT_HANDLE_NONE, "Slot map " #name " cannot be NULL"); \
+        if (map->count == map->lookup.capacity && name##_reserve(map, allocator, map->count + 1) != RESULT_SUCCESS) { \
+            return SLOT_HANDLE_NONE; \
+        } \
+        slot_handle handle = add_slot_map_handle(&map->lookup, allocator, map->count); \
+        if (handle == SLOT_HANDLE_NONE) { \
+            return SLOT_HANDLE_NONE; \
+        } \
+        memcpy(&map->elements[map->count++], &element, sizeof(element_type)); \
+        return handle; \
+    } \
+    result name##_remove_at(name* map, uint32_t index) { \
+        ASSERT(map != NULL, return RESULT_FAILURE, "Slot map " #name " cannot be NULL"); \
+        ASSERT(index < map->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, map->count); \
+        remove_slot_map_handle(&map->lookup, index, map->count); \
+        if (index != map->count - 1) { \
+            memcpy(&map->elements[index], &map->elements[map->count - 1], sizeof(element_type)); \
+        } \
+        --map->count; \
+        return RESULT_SUCCESS; \
+    } \
+    bool name##_remove(name* map, slot_handle handle) { \
+        ASSERT(map != NULL, return false, "Slot map " #name " cannot be NULL"); \
+        uint32_t index = 0; \
+        if (!find_slot_map_index(&map->lookup, handle, &index)) { \
+            return false; \
+        } \
+        return name##_remove_at(map, index) == RESULT_SUCCESS; \
+    }
+
+#endif // SLOT_MAP_H
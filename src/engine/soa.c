@@ -0,0 +1,29 @@
+#include "soa.h"
+
+uint32_t get_soa_capacity(uint32_t capacity, uint32_t min_capacity) {
+    uint64_t new_capacity = (uint64_t)capacity * 2;
+    if (new_capacity < SOA_MIN_CAPACITY) {
+        new_capacity = SOA_MIN_CAPACITY;
+    }
+    if (new_capacity < min_capacity) {
+        new_capacity = min_capacity;
+    }
+    new_capacity = (new_capacity + SOA_CAPACITY_GRANULARITY - 1) / SOA_CAPACITY_GRANULARITY * SOA_CAPACITY_GRANULARITY;
+    if (new_capacity > UINT32_MAX / SOA_CAPACITY_GRANULARITY * SOA_CAPACITY_GRANULARITY) {
+        new_capacity = UINT32_MAX / SOA_CAPACITY_GRANULARITY * SOA_CAPACITY_GRANULARITY;
+    }
+    return (uint32_t)new_capacity;
+}
+
+void* grow_soa_column(const void* column, uint32_t count, uint32_t capacity, bump_allocator* allocator, size_t element_size) {
+    ASSERT(count <= capacity, return NULL, "Struct of arrays column cannot hold %u rows in %u", count, capacity);
+    uint8_t* grown = (uint8_t*)BUMP_ALLOCATE_TAGGED(allocator, SOA_COLUMN_ALIGNMENT, (size_t)capacity * element_size, "soa");
+    if (grown == NULL) {
+        return NULL;
+    }
+    if (count > 0) {
+        memcpy(grown, column, (size_t)count * element_size);
+    }
+    memset(grown + (size_t)count * element_size, 0, (size_t)(capacity - count) * element_size);
+    return grown;
+}
@@ -0,0 +1,134 @@
+#ifndef SOA_H
+#define SOA_H
+#include "platform_layer.h"
+
+/*
+A struct-of-arrays container: instead of an array of structs, every field is an array (a column) of its own, so a loop that only
+reads positions and velocities only loads positions and velocities, and a column of floats can be processed SIMD-width at a time.
+
+The columns are given as (type, field) pairs, and the macros generate the container with one column per field, plus a name##_element
+struct with the same fields for adding and reading whole rows. Every column is aligned to SOA_COLUMN_ALIGNMENT, and the capacity is
+a multiple of SOA_CAPACITY_GRANULARITY, so a SIMD loop can run over whole registers up to the capacity. Rows past count are always
+zero: the padding is zeroed when a column is allocated, and rows are zeroed again when they are removed or cleared. Rows are removed
+by moving the last row into their place, in every column.
+
+The columns grow like a dynamic array (see dynamic_array.h). Rows stay in lockstep with any other container that is removed from the
+same way (a slot map, or a dynamic array with remove_swap), so the hot fields of an entity can be split out of its other data.
+
+usage:
+    DECLARE_SOA(particles, (vector2, position), (vector2, velocity), (float, lifetime))
+    IMPLEMENT_SOA(particles, (vector2, position), (vector2, velocity), (float, lifetime))
+
+    particles_append(&state->particles, perm, (particles_element){ .position = position, .lifetime = 1.0f });
+    for (uint32_t i = 0; i < state->particles.count; ++i) {
+        state->particles.position[i] = vector2_add(state->particles.position[i], vector2_scale(state->particles.velocity[i], delta_time));
+    }
+*/
+
+#define SOA_COLUMN_ALIGNMENT 64
+#define SOA_CAPACITY_GRANULARITY 16
+#define SOA_MIN_CAPACITY 16
+
+// The capacity to grow to, to hold at least min_capacity rows.
+uint32_t get_soa_capacity(uint32_t capacity, uint32_t min_capacity);
+
+// Allocates a column with room for capacity rows, copies the first count rows of column into it, and zeroes the rest.
+void* grow_soa_column(const void* column, uint32_t count, uint32_t capacity, bump_allocator* allocator, size_t element_size);
+
+// The actions passed to MAP for each (type, field) pair.
+#define SOA_ELEMENT_FIELD(column) SOA_ELEMENT_FIELD_ column
+#define SOA_ELEMENT_FIELD_(type, field) type field;
+#define SOA_COLUMN(column) SOA_COLUMN_ column
+#define SOA_COLUMN_(type, field) type* field;
+#define SOA_GROW_COLUMN(column) SOA_GROW_COLUMN_ column
+#define SOA_GROW_COLUMN_(type, field) \
+    { \
+        type* grown = (type*)grow_soa_column(soa->field, soa->count, capacity, allocator, sizeof(type)); \
+        if (grown == NULL) { \
+            return RESULT_FAILURE; \
+        } \
+        soa->field = grown; \
+    }
+#define SOA_SET_ROW(column) SOA_SET_ROW_ column
+#define SOA_SET_ROW_(type, field) soa->field[index] = element.field;
+#define SOA_GET_ROW(column) SOA_GET_ROW_ column
+#define SOA_GET_ROW_(type, field) element.field = soa->field[index];
+#define SOA_MOVE_ROW(column) SOA_MOVE_ROW_ column
+#define SOA_MOVE_ROW_(type, field) soa->field[index] = soa->field[last];
+#define SOA_ZERO_ROW(column) SOA_ZERO_ROW_ column
+#define SOA_ZERO_ROW_(type, field) memset(&soa->field[last], 0, sizeof(type));
+#define SOA_ZERO_ROWS(column) SOA_ZERO_ROWS_ column
+#define SOA_ZERO_ROWS_(type, field) memset(soa->field, 0, (size_t)soa->count * sizeof(type));
+
+#define DECLARE_SOA(name, ...) \
+    typedef struct { \
+        MAP(SOA_ELEMENT_FIELD, __VA_ARGS__) \
+    } name##_element; \
+    typedef struct { \
+        MAP(SOA_COLUMN, __VA_ARGS__) \
+        uint32_t count; \
+        uint32_t capacity; \
+    } name; \
+    result name##_reserve(name* soa, bump_allocator* allocator, uint32_t capacity); \
+    result name##_append(name* soa, bump_allocator* allocator, name##_element element); \
+    result name##_remove_swap(name* soa, uint32_t index); \
+    result name##_get(name* soa, uint32_t index, name##_element* out_element); \
+    result name##_set(name* soa, uint32_t index, name##_element element); \
+    static inline void name##_clear(name* soa) { \
+        ASSERT(soa != NULL, return, "Struct of arrays " #name " cannot be NULL"); \
+        if (soa->count > 0) { \
+            MAP(SOA_ZERO_ROWS, __VA_ARGS__) \
+        } \
+        soa->count = 0; \
+    }
+
+#define IMPLEMENT_SOA(name, ...) \
+    /* Every column is grown before the capacity is updated, so a failure part way leaves the old capacity correct. */ \
+    result name##_reserve(name* soa, bump_allocator* allocator, uint32_t min_capacity) { \
+        ASSERT(soa != NULL, return RESULT_FAILURE, "Struct of arrays " #name " cannot be NULL"); \
+        ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL"); \
+        if (min_capacity <= soa->capacity) { \
+            return RESULT_SUCCESS; \
+        } \
+        uint32_t capacity = get_soa_capacity(soa->capacity, min_capacity); \
+        MAP(SOA_GROW_COLUMN, __VA_ARGS__) \
+        soa->capacity = capacity; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_append(name* soa, bump_allocator* allocator, name##_element element) { \
+        ASSERT(soa != NULL, return RESULT_FAILURE, "Struct of arrays " #name " cannot be NULL"); \
+        if (soa->count == soa->capacity && name##_reserve(soa, allocator, soa->count + 1) != RESULT_SUCCESS) { \
+            BUG("Struct of arrays " #name " failed to grow past %u rows", soa->count); \
+            return RESULT_FAILURE; \
+        } \
+        uint32_t index = soa->count++; \
+        MAP(SOA_SET_ROW, __VA_ARGS__) \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_remove_swap(name* soa, uint32_t index) { \
+        ASSERT(soa != NULL, return RESULT_FAILURE, "Struct of arrays " #name " cannot be NULL"); \
+        ASSERT(index < soa->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, soa->count); \
+        uint32_t last = --soa->count; \
+        if (index != last) { \
+            MAP(SOA_MOVE_ROW, __VA_ARGS__) \
+        } \
+        MAP(SOA_ZERO_ROW, __VA_ARGS__) \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_get(name* soa, uint32_t index, name##_element* out_element) { \
+        ASSERT(soa != NULL, return RESULT_FAILURE, "Struct of arrays " #name " cannot be NULL"); \
+        ASSERT(out_element != NULL, return RESULT_FAILURE, "Output element pointer cannot be NULL"); \
+        ASSERT(index < soa->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, soa->count); \
+        name##_element element; \
+        MAP(SOA_GET_ROW, __VA_ARGS__) \
+        *out_element = element; \
+        return RESULT_SUCCESS; \
+    } \
+    result name##_set(name* soa, uint32_t index, name##_element element) { \
+        ASSERT(soa != NULL, return RESULT_FAILURE, "Struct of arrays " #name " cannot be NULL"); \
+        ASSERT(index < soa->count, return RESULT_FAILURE, "Index out of bounds: %u. Count = %u", index, soa->count); \
+        MAP(SOA_SET_ROW, __VA_ARGS__) \
+        return RESULT_SUCCESS; \
+    }
+
+#endif // SOA_H
@@ -0,0 +1,35 @@
+#ifndef SPRITE_INSTANCES_H
+#define SPRITE_INSTANCES_H
+
+/*
+The per-sprite instance data that is uploaded to the GPU (one instance per draw_sprite call).
+This is shared between the platform layers so that every platform generates exactly the same instance data,
+even the headless platform layer that has no GPU at all (which is used to benchmark instance generation).
+The memory layout must match the instance input layout of the vertex shader.
+*/
+
+#include "geometry.h"
+
+typedef struct {
+    vector2 position;
+    vector2 texcoord;
+    vector2 src_scale;
+    vector2 dst_scale;
+    float rotation;
+} sprite_instance;
+
+typedef struct {
+    sprite_instance* elements;
+    size_t count;
+} sprite_instances;
+
+// Converts a sprite from virtual resolution pixels / sprite sheet pixels into normalized device / texture coordinates.
+static inline void write_sprite_instance(sprite_instance* instance, vector2int virtual_resolution, vector2int sprite_sheet_size, vector2 position, vector2 scale, vector2int sample_point, vector2int sample_scale, float rotation) {
+    instance->position = (vector2){ (position.x / (float)virtual_resolution.x) * 2.0f - 1.0f,  1.0f - (position.y / (float)virtual_resolution.y) * 2.0f };
+    instance->dst_scale = (vector2){ (scale.x / (float)virtual_resolution.x), (scale.y / (float)virtual_resolution.y) };
+    instance->src_scale = (vector2){ (float)sample_scale.x / (float)sprite_sheet_size.x, (float)sample_scale.y / (float)sprite_sheet_size.y };
+    instance->texcoord = (vector2){ (float)sample_point.x / (float)sprite_sheet_size.x, (float)sample_point.y / (float)sprite_sheet_size.y };
+    instance->rotation = rotation;
+}
+
+#endif // SPRITE_INSTANCES_H
@@ -0,0 +1,362 @@
+#include "tlsf_allocator.h"
+#include <stddef.h>
+
+#define TLSF_BLOCK_FREE ((size_t)1)
+#define TLSF_BLOCK_HEADER_SIZE offsetof(tlsf_block, next_free)
+#define TLSF_MIN_BLOCK_SIZE (sizeof(tlsf_block) - TLSF_BLOCK_HEADER_SIZE)
+#define TLSF_MAX_BLOCK_SIZE (((size_t)1 << TLSF_FIRST_LEVEL_MAX) - TLSF_ALIGNMENT)
+
+STATIC_ASSERT(TLSF_BLOCK_HEADER_SIZE % TLSF_ALIGNMENT == 0, tlsf_header_keeps_alignment)
+STATIC_ASSERT(TLSF_MIN_BLOCK_SIZE % TLSF_ALIGNMENT == 0, tlsf_min_block_keeps_alignment)
+
+/*
+=====
+    Blocks
+=====
+*/
+
+static inline size_t block_size(const tlsf_block* block) {
+    return block->size & ~TLSF_BLOCK_FREE;
+}
+
+static inline bool is_block_free(const tlsf_block* block) {
+    return (block->size & TLSF_BLOCK_FREE) != 0;
+}
+
+static inline uint8_t* block_payload(const tlsf_block* block) {
+    return (uint8_t*)block + TLSF_BLOCK_HEADER_SIZE;
+}
+
+static inline tlsf_block* block_from_payload(const void* payload) {
+    return (tlsf_block*)((uint8_t*)payload - TLSF_BLOCK_HEADER_SIZE);
+}
+
+static inline tlsf_block* next_physical_block(const tlsf_block* block) {
+    return (tlsf_block*)(block_payload(block) + block_size(block));
+}
+
+static inline size_t align_size(size_t bytes) {
+    bytes = (bytes + (TLSF_ALIGNMENT - 1)) & ~(size_t)(TLSF_ALIGNMENT - 1);
+    return bytes < TLSF_MIN_BLOCK_SIZE ? TLSF_MIN_BLOCK_SIZE : bytes;
+}
+
+/*
+=====
+    Size classes
+=====
+*/
+
+static void map_size(size_t size, uint32_t* out_first_level, uint32_t* out_second_level) {
+    if (size < TLSF_SMALL_BLOCK_SIZE) {
+        *out_first_level = 0;
+        *out_second_level = (uint32_t)(size / (TLSF_SMALL_BLOCK_SIZE / TLSF_SECOND_LEVEL_COUNT));
+        return;
+    }
+
+    uint32_t highest_bit = highest_set_bit(size);
+    *out_first_level = highest_bit - (TLSF_FIRST_LEVEL_SHIFT - 1);
+    *out_second_level = (uint32_t)(size >> (highest_bit - TLSF_SECOND_LEVEL_LOG2)) ^ TLSF_SECOND_LEVEL_COUNT;
+}
+
+// Rounds the size up to the next size class first, so that every block in the list it maps to is big enough.
+static void map_size_for_search(size_t size, uint32_t* out_first_level, uint32_t* out_second_level) {
+    if (size >= TLSF_SMALL_BLOCK_SIZE) {
+        size += ((size_t)1 << (highest_set_bit(size) - TLSF_SECOND_LEVEL_LOG2)) - 1;
+    }
+    map_size(size, out_first_level, out_second_level);
+}
+
+static void insert_free_block(tlsf_allocator* tlsf, tlsf_block* block) {
+    uint32_t first_level, second_level;
+    map_size(block_size(block), &first_level, &second_level);
+
+    tlsf_block* head = tlsf->free_lists[first_level][second_level];
+    block->size |= TLSF_BLOCK_FREE;
+    block->next_free = head;
+    block->previous_free = NULL;
+    if (head != NULL) {
+        head->previous_free = block;
+    }
+    tlsf->free_lists[first_level][second_level] = block;
+    tlsf->first_level_bitmap |= 1u << first_level;
+    tlsf->second_level_bitmaps[first_level] |= 1u << second_level;
+}
+
+static void remove_free_block(tlsf_allocator* tlsf, tlsf_block* block) {
+    uint32_t first_level, second_level;
+    map_size(block_size(block), &first_level, &second_level);
+
+    if (block->previous_free != NULL) {
+        block->previous_free->next_free = block->next_free;
+    }
+    else {
+        tlsf->free_lists[first_level][second_level] = block->next_free;
+        if (block->next_free == NULL) {
+            tlsf->second_level_bitmaps[first_level] &= ~(1u << second_level);
+            if (tlsf->second_level_bitmaps[first_level] == 0) {
+                tlsf->first_level_bitmap &= ~(1u << first_level);
+            }
+        }
+    }
+    if (block->next_free != NULL) {
+        block->next_free->previous_free = block->previous_free;
+    }
+    block->size &= ~TLSF_BLOCK_FREE;
+}
+
+// Finds (and removes) a free block of at least size bytes, or returns NULL.
+static tlsf_block* take_free_block(tlsf_allocator* tlsf, size_t size) {
+    if (size > TLSF_MAX_BLOCK_SIZE) {
+        return NULL;
+    }
+
+    uint32_t first_level, second_level;
+    map_size_for_search(size, &first_level, &second_level);
+    if (first_level >= TLSF_FIRST_LEVEL_COUNT) {
+        return NULL;
+    }
+
+    // A big enough list in the same power of two, or else the smallest list in a larger one.
+    uint32_t second_level_map = tlsf->second_level_bitmaps[first_level] & (~0u << second_level);
+    if (second_level_map == 0) {
+        uint32_t first_level_map = first_level + 1 < 32 ? tlsf->first_level_bitmap & (~0u << (first_level + 1)) : 0;
+        if (first_level_map == 0) {
+            return NULL;
+        }
+        first_level = lowest_set_bit(first_level_map);
+        second_level_map = tlsf->second_level_bitmaps[first_level];
+    }
+    second_level = lowest_set_bit(second_level_map);
+
+    tlsf_block* block = tlsf->free_lists[first_level][second_level];
+    DEBUG_ASSERT(block != NULL && block_size(block) >= size, return NULL, "TLSF bitmaps do not match the free lists");
+    remove_free_block(tlsf, block);
+    return block;
+}
+
+// Merges a free block with the free blocks around it, and puts the result in the free lists.
+static void release_block(tlsf_allocator* tlsf, tlsf_block* block) {
+    tlsf_block* previous = block->previous_physical;
+    if (previous != NULL && is_block_free(previous)) {
+        remove_free_block(tlsf, previous);
+        previous->size += TLSF_BLOCK_HEADER_SIZE + block_size(block);
+        block = previous;
+        next_physical_block(block)->previous_physical = block;
+    }
+
+    tlsf_block* next = next_physical_block(block);
+    if (is_block_free(next)) {
+        remove_free_block(tlsf, next);
+        block->size += TLSF_BLOCK_HEADER_SIZE + block_size(next);
+        next_physical_block(block)->previous_physical = block;
+    }
+
+    insert_free_block(tlsf, block);
+}
+
+// Cuts the end off a block (that is not in the free lists) so it is size bytes, if the rest is big enough to be a block.
+static void trim_block(tlsf_allocator* tlsf, tlsf_block* block, size_t size) {
+    size_t current_size = block_size(block);
+    if (current_size < size + TLSF_BLOCK_HEADER_SIZE + TLSF_MIN_BLOCK_SIZE) {
+        return;
+    }
+
+    tlsf_block* remainder = (tlsf_block*)(block_payload(block) + size);
+    remainder->size = current_size - size - TLSF_BLOCK_HEADER_SIZE;
+    remainder->previous_physical = block;
+    block->size = size | (block->size & TLSF_BLOCK_FREE);
+    next_physical_block(remainder)->previous_physical = remainder;
+    release_block(tlsf, remainder);
+}
+
+/*
+=====
+    Allocator
+=====
+*/
+
+result create_tlsf_allocator(tlsf_allocator* tlsf, bump_allocator* allocator, size_t capacity) {
+    ASSERT(tlsf != NULL, return RESULT_FAILURE, "TLSF allocator cannot be NULL");
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Bump allocator cannot be NULL");
+    capacity &= ~(size_t)(TLSF_ALIGNMENT - 1);
+    ASSERT(capacity >= 2 * TLSF_BLOCK_HEADER_SIZE + TLSF_MIN_BLOCK_SIZE, return RESULT_FAILURE, "TLSF capacity %zu is too small", capacity);
+    ASSERT(capacity - 2 * TLSF_BLOCK_HEADER_SIZE <= TLSF_MAX_BLOCK_SIZE, return RESULT_FAILURE,
+        "TLSF capacity %zu is larger than the largest block (%zu)", capacity, (size_t)TLSF_MAX_BLOCK_SIZE);
+    memset(tlsf, 0, sizeof(tlsf_allocator));
+
+    tlsf->memory = (uint8_t*)BUMP_ALLOCATE_TAGGED(allocator, TLSF_ALIGNMENT, capacity, "tlsf_allocator");
+    ASSERT(tlsf->memory != NULL, return RESULT_FAILURE, "Failed to allocate %zu bytes for TLSF allocator", capacity);
+    tlsf->capacity = capacity;
+    reset_tlsf_allocator(tlsf);
+    return RESULT_SUCCESS;
+}
+
+void reset_tlsf_allocator(tlsf_allocator* tlsf) {
+    ASSERT(tlsf != NULL, return, "TLSF allocator cannot be NULL");
+    tlsf->first_level_bitmap = 0;
+    memset(tlsf->second_level_bitmaps, 0, sizeof(tlsf->second_level_bitmaps));
+    memset(tlsf->free_lists, 0, sizeof(tlsf->free_lists));
+    tlsf->used_bytes = 0;
+    tlsf->peak_used_bytes = 0;
+    tlsf->allocated_blocks = 0;
+    tlsf->allocation_count = 0;
+    tlsf->failed_allocation_count = 0;
+
+    // One free block covering the region, followed by an empty allocated block so that merging stops at the end.
+    tlsf_block* block = (tlsf_block*)tlsf->memory;
+    block->size = tlsf->capacity - 2 * TLSF_BLOCK_HEADER_SIZE;
+    block->previous_physical = NULL;
+    tlsf_block* sentinel = next_physical_block(block);
+    sentinel->size = 0;
+    sentinel->previous_physical = block;
+    insert_free_block(tlsf, block);
+}
+
+void* tlsf_allocate(tlsf_allocator* tlsf, size_t alignment, size_t bytes) {
+    ASSERT(tlsf != NULL, return NULL, "TLSF allocator cannot be NULL");
+    ASSERT(alignment && (alignment & (alignment - 1)) == 0, alignment = TLSF_ALIGNMENT, "alignment must be a power of two");
+
+    size_t size = align_size(bytes);
+    bool is_over_aligned = alignment > TLSF_ALIGNMENT;
+    // An over-aligned allocation needs room to move its start forward, leaving a gap big enough to be a free block.
+    size_t search_size = is_over_aligned ? size + alignment + TLSF_BLOCK_HEADER_SIZE + TLSF_MIN_BLOCK_SIZE : size;
+
+    tlsf_block* block = bytes <= TLSF_MAX_BLOCK_SIZE ? take_free_block(tlsf, search_size) : NULL;
+    if (block == NULL) {
+        ++tlsf->failed_allocation_count;
+        return NULL;
+    }
+
+    if (is_over_aligned) {
+        uintptr_t payload = (uintptr_t)block_payload(block);
+        uintptr_t aligned = (payload + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+        if (aligned != payload) {
+            if (aligned - payload < TLSF_BLOCK_HEADER_SIZE + TLSF_MIN_BLOCK_SIZE) {
+                aligned = (payload + TLSF_BLOCK_HEADER_SIZE + TLSF_MIN_BLOCK_SIZE + (alignment - 1)) & ~(uintptr_t)(alignment - 1);
+            }
+
+            // The gap in front becomes a free block of its own.
+            size_t gap = (size_t)(aligned - payload);
+            tlsf_block* aligned_block = block_from_payload((void*)aligned);
+            aligned_block->size = block_size(block) - gap;
+            aligned_block->previous_physical = block;
+            next_physical_block(aligned_block)->previous_physical = aligned_block;
+            block->size = gap - TLSF_BLOCK_HEADER_SIZE;
+            insert_free_block(tlsf, block);
+            block = aligned_block;
+        }
+    }
+
+    trim_block(tlsf, block, size);
+
+    tlsf->used_bytes += block_size(block);
+    if (tlsf->used_bytes > tlsf->peak_used_bytes) {
+        tlsf->peak_used_bytes = tlsf->used_bytes;
+    }
+    ++tlsf->allocated_blocks;
+    ++tlsf->allocation_count;
+    return block_payload(block);
+}
+
+void tlsf_free(tlsf_allocator* tlsf, void* allocation) {
+    ASSERT(tlsf != NULL, return, "TLSF allocator cannot be NULL");
+    if (allocation == NULL) {
+        return;
+    }
+
+    DEBUG_ASSERT(tlsf_owns(tlsf, allocation), return, "Freed pointer %p does not belong to this TLSF allocator", allocation);
+    tlsf_block* block = block_from_payload(allocation);
+    DEBUG_ASSERT(!is_block_free(block), return, "Pointer %p was freed twice", allocation);
+
+    tlsf->used_bytes -= block_size(block);
+    --tlsf->allocated_blocks;
+    release_block(tlsf, block);
+}
+
+void* tlsf_reallocate(tlsf_allocator* tlsf, void* allocation, size_t alignment, size_t bytes) {
+    ASSERT(tlsf != NULL, return NULL, "TLSF allocator cannot be NULL");
+    if (allocation == NULL) {
+        return tlsf_allocate(tlsf, alignment, bytes);
+    }
+
+    DEBUG_ASSERT(tlsf_owns(tlsf, allocation), return NULL, "Reallocated pointer %p does not belong to this TLSF allocator", allocation);
+    tlsf_block* block = block_from_payload(allocation);
+    DEBUG_ASSERT(!is_block_free(block), return NULL, "Pointer %p was reallocated after being freed", allocation);
+
+    size_t size = align_size(bytes);
+    size_t current_size = block_size(block);
+    bool is_aligned = ((uintptr_t)allocation & (alignment - 1)) == 0;
+
+    if (is_aligned && bytes <= TLSF_MAX_BLOCK_SIZE) {
+        tlsf_block* next = next_physical_block(block);
+        if (size > current_size && is_block_free(next) && current_size + TLSF_BLOCK_HEADER_SIZE + block_size(next) >= size) {
+            remove_free_block(tlsf, next);
+            block->size += TLSF_BLOCK_HEADER_SIZE + block_size(next);
+            next_physical_block(block)->previous_physical = block;
+        }
+
+        if (block_size(block) >= size) {
+            trim_block(tlsf, block, size);
+            tlsf->used_bytes = tlsf->used_bytes - current_size + block_size(block);
+            if (tlsf->used_bytes > tlsf->peak_used_bytes) {
+                tlsf->peak_used_bytes = tlsf->used_bytes;
+            }
+            return allocation;
+        }
+    }
+
+    void* moved = tlsf_allocate(tlsf, alignment, bytes);
+    if (moved == NULL) {
+        return NULL;
+    }
+    memcpy(moved, allocation, current_size < bytes ? current_size : bytes);
+    tlsf_free(tlsf, allocation);
+    return moved;
+}
+
+size_t tlsf_allocation_size(const void* allocation) {
+    ASSERT(allocation != NULL, return 0, "Allocation cannot be NULL");
+    return block_size(block_from_payload(allocation));
+}
+
+tlsf_statistics get_tlsf_statistics(const tlsf_allocator* tlsf) {
+    tlsf_statistics statistics = { 0 };
+    ASSERT(tlsf != NULL, return statistics, "TLSF allocator cannot be NULL");
+    statistics.capacity = tlsf->capacity;
+    statistics.used_bytes = tlsf->used_bytes;
+    statistics.peak_used_bytes = tlsf->peak_used_bytes;
+    statistics.allocation_count = tlsf->allocation_count;
+    statistics.failed_allocation_count = tlsf->failed_allocation_count;
+
+#ifndef NDEBUG
+    const tlsf_block* previous = NULL;
+#endif
+    for (const tlsf_block* block = (const tlsf_block*)tlsf->memory; block_size(block) != 0; block = next_physical_block(block)) {
+        DEBUG_ASSERT(block->previous_physical == previous, break, "TLSF block %p has the wrong previous block", (const void*)block);
+        DEBUG_ASSERT(previous == NULL || !is_block_free(previous) || !is_block_free(block), break, "TLSF blocks %p and %p are both free but not merged",
+            (const void*)previous, (const void*)block);
+
+        statistics.header_bytes += TLSF_BLOCK_HEADER_SIZE;
+        if (is_block_free(block)) {
+            statistics.free_bytes += block_size(block);
+            ++statistics.free_blocks;
+            if (block_size(block) > statistics.largest_free_block) {
+                statistics.largest_free_block = block_size(block);
+            }
+        }
+        else {
+            ++statistics.allocated_blocks;
+        }
+#ifndef NDEBUG
+        previous = block;
+#endif
+    }
+    statistics.header_bytes += TLSF_BLOCK_HEADER_SIZE; // the sentinel
+
+    DEBUG_ASSERT(statistics.allocated_blocks == tlsf->allocated_blocks, , "TLSF allocator counted %u allocated blocks but found %u",
+        tlsf->allocated_blocks, statistics.allocated_blocks);
+    if (statistics.free_bytes > 0) {
+        statistics.fragmentation = 1.0f - (float)statistics.largest_free_block / (float)statistics.free_bytes;
+    }
+    return statistics;
+}
@@ -0,0 +1,100 @@
+#ifndef TLSF_ALLOCATOR_H
+#define TLSF_ALLOCATOR_H
+#include "platform_layer.h"
+
+/*
+A general-purpose allocator for variable-size data with individual lifetimes (level data, loaded assets, streamed sound buffers),
+managing a fixed region carved from a bump allocator. Put it in perm and it survives hot reloads like everything else in perm:
+all of its state lives in the struct and the region, and none of it in statics.
+
+It is a two-level segregated fit (TLSF) allocator. Free blocks are kept in lists by size class: the first level splits sizes
+by powers of two, and the second level splits each power of two into TLSF_SECOND_LEVEL_COUNT linear steps. A bitmap per level
+records which lists are non-empty, so finding a free block that is big enough is a couple of bit scans, and allocating and freeing
+are O(1) whatever the number of blocks. Freed blocks are merged with free neighbours straight away, which keeps fragmentation low.
+
+Every block has a 16 byte header, and allocations are 16 byte aligned (larger alignments are supported, at the cost of a split).
+It is not thread safe, so guard it with a mutex if more than one thread allocates from it.
+Allocating more than is free returns NULL and is counted in the statistics.
+
+usage:
+    tlsf_allocator* level_allocator = (tlsf_allocator*)bump_allocate(&allocators->perm, alignof(tlsf_allocator), sizeof(tlsf_allocator));
+    create_tlsf_allocator(level_allocator, &allocators->perm, 16 * 1024 * 1024);
+    tile* tiles = (tile*)tlsf_allocate(level_allocator, alignof(tile), sizeof(tile) * tile_count);
+    ...
+    tlsf_free(level_allocator, tiles);
+*/
+
+#define TLSF_ALIGNMENT 16
+#define TLSF_SECOND_LEVEL_LOG2 5
+#define TLSF_SECOND_LEVEL_COUNT (1 << TLSF_SECOND_LEVEL_LOG2)
+
+// Sizes below the small block size all map to first level 0, whose second level steps are TLSF_ALIGNMENT bytes apart.
+#define TLSF_FIRST_LEVEL_SHIFT (TLSF_SECOND_LEVEL_LOG2 + 4)
+#define TLSF_SMALL_BLOCK_SIZE (1 << TLSF_FIRST_LEVEL_SHIFT)
+
+// Blocks must be smaller than 2^TLSF_FIRST_LEVEL_MAX bytes.
+#define TLSF_FIRST_LEVEL_MAX 32
+#define TLSF_FIRST_LEVEL_COUNT (TLSF_FIRST_LEVEL_MAX - TLSF_FIRST_LEVEL_SHIFT + 1)
+
+typedef struct tlsf_block {
+    size_t size; // bytes after the header, the lowest bit is set while the block is free
+    struct tlsf_block* previous_physical; // the block just before this one in memory (NULL for the first block)
+
+    // Only valid while the block is free, these overlap the allocation otherwise.
+    struct tlsf_block* next_free;
+    struct tlsf_block* previous_free;
+} tlsf_block;
+
+typedef struct {
+    uint8_t* memory;
+    size_t capacity;
+
+    uint32_t first_level_bitmap;
+    uint32_t second_level_bitmaps[TLSF_FIRST_LEVEL_COUNT];
+    tlsf_block* free_lists[TLSF_FIRST_LEVEL_COUNT][TLSF_SECOND_LEVEL_COUNT];
+
+    size_t used_bytes; // allocated bytes (rounded up to the alignment), not counting headers
+    size_t peak_used_bytes;
+    uint32_t allocated_blocks;
+    uint64_t allocation_count;
+    uint64_t failed_allocation_count;
+} tlsf_allocator;
+
+typedef struct {
+    size_t capacity;
+    size_t used_bytes;
+    size_t peak_used_bytes;
+    size_t free_bytes;
+    size_t largest_free_block;
+    size_t header_bytes;
+    uint32_t allocated_blocks;
+    uint32_t free_blocks;
+    uint64_t allocation_count;
+    uint64_t failed_allocation_count;
+    float fragmentation; // 1 - largest free block / free bytes: 0 when all free memory is in one block
+} tlsf_statistics;
+
+result create_tlsf_allocator(tlsf_allocator* tlsf, bump_allocator* allocator, size_t capacity);
+
+// Frees every allocation at once, and starts the statistics again.
+void reset_tlsf_allocator(tlsf_allocator* tlsf);
+
+void* tlsf_allocate(tlsf_allocator* tlsf, size_t alignment, size_t bytes);
+void tlsf_free(tlsf_allocator* tlsf, void* allocation);
+
+// Grows or shrinks in place when the next block is free (or when shrinking), otherwise moves the allocation.
+// Returns NULL (leaving the allocation as it was) if there is no room. A NULL allocation is the same as tlsf_allocate.
+void* tlsf_reallocate(tlsf_allocator* tlsf, void* allocation, size_t alignment, size_t bytes);
+
+// The usable size of an allocation, which can be a little more than was asked for.
+size_t tlsf_allocation_size(const void* allocation);
+
+// Walks every block, so it costs more than the other functions (it also checks the heap is consistent in debug builds).
+tlsf_statistics get_tlsf_statistics(const tlsf_allocator* tlsf);
+
+static inline bool tlsf_owns(const tlsf_allocator* tlsf, const void* allocation) {
+    const uint8_t* address = (const uint8_t*)allocation;
+    return address >= tlsf->memory && address < tlsf->memory + tlsf->capacity;
+}
+
+#endif // TLSF_ALLOCATOR_H
@@ -13,6 +13,12 @@
 #include "geometry.h"
 #include "platform_layer.h"
 #include "asset_files.h"
+#include "sprite_instances.h"
+#include "profiler.h"
+#include "bitset.h"
+#include "frame_statistics.h"
+#include "frame_pacer.h"
+#include "job_system.h"
 
 #ifdef GAME_LOOP
 /*
@@ -61,13 +67,67 @@ HOT_RELOAD_FUNCTIONS()
 =============================================================================================================================
 */
 
-result create_bump_allocator(bump_allocator* allocator, size_t capacity) {
+static void apply_bump_allocator_options(bump_allocator* allocator, const bump_allocator_options* options) {
+    allocator->min_commit_bytes = options != NULL && options->min_commit_bytes != 0 ? options->min_commit_bytes : BUMP_ALLOCATOR_MIN_COMMIT_BYTES;
+    allocator->max_commit_bytes = options != NULL && options->max_commit_bytes != 0 ? options->max_commit_bytes : BUMP_ALLOCATOR_MAX_COMMIT_BYTES;
+    allocator->decommit_above_bytes = options != NULL ? options->decommit_above_bytes : 0;
+}
+
+// Large pages can only be allocated by processes that hold (and have enabled) the "Lock pages in memory" privilege.
+static bool enable_large_page_privilege(void) {
+    HANDLE token;
+    if (!OpenProcessToken(GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &token)) {
+        return false;
+    }
+
+    TOKEN_PRIVILEGES privileges = { 0 };
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    bool is_enabled = LookupPrivilegeValueA(NULL, "SeLockMemoryPrivilege", &privileges.Privileges[0].Luid)
+        && AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL)
+        && GetLastError() == ERROR_SUCCESS; // AdjustTokenPrivileges succeeds with ERROR_NOT_ALL_ASSIGNED when the privilege is not held
+    CloseHandle(token);
+    return is_enabled;
+}
+
+result create_bump_allocator_with_options(bump_allocator* allocator, size_t capacity, const bump_allocator_options* options) {
     ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    memset(allocator, 0, sizeof(*allocator));
+    apply_bump_allocator_options(allocator, options);
+
+    // VirtualAlloc fails if the preferred address is taken, in which case the arena goes wherever the system puts it.
+    void* preferred_base = options != NULL ? options->preferred_base : NULL;
+
+    // Large pages cannot be committed a few at a time, so the whole arena is committed up front (and never decommitted).
+    size_t large_page_size = GetLargePageMinimum();
+    if (options != NULL && options->use_huge_pages && large_page_size != 0 && enable_large_page_privilege()) {
+        size_t large_capacity = (capacity + (large_page_size - 1)) & ~(large_page_size - 1);
+        if (preferred_base != NULL) {
+            allocator->base = VirtualAlloc(preferred_base, large_capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+        if (!allocator->base) {
+            allocator->base = VirtualAlloc(NULL, large_capacity, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+        }
+        if (allocator->base) {
+            allocator->capacity = large_capacity;
+            allocator->next_page_bytes = large_capacity;
+            allocator->page_size = large_page_size;
+            allocator->uses_huge_pages = true;
+            allocator->commit_count = 1;
+            return RESULT_SUCCESS;
+        }
+    }
 
-    allocator->base = VirtualAlloc(NULL, capacity, MEM_RESERVE, PAGE_READWRITE);
-    allocator->used_bytes = 0;
-    allocator->next_page_bytes = 0;
-    allocator->capacity = capacity;
+    SYSTEM_INFO native_memory_info;
+    GetSystemInfo(&native_memory_info);
+    allocator->page_size = native_memory_info.dwPageSize;
+    allocator->capacity = (capacity + (allocator->page_size - 1)) & ~(allocator->page_size - 1);
+    if (preferred_base != NULL) {
+        allocator->base = VirtualAlloc(preferred_base, allocator->capacity, MEM_RESERVE, PAGE_READWRITE);
+    }
+    if (!allocator->base) {
+        allocator->base = VirtualAlloc(NULL, allocator->capacity, MEM_RESERVE, PAGE_READWRITE);
+    }
 
     if (!allocator->base) {
         BUG("Failed to reserve virtual memory for bump allocator. Error: %d", GetLastError());
@@ -97,100 +157,198 @@ void* bump_allocate(bump_allocator* allocator, size_t alignment, size_t bytes) {
     }
 
     if (new_used_bytes > allocator->next_page_bytes) {
-        SYSTEM_INFO native_memory_info;
-        GetSystemInfo(&native_memory_info);
-
         // Need to commit more memory.
-        SIZE_T commit_size = ((new_used_bytes - allocator->next_page_bytes) + (native_memory_info.dwPageSize - 1)) & ~(native_memory_info.dwPageSize - 1);
+        SIZE_T commit_size = get_bump_allocator_commit_bytes(allocator, new_used_bytes);
         if (VirtualAlloc((LPBYTE)allocator->base + allocator->next_page_bytes, commit_size, MEM_COMMIT, PAGE_READWRITE) == NULL) {
             BUG("Failed to commit more memory for bump allocator.");
             return NULL;
         }
 
         allocator->next_page_bytes += commit_size;
+        ++allocator->commit_count;
     }
 
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    size_t previous_used_bytes = allocator->used_bytes;
+    allocator->used_bytes = new_used_bytes;
+    record_bump_allocation(allocator, previous_used_bytes);
+#else
     allocator->used_bytes = new_used_bytes;
+#endif
     return (LPBYTE)allocator->base + aligned;
 }
 
-string concat(string a, string b, bump_allocator* allocator) {
-    ASSERT(allocator != NULL, return ((string) {
-        .text = NULL, .length = 0
-    }), "Allocator cannot be NULL");
-    uint32_t total_length = a.length + b.length;
-    char* combined_text = (char*)bump_allocate(allocator, 1, total_length + 1);
-    if (combined_text == NULL) {
-        BUG("Failed to allocate memory for concatenated string.");
-        return (string) {
-            .text = NULL, .length = 0
-        };
+void decommit_bump_allocator(bump_allocator* allocator, size_t keep_bytes) {
+    ASSERT(allocator != NULL, return, "Allocator cannot be NULL");
+    if (allocator->uses_huge_pages) {
+        return; // large pages stay committed for the lifetime of the allocator
     }
-    memcpy(combined_text, a.text, a.length);
-    memcpy(combined_text + a.length, b.text, b.length);
-    combined_text[total_length] = '\0';
-    return (string) {
-        .text = combined_text, .length = total_length
-    };
+
+    if (keep_bytes < allocator->used_bytes) {
+        keep_bytes = allocator->used_bytes;
+    }
+    keep_bytes = (keep_bytes + (allocator->page_size - 1)) & ~(allocator->page_size - 1);
+    if (keep_bytes >= allocator->next_page_bytes) {
+        return;
+    }
+
+    if (!VirtualFree((LPBYTE)allocator->base + keep_bytes, allocator->next_page_bytes - keep_bytes, MEM_DECOMMIT)) {
+        BUG("Failed to decommit bump allocator memory. Error: %d", GetLastError());
+        return;
+    }
+    allocator->next_page_bytes = keep_bytes;
 }
 
-result append_last_string(string* original, string to_append, bump_allocator* allocator) {
-    ASSERT(original != NULL, return RESULT_FAILURE, "Original string pointer cannot be NULL");
+// WriteFile and ReadFile take 32 bit sizes, so big regions are written and read in chunks.
+#define ARENA_SNAPSHOT_CHUNK_BYTES (256u * 1024 * 1024)
+
+result save_arena_snapshot(const bump_allocator* allocator, size_t begin, const void* root, uint32_t version, string path) {
     ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
-    ASSERT(original->text == (const char*)((uint8_t*)allocator->base + (allocator->used_bytes - original->length)), return RESULT_FAILURE, "Original string must be the last allocation in the bump allocator to use string_append");
+    ASSERT(begin <= allocator->used_bytes, return RESULT_FAILURE, "Snapshot region begins after the end of the arena");
+    arena_snapshot_header header = make_arena_snapshot_header(allocator, begin, root, version);
+    ASSERT(header.root_offset >= begin && header.root_offset < header.end, return RESULT_FAILURE, "Snapshot root is not in the snapshot region");
 
-    char* new_text = (char*)bump_allocate(allocator, 1, to_append.length);
-    if (new_text == NULL) {
-        BUG("Failed to allocate memory for string append.");
+    HANDLE file_handle = CreateFileA(path.text, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        BUG("Failed to open file for writing: %.*s", path.length, path.text);
+        return RESULT_FAILURE;
+    }
+
+    DWORD bytes_written = 0;
+    LARGE_INTEGER data_offset = { .QuadPart = ARENA_SNAPSHOT_DATA_OFFSET };
+    bool written = WriteFile(file_handle, &header, sizeof(header), &bytes_written, NULL) && bytes_written == sizeof(header)
+        && SetFilePointerEx(file_handle, data_offset, NULL, FILE_BEGIN);
+
+    const uint8_t* region = (const uint8_t*)allocator->base + begin;
+    size_t region_bytes = (size_t)(header.end - header.begin);
+    for (size_t total_written = 0; written && total_written < region_bytes; total_written += bytes_written) {
+        size_t remaining = region_bytes - total_written;
+        DWORD chunk_bytes = (DWORD)(remaining < ARENA_SNAPSHOT_CHUNK_BYTES ? remaining : ARENA_SNAPSHOT_CHUNK_BYTES);
+        written = WriteFile(file_handle, region + total_written, chunk_bytes, &bytes_written, NULL) && bytes_written == chunk_bytes;
+    }
+
+    CloseHandle(file_handle);
+    if (!written) {
+        BUG("Failed to write arena snapshot: %.*s", path.length, path.text);
         return RESULT_FAILURE;
     }
-    memcpy(new_text, to_append.text, to_append.length);
-    original->length += to_append.length;
     return RESULT_SUCCESS;
 }
 
-/*
-=============================================================================================================================
-    Time
-=============================================================================================================================
-*/
-
-result create_clock(clock* clock) {
-    ASSERT(clock != NULL, return RESULT_FAILURE, "Clock cannot be NULL");
+result load_arena_snapshot(bump_allocator* allocator, size_t begin, uint32_t version, string path, void** out_root) {
+    ASSERT(allocator != NULL, return RESULT_FAILURE, "Allocator cannot be NULL");
+    ASSERT(out_root != NULL, return RESULT_FAILURE, "Output root cannot be NULL");
+    ASSERT(begin <= allocator->used_bytes, return RESULT_FAILURE, "Snapshot region begins after the end of the arena");
+    DEBUG_ASSERT(allocator->scope_depth == 0, return RESULT_FAILURE, "Arena snapshot loaded with %u arena scope(s) still open", allocator->scope_depth);
 
-    LARGE_INTEGER frequency;
-    if (!QueryPerformanceFrequency(&frequency)) {
-        BUG("Failed to query performance frequency.");
+    HANDLE file_handle = CreateFileA(path.text, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        BUG("Failed to open file for reading: %.*s", path.length, path.text);
         return RESULT_FAILURE;
     }
 
-    LARGE_INTEGER current_time;
-    if (!QueryPerformanceCounter(&current_time)) {
-        BUG("Failed to query performance counter.");
+    arena_snapshot_header header;
+    DWORD bytes_read = 0;
+    LARGE_INTEGER file_size;
+    if (!ReadFile(file_handle, &header, sizeof(header), &bytes_read, NULL) || bytes_read != sizeof(header) || !GetFileSizeEx(file_handle, &file_size)) {
+        BUG("Failed to read arena snapshot: %.*s", path.length, path.text);
+        CloseHandle(file_handle);
+        return RESULT_FAILURE;
+    }
+    if (check_arena_snapshot_header(allocator, begin, version, &header, path) != RESULT_SUCCESS) {
+        CloseHandle(file_handle);
+        return RESULT_FAILURE;
+    }
+    if ((uint64_t)file_size.QuadPart < ARENA_SNAPSHOT_DATA_OFFSET + (header.end - header.begin)) {
+        BUG("Arena snapshot is shorter than its header says: %.*s", path.length, path.text);
+        CloseHandle(file_handle);
         return RESULT_FAILURE;
     }
 
-    clock->frequency = (float)frequency.QuadPart;
-    clock->creation_time = (float)current_time.QuadPart / clock->frequency;
-    clock->time_since_creation = 0.0f;
-    clock->time_since_previous_update = 0.0f;
+    // Commit the whole region in one go, then read straight into it.
+    size_t end = (size_t)header.end;
+    if (end > allocator->next_page_bytes) {
+        size_t commit_end = (end + (allocator->page_size - 1)) & ~(allocator->page_size - 1);
+        if (VirtualAlloc((LPBYTE)allocator->base + allocator->next_page_bytes, commit_end - allocator->next_page_bytes, MEM_COMMIT, PAGE_READWRITE) == NULL) {
+            BUG("Failed to commit memory for arena snapshot: %.*s", path.length, path.text);
+            CloseHandle(file_handle);
+            return RESULT_FAILURE;
+        }
+        allocator->next_page_bytes = commit_end;
+        ++allocator->commit_count;
+    }
+
+    LARGE_INTEGER data_offset = { .QuadPart = ARENA_SNAPSHOT_DATA_OFFSET };
+    bool read_all = SetFilePointerEx(file_handle, data_offset, NULL, FILE_BEGIN);
+    uint8_t* region = (uint8_t*)allocator->base + begin;
+    size_t region_bytes = end - begin;
+    for (size_t total_read = 0; read_all && total_read < region_bytes; total_read += bytes_read) {
+        size_t remaining = region_bytes - total_read;
+        DWORD chunk_bytes = (DWORD)(remaining < ARENA_SNAPSHOT_CHUNK_BYTES ? remaining : ARENA_SNAPSHOT_CHUNK_BYTES);
+        read_all = ReadFile(file_handle, region + total_read, chunk_bytes, &bytes_read, NULL) && bytes_read == chunk_bytes;
+    }
 
+    CloseHandle(file_handle);
+    if (!read_all) {
+        // The region has been partly overwritten, so it cannot be used either way.
+        BUG("Failed to read arena snapshot: %.*s", path.length, path.text);
+        return RESULT_FAILURE;
+    }
+
+    allocator->used_bytes = end;
+    *out_root = (uint8_t*)allocator->base + header.root_offset;
     return RESULT_SUCCESS;
 }
 
-void update_clock(clock* clock) {
-    ASSERT(clock != NULL, return, "Clock cannot be NULL");
+/*
+=============================================================================================================================
+    Time
+=============================================================================================================================
+*/
 
+// QueryPerformanceCounter cannot fail on Windows XP and later, so the results are not checked.
+uint64_t read_timestamp(void) {
     LARGE_INTEGER current_time;
-    if (!QueryPerformanceCounter(&current_time)) {
-        BUG("Failed to query performance counter.");
-        return;
+    QueryPerformanceCounter(&current_time);
+    return (uint64_t)current_time.QuadPart;
+}
+
+uint64_t get_timestamp_frequency(void) {
+    // The frequency is fixed at boot, so it is only queried once (racing threads would store the same value).
+    static uint64_t frequency = 0;
+    if (frequency == 0) {
+        LARGE_INTEGER queried_frequency;
+        QueryPerformanceFrequency(&queried_frequency);
+        frequency = (uint64_t)queried_frequency.QuadPart;
+    }
+    return frequency;
+}
+
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+void sleep_for_ticks(uint64_t ticks) {
+    // Sleep() is limited to the system timer resolution (15.6ms by default). High resolution waitable timers
+    // (Windows 10 1803 and later) are accurate to well under a millisecond, so one is created per thread when available.
+    static THREAD_LOCAL HANDLE timer = NULL;
+    static THREAD_LOCAL bool has_tried_to_create_timer = false;
+    if (!has_tried_to_create_timer) {
+        has_tried_to_create_timer = true;
+        timer = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    }
+
+    uint64_t nanoseconds = timestamp_to_nanoseconds(ticks);
+    if (timer != NULL) {
+        LARGE_INTEGER due_time;
+        due_time.QuadPart = -(LONGLONG)(nanoseconds / 100); // negative means relative, in 100ns units
+        if (SetWaitableTimerEx(timer, &due_time, 0, NULL, NULL, NULL, 0)) {
+            WaitForSingleObject(timer, INFINITE);
+            return;
+        }
     }
 
-    float current_time_seconds = (float)current_time.QuadPart / clock->frequency;
-    clock->time_since_previous_update = current_time_seconds - clock->previous_update_time;
-    clock->time_since_creation = current_time_seconds - clock->creation_time;
-    clock->previous_update_time = current_time_seconds;
+    Sleep((DWORD)(nanoseconds / 1000000ull));
 }
 
 /*
@@ -331,7 +489,7 @@ result read_entire_file(string path, bump_allocator* allocator, string* out_file
         return RESULT_FAILURE;
     }
 
-    void* buffer = bump_allocate(allocator, alignof(void*), (size_t)file_size.QuadPart);
+    void* buffer = BUMP_ALLOCATE_TAGGED(allocator, alignof(void*), (size_t)file_size.QuadPart, "files");
     if (buffer == NULL) {
         BUG("Failed to allocate memory for reading file: %.*s", path.length, path.text);
         CloseHandle(file_handle);
@@ -377,9 +535,11 @@ result write_entire_file(string path, const void* data, size_t size) {
 =============================================================================================================================
 */
 
+DECLARE_BITSET(key_bitset, 256)
+
 typedef struct input {
-    uint64_t keys_pressed_bitset[4];
-    uint64_t keys_modified_this_frame_bitset[4];
+    key_bitset keys_pressed;
+    key_bitset keys_modified_this_frame;
     int32_t mouse_x;
     int32_t mouse_y;
     bool closed_window;
@@ -437,20 +597,16 @@ static LRESULT window_proc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         ASSERT(w != NULL, return 0, "Window internals cannot be NULL in WM_KEYDOWN/WM_SYSKEYDOWN");
         int key = (int)wParam;
         ASSERT(key >= 0 && key < 256, return 0, "Unrecognized key code %d found in WM_KEYDOWN/WM_SYSKEYDOWN event.", key);
-        size_t index = key >> 6;
-        uint64_t mask = (uint64_t)1 << (key & 63);
-        w->input_state.keys_pressed_bitset[index] |= mask;
-        w->input_state.keys_modified_this_frame_bitset[index] |= mask;
+        key_bitset_set(&w->input_state.keys_pressed, (uint32_t)key);
+        key_bitset_set(&w->input_state.keys_modified_this_frame, (uint32_t)key);
     } break;
     case WM_KEYUP:
     case WM_SYSKEYUP: {
         ASSERT(w != NULL, return 0, "Window internals cannot be NULL in WM_KEYUP/WM_SYSKEYUP");
         int key = (int)wParam;
         ASSERT(key >= 0 && key < 256, return 0, "Unrecognized key code %d found in WM_KEYUP/WM_SYSKEYUP event.", key);
-        size_t index = key >> 6;
-        uint64_t mask = (uint64_t)1 << (key & 63);
-        w->input_state.keys_pressed_bitset[index] &= ~mask;
-        w->input_state.keys_modified_this_frame_bitset[index] |= mask;
+        key_bitset_clear(&w->input_state.keys_pressed, (uint32_t)key);
+        key_bitset_set(&w->input_state.keys_modified_this_frame, (uint32_t)key);
     } break;
     case WM_MOUSEMOVE: {
         ASSERT(w != NULL, return 0, "Window internals cannot be NULL in WM_MOUSEMOVE");
@@ -555,7 +711,7 @@ static window_size get_window_size(window* window) {
 static input* update_window_input(window* window) {
     ASSERT(window != NULL, return NULL, "Window pointer cannot be NULL");
     input* input_state = &window->input_state;
-    memset(input_state->keys_modified_this_frame_bitset, 0, sizeof(input_state->keys_modified_this_frame_bitset));
+    key_bitset_clear_all(&input_state->keys_modified_this_frame);
 
     // Poll for events
     MSG msg;
@@ -579,27 +735,19 @@ static void destroy_window(window* window) {
 bool is_key_down(input* input_state, keyboard_key key) {
     ASSERT(input_state != NULL, return false, "Input state cannot be NULL");
     ASSERT(key >= 0 && key < 256, return false, "Key %d out of range", key);
-    uint32_t index = key >> 6;
-    uint64_t mask = (uint64_t)1 << (key & 63);
-    return (input_state->keys_pressed_bitset[index] & mask) != 0 &&
-        (input_state->keys_modified_this_frame_bitset[index] & mask) != 0;
+    return key_bitset_test(&input_state->keys_pressed, key) && key_bitset_test(&input_state->keys_modified_this_frame, key);
 }
 
 bool is_key_held_down(input* input_state, keyboard_key key) {
     ASSERT(input_state != NULL, return false, "Input state cannot be NULL");
     ASSERT(key >= 0 && key < 256, return false, "Key %d out of range", key);
-    uint32_t index = key >> 6;
-    uint64_t mask = (uint64_t)1 << (key & 63);
-    return (input_state->keys_pressed_bitset[index] & mask) != 0;
+    return key_bitset_test(&input_state->keys_pressed, key);
 }
 
 bool is_key_up(input* input_state, keyboard_key key) {
     ASSERT(input_state != NULL, return false, "Input state cannot be NULL");
     ASSERT(key >= 0 && key < 256, return false, "Key %d out of range", key);
-    uint32_t index = key >> 6;
-    uint64_t mask = (uint64_t)1 << (key & 63);
-    return (input_state->keys_pressed_bitset[index] & mask) == 0 &&
-        (input_state->keys_modified_this_frame_bitset[index] & mask) != 0;
+    return !key_bitset_test(&input_state->keys_pressed, key) && key_bitset_test(&input_state->keys_modified_this_frame, key);
 }
 
 #pragma region shaders
@@ -665,21 +813,11 @@ float4 main(PS_INPUT input) : SV_TARGET{
 =============================================================================================================================
 */
 
-typedef struct {
-    vector2 position;
-    vector2 texcoord;
-    vector2 src_scale;
-    vector2 dst_scale;
-    float rotation;
-} sprite_instance;
-
-typedef struct {
-    sprite_instance* elements;
-    size_t count;
-} sprite_instances;
-
 #define SWAPCHAIN_BUFFER_COUNT 2
 
+// Each instance buffer is filled while the frame arenas' data from the same frame is valid, so they rotate together.
+STATIC_ASSERT(FRAME_ARENA_COUNT >= SWAPCHAIN_BUFFER_COUNT, frame_arenas_outlive_instance_buffers);
+
 typedef struct graphics {
     vector2int sprite_sheet_size;
     window_size cached_window_size;
@@ -723,14 +861,7 @@ void draw_sprite(graphics* graphics, vector2 position, vector2 scale, vector2int
 
     sprite_instance* instance = &graphics->sprite_instances.elements[graphics->sprite_instances.count];
     ++graphics->sprite_instances.count;
-
-    // convert to normalized device coordinates
-
-    instance->position = (vector2){ (position.x / (float)graphics->virtual_resolution.x) * 2.0f - 1.0f,  1.0f - (position.y / (float)graphics->virtual_resolution.y) * 2.0f };
-    instance->dst_scale = (vector2){ (scale.x / (float)graphics->virtual_resolution.x), (scale.y / (float)graphics->virtual_resolution.y) };
-    instance->src_scale = (vector2){ (float)sample_scale.x / (float)graphics->sprite_sheet_size.x, (float)sample_scale.y / (float)graphics->sprite_sheet_size.y };
-    instance->texcoord = (vector2){ (float)sample_point.x / (float)graphics->sprite_sheet_size.x, (float)sample_point.y / (float)graphics->sprite_sheet_size.y };
-    instance->rotation = rotation;
+    write_sprite_instance(instance, graphics->virtual_resolution, graphics->sprite_sheet_size, position, scale, sample_point, sample_scale, rotation);
 }
 
 void draw_projected_sprite(graphics* graphics, const camera_2d* projection_camera, vector2 world_position, vector2 world_scale, vector2int sample_point, vector2int sample_scale, float rotation) {
@@ -1231,12 +1362,11 @@ static void present_graphics(graphics* graphics) {
     }
 
     graphics->swap_chain->lpVtbl->Present(graphics->swap_chain, 0, 0);
-    if (graphics->instance_buffer == graphics->instance_buffers[0]) {
-        graphics->instance_buffer = graphics->instance_buffers[1];
-    }
-    else {
-        graphics->instance_buffer = graphics->instance_buffers[0];
-    }
+}
+
+// Picks the instance buffer for a frame, so they rotate in lockstep with the frame arenas.
+static void select_instance_buffer(graphics* graphics, uint64_t frame_number) {
+    graphics->instance_buffer = graphics->instance_buffers[frame_number % SWAPCHAIN_BUFFER_COUNT];
 }
 
 static void destroy_graphics(graphics* graphics) {
@@ -1326,7 +1456,10 @@ typedef struct {
     float fade_duration;
     float fade_time_remaining;
     fade_mode fade_mode;
-    volatile long is_playing;
+    atomic_uint32 is_playing; // cleared from the XAudio2 callback thread
+    bool is_positional;
+    bool has_output_matrix; // <- true when the voice has a non-identity output matrix that must be reset before non-positional reuse
+    float output_gains[AUDIO_CHANNELS];
 } sound_player;
 
 // Callback implementations for sound_player (emulating polymorphism in C with a vtable):
@@ -1344,7 +1477,7 @@ void sound_player_on_voice_processing_pass_end(IXAudio2VoiceCallback* this_callb
 
 void sound_player_on_stream_end(IXAudio2VoiceCallback* this_callback) {
     sound_player* this_sound_player = (sound_player*)this_callback;
-    this_sound_player->is_playing = 0;
+    atomic_store_uint32(&this_sound_player->is_playing, 0, MEMORY_ORDER_RELEASE);
 }
 
 void sound_player_on_buffer_start(IXAudio2VoiceCallback* this_callback, void* p_buffer_context) {
@@ -1378,12 +1511,25 @@ static IXAudio2VoiceCallbackVtbl sound_player_vtable = {
     .OnVoiceError = sound_player_on_voice_error
 };
 
+// Positional voice data is kept as a structure of arrays (padded to the SIMD width) so that pan and gain
+// can be computed for 4 voices at a time, instead of one voice per API call.
+#define AUDIO_VOICE_LANES ((MAX_CONCURRENT_SOUNDS + 3) & ~3)
+
+typedef struct {
+    alignas(16) float position_x[AUDIO_VOICE_LANES];
+    alignas(16) float position_y[AUDIO_VOICE_LANES];
+    alignas(16) float left_gain[AUDIO_VOICE_LANES];
+    alignas(16) float right_gain[AUDIO_VOICE_LANES];
+} positional_voices;
+
 typedef struct audio {
     IXAudio2* xaudio2;
     IXAudio2MasteringVoice* mastering_voice;
     WAVEFORMATEX master_wave_format;
     sounds sounds;
     sound_player sound_players[MAX_CONCURRENT_SOUNDS];
+    positional_voices positional_voices;
+    camera_2d listener;
     float volume;
 } audio;
 
@@ -1401,7 +1547,7 @@ static result create_sound_players(audio* audio, sound_player* out_sound_players
 
     for (uint32_t i = 0; i < MAX_CONCURRENT_SOUNDS; ++i) {
         out_sound_players[i].inheritance.lpVtbl = &sound_player_vtable;
-        out_sound_players[i].is_playing = false;
+        atomic_store_uint32(&out_sound_players[i].is_playing, 0, MEMORY_ORDER_RELAXED);
         HRESULT hr = audio->xaudio2->lpVtbl->CreateSourceVoice(
             audio->xaudio2,
             &out_sound_players[i].source_voice,
@@ -1427,6 +1573,7 @@ static result create_audio(memory_allocators* allocators, audio* audio) {
     ASSERT(allocators != NULL, return RESULT_FAILURE, "Memory allocators pointer cannot be NULL");
     memset(audio, 0, sizeof(*audio));
     audio->volume = AUDIO_DEFAULT_VOLUME;
+    audio->listener.zoom = 1.0f;
     HRESULT hr = RESULT_SUCCESS;
 
     hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
@@ -1520,7 +1667,84 @@ static result find_sound_player(audio* audio, sound_player** out_sound_player) {
     return RESULT_FAILURE;
 }
 
-result play_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration) {
+STATIC_ASSERT(AUDIO_CHANNELS == 2, positional_audio_assumes_stereo_output);
+
+/*
+Computes the stereo gains of every positional voice at once (4 voices per SSE register).
+The sound is panned by its horizontal offset from the listener (linear balance law) and attenuated with an
+inverse distance rolloff beyond AUDIO_ATTENUATION_MIN_DISTANCE. Offsets are measured in listener screen units (scaled by zoom).
+*/
+static void compute_positional_gains(positional_voices* voices, camera_2d listener) {
+    ASSERT(voices != NULL, return, "Positional voices pointer cannot be NULL");
+
+    const __m128 listener_x = _mm_set1_ps(listener.position.x);
+    const __m128 listener_y = _mm_set1_ps(listener.position.y);
+    const __m128 zoom = _mm_set1_ps(listener.zoom);
+    const __m128 inverse_pan_distance = _mm_set1_ps(1.0f / AUDIO_PAN_DISTANCE);
+    const __m128 min_distance = _mm_set1_ps(AUDIO_ATTENUATION_MIN_DISTANCE);
+    const __m128 rolloff = _mm_set1_ps(AUDIO_ATTENUATION_ROLLOFF);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minus_one = _mm_set1_ps(-1.0f);
+
+    for (uint32_t i = 0; i < AUDIO_VOICE_LANES; i += 4) {
+        __m128 dx = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&voices->position_x[i]), listener_x), zoom);
+        __m128 dy = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&voices->position_y[i]), listener_y), zoom);
+
+        __m128 pan = _mm_max_ps(minus_one, _mm_min_ps(one, _mm_mul_ps(dx, inverse_pan_distance)));
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+        __m128 excess_distance = _mm_max_ps(zero, _mm_sub_ps(distance, min_distance));
+        __m128 gain = _mm_div_ps(min_distance, _mm_add_ps(min_distance, _mm_mul_ps(rolloff, excess_distance)));
+
+        _mm_store_ps(&voices->left_gain[i], _mm_mul_ps(gain, _mm_min_ps(one, _mm_sub_ps(one, pan))));
+        _mm_store_ps(&voices->right_gain[i], _mm_mul_ps(gain, _mm_min_ps(one, _mm_add_ps(one, pan))));
+    }
+}
+
+static void set_sound_player_output_gains(sound_player* sound_player, float left_gain, float right_gain) {
+    ASSERT(sound_player != NULL, return, "Sound player pointer cannot be NULL");
+
+    // Skip the XAudio2 call when the change would not be audible.
+    const float epsilon = 1.0f / 256.0f;
+    if (sound_player->has_output_matrix &&
+        fabsf(sound_player->output_gains[0] - left_gain) < epsilon &&
+        fabsf(sound_player->output_gains[1] - right_gain) < epsilon) {
+        return;
+    }
+
+    // The matrix is indexed by [destination channel * source channels + source channel].
+    float output_matrix[AUDIO_CHANNELS * AUDIO_CHANNELS] = {
+        left_gain, 0.0f,
+        0.0f, right_gain,
+    };
+
+    HRESULT hr = sound_player->source_voice->lpVtbl->SetOutputMatrix(sound_player->source_voice, NULL, AUDIO_CHANNELS, AUDIO_CHANNELS, output_matrix, 0);
+    ASSERT(SUCCEEDED(hr), return, "Failed to set output matrix for positional sound. HRESULT: 0x%08X", hr);
+    sound_player->output_gains[0] = left_gain;
+    sound_player->output_gains[1] = right_gain;
+    sound_player->has_output_matrix = true;
+}
+
+static void update_positional_sounds(audio* audio) {
+    ASSERT(audio != NULL, return, "Audio pointer cannot be NULL");
+    compute_positional_gains(&audio->positional_voices, audio->listener);
+
+    for (uint32_t i = 0; i < MAX_CONCURRENT_SOUNDS; ++i) {
+        sound_player* sound_player = &audio->sound_players[i];
+        if (sound_player->sound == NULL || !sound_player->is_positional) {
+            continue;
+        }
+
+        set_sound_player_output_gains(sound_player, audio->positional_voices.left_gain[i], audio->positional_voices.right_gain[i]);
+    }
+}
+
+void set_audio_listener(audio* audio, camera_2d listener) {
+    ASSERT(audio != NULL, return, "Audio pointer cannot be NULL");
+    audio->listener = listener;
+}
+
+static result start_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration, bool is_positional, vector2 world_position) {
     ASSERT(audio != NULL, return RESULT_FAILURE, "Audio pointer cannot be NULL");
     ASSERT(sound_index < audio->sounds.count, return RESULT_FAILURE, "Invalid sound index");
 
@@ -1540,7 +1764,7 @@ result play_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags,
         return RESULT_FAILURE;
     }
 
-    InterlockedExchange(&sound_player->is_playing, 1);
+    atomic_store_uint32(&sound_player->is_playing, 1, MEMORY_ORDER_SEQ_CST);
     sound_player->sound = sound_to_play;
     if (fade_in_duration > 0.0f) {
         sound_player->fade_mode = FADE_IN;
@@ -1555,6 +1779,20 @@ result play_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags,
         sound_player->source_voice->lpVtbl->SetVolume(sound_player->source_voice, 1.0f, 0);
     }
 
+    uint32_t voice_index = (uint32_t)(sound_player - audio->sound_players);
+    sound_player->is_positional = is_positional;
+    if (is_positional) {
+        audio->positional_voices.position_x[voice_index] = world_position.x;
+        audio->positional_voices.position_y[voice_index] = world_position.y;
+
+        // Pan the new voice before it starts so the first audio block is already positioned.
+        update_positional_sounds(audio);
+    }
+    else if (sound_player->has_output_matrix) {
+        set_sound_player_output_gains(sound_player, 1.0f, 1.0f);
+        sound_player->has_output_matrix = false;
+    }
+
     XAUDIO2_BUFFER buffer = { 0 };
     buffer.AudioBytes = (UINT32)sound_to_play->data_size;
     buffer.pAudioData = sound_to_play->data;
@@ -1576,8 +1814,18 @@ result play_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags,
     return RESULT_SUCCESS;
 }
 
+result play_sound(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration) {
+    return start_sound(audio, sound_index, flags, fade_in_duration, false, VECTOR2_ZERO);
+}
+
+result play_sound_at(audio* audio, uint32_t sound_index, playing_sound_flags flags, float fade_in_duration, vector2 world_position) {
+    return start_sound(audio, sound_index, flags, fade_in_duration, true, world_position);
+}
+
 static void update_audio(audio* audio, float delta_time) {
     ASSERT(audio != NULL, return, "Audio pointer cannot be NULL");
+    update_positional_sounds(audio);
+
     for (uint32_t i = 0; i < MAX_CONCURRENT_SOUNDS; ++i) {
         sound_player* sound_player = &audio->sound_players[i];
         if (sound_player->sound == NULL) {
@@ -1585,11 +1833,12 @@ static void update_audio(audio* audio, float delta_time) {
         }
 
         ASSERT(sound_player->source_voice != NULL, continue, "Sound player's source voice cannot be NULL");
-        if (!sound_player->is_playing) {
+        if (atomic_load_uint32(&sound_player->is_playing, MEMORY_ORDER_ACQUIRE) == 0) {
             sound_player->source_voice->lpVtbl->Stop(sound_player->source_voice, 0, 0);
             sound_player->source_voice->lpVtbl->FlushSourceBuffers(sound_player->source_voice);
             sound_player->source_voice->lpVtbl->SetVolume(sound_player->source_voice, 1.0f, 0);
             sound_player->sound = NULL;
+            sound_player->is_positional = false;
             continue;
         }
 
@@ -1622,11 +1871,12 @@ void stop_sound(audio* audio, uint32_t sound_index, stopping_mode mode, float fa
                 }
             }
             else {
-                InterlockedExchange(&sound_player->is_playing, 0);
+                atomic_store_uint32(&sound_player->is_playing, 0, MEMORY_ORDER_SEQ_CST);
                 sound_player->source_voice->lpVtbl->Stop(sound_player->source_voice, 0, 0);
                 sound_player->source_voice->lpVtbl->FlushSourceBuffers(sound_player->source_voice);
                 sound_player->source_voice->lpVtbl->SetVolume(sound_player->source_voice, 1.0f, 0);
                 sound_player->sound = NULL;
+                sound_player->is_positional = false;
             }
 
             if (mode == STOPPING_FIRST_FOUND) {
@@ -1712,38 +1962,32 @@ static bool potential_hot_reload(hot_reload_condition hot_reload_condition) {
 =============================================================================================================================
 */
 
-STATIC_ASSERT((sizeof(mutex) == sizeof(HANDLE)), mutex_size_must_match_handle_size);
-STATIC_ASSERT((alignof(mutex) >= alignof(HANDLE)), mutex_alignment_must_match_handle_alignment);
+// Slim reader/writer locks are used instead of kernel mutex handles: they do not enter the kernel when uncontended,
+// need no cleanup, and are what SleepConditionVariableSRW expects.
+STATIC_ASSERT((sizeof(mutex) == sizeof(SRWLOCK)), mutex_size_must_match_srwlock_size);
+STATIC_ASSERT((alignof(mutex) >= alignof(SRWLOCK)), mutex_alignment_must_match_srwlock_alignment);
 
 result create_mutex(mutex* m) {
     ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
-    HANDLE* handle = (HANDLE*)m->internals;
-    *handle = CreateMutexA(NULL, FALSE, NULL);
-    ASSERT(*handle != NULL, return RESULT_FAILURE, "Failed to create mutex");
+    InitializeSRWLock((PSRWLOCK)m->internals);
     return RESULT_SUCCESS;
 }
 
 result lock_mutex(mutex* m) {
     ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
-    HANDLE* handle = (HANDLE*)m->internals;
-    DWORD wait_result = WaitForSingleObject(*handle, INFINITE);
-    ASSERT(wait_result == WAIT_OBJECT_0, return RESULT_FAILURE, "Failed to lock mutex, error code: %lu, wait result: %lu", GetLastError(), wait_result);
+    AcquireSRWLockExclusive((PSRWLOCK)m->internals);
     return RESULT_SUCCESS;
 }
 
 result unlock_mutex(mutex* m) {
     ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
-    HANDLE* handle = (HANDLE*)m->internals;
-    BOOL release_result = ReleaseMutex(*handle);
-    ASSERT(release_result != 0, return RESULT_FAILURE, "Failed to unlock mutex, error code: %lu, release result: %lu", GetLastError(), release_result);
+    ReleaseSRWLockExclusive((PSRWLOCK)m->internals);
     return RESULT_SUCCESS;
 }
 
 void destroy_mutex(mutex* m) {
     ASSERT(m != NULL, return, "Mutex pointer cannot be NULL");
-    HANDLE* handle = (HANDLE*)m->internals;
-    BOOL close_result = CloseHandle(*handle);
-    DEBUG_ASSERT(close_result != 0, return, "Failed to destroy mutex");
+    // SRW locks do not own any resources.
 }
 
 STATIC_ASSERT((sizeof(thread) == sizeof(HANDLE)), thread_size_must_match_handle_size);
@@ -1791,19 +2035,98 @@ result init_condition_variable(condition_variable* cv) {
     return RESULT_SUCCESS;
 }
 
+void destroy_condition_variable(condition_variable* cv) {
+    ASSERT(cv != NULL, return, "Condition variable pointer cannot be NULL");
+    // Condition variables do not own any resources.
+}
+
 result signal_condition_variable(condition_variable* cv) {
     ASSERT(cv != NULL, return RESULT_FAILURE, "Condition variable pointer cannot be NULL");
     WakeConditionVariable((PCONDITION_VARIABLE)cv->internals);
     return RESULT_SUCCESS;
 }
 
+result broadcast_condition_variable(condition_variable* cv) {
+    ASSERT(cv != NULL, return RESULT_FAILURE, "Condition variable pointer cannot be NULL");
+    WakeAllConditionVariable((PCONDITION_VARIABLE)cv->internals);
+    return RESULT_SUCCESS;
+}
+
 result wait_condition_variable(condition_variable* cv, mutex* m) {
     ASSERT(cv != NULL, return RESULT_FAILURE, "Condition variable pointer cannot be NULL");
     ASSERT(m != NULL, return RESULT_FAILURE, "Mutex pointer cannot be NULL");
-    SleepConditionVariableCS((PCONDITION_VARIABLE)cv->internals, (PCRITICAL_SECTION)m->internals, INFINITE);
+    BOOL wait_result = SleepConditionVariableSRW((PCONDITION_VARIABLE)cv->internals, (PSRWLOCK)m->internals, INFINITE, 0);
+    ASSERT(wait_result != 0, return RESULT_FAILURE, "Failed to wait on condition variable, error code: %lu", GetLastError());
+    return RESULT_SUCCESS;
+}
+
+uint32_t get_processor_count(void) {
+    DWORD count = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    return count > 0 ? (uint32_t)count : 1;
+}
+
+void yield_thread(void) {
+    SwitchToThread();
+}
+
+uint64_t get_current_thread_id(void) {
+    return (uint64_t)GetCurrentThreadId();
+}
+
+// WaitOnAddress is in Synchronization.lib (Windows 8 and later).
+void wait_on_address(atomic_uint32* address, uint32_t expected) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    WaitOnAddress((volatile VOID*)&address->value, &expected, sizeof(uint32_t), INFINITE);
+}
+
+void wake_one_on_address(atomic_uint32* address) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    WakeByAddressSingle((PVOID)&address->value);
+}
+
+void wake_all_on_address(atomic_uint32* address) {
+    ASSERT(address != NULL, return, "Address cannot be NULL");
+    WakeByAddressAll((PVOID)&address->value);
+}
+
+STATIC_ASSERT((sizeof(rwlock) == sizeof(SRWLOCK)), rwlock_size_must_match_srwlock_size);
+STATIC_ASSERT((alignof(rwlock) >= alignof(SRWLOCK)), rwlock_alignment_must_match_srwlock_alignment);
+
+result create_rwlock(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    InitializeSRWLock((PSRWLOCK)lock->internals);
+    return RESULT_SUCCESS;
+}
+
+result lock_rwlock_shared(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    AcquireSRWLockShared((PSRWLOCK)lock->internals);
     return RESULT_SUCCESS;
 }
 
+result unlock_rwlock_shared(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    ReleaseSRWLockShared((PSRWLOCK)lock->internals);
+    return RESULT_SUCCESS;
+}
+
+result lock_rwlock_exclusive(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    AcquireSRWLockExclusive((PSRWLOCK)lock->internals);
+    return RESULT_SUCCESS;
+}
+
+result unlock_rwlock_exclusive(rwlock* lock) {
+    ASSERT(lock != NULL, return RESULT_FAILURE, "Reader-writer lock pointer cannot be NULL");
+    ReleaseSRWLockExclusive((PSRWLOCK)lock->internals);
+    return RESULT_SUCCESS;
+}
+
+void destroy_rwlock(rwlock* lock) {
+    ASSERT(lock != NULL, return, "Reader-writer lock pointer cannot be NULL");
+    // SRW locks do not own any resources.
+}
+
 #ifdef GAME_LOOP
 /*
 =============================================================================================================================
@@ -1817,25 +2140,89 @@ static struct {
     graphics graphics;
     audio audio;
     clock clock;
+    frame_pacer frame_pacer;
+    job_system jobs;
+#ifdef ENABLE_FRAME_STATISTICS
+    frame_statistics frame_statistics;
+#endif
     void* game_state;
+    size_t game_perm_region; // where the game's part of perm begins, everything before it belongs to the engine
 } game; // <- this static variable is only used globally in WinMain, create_game() and destroy_game() (but it's members may be passed to function calls)
 
+#ifdef ENABLE_PERM_SNAPSHOTS
+static string get_perm_snapshot_path(void) {
+    return concat(get_executable_directory(&game.memory_allocators.temp), (string)CSTR(PERM_SNAPSHOT_FILE_NAME), &game.memory_allocators.temp);
+}
+
+static void save_perm_snapshot(void) {
+    ARENA_SCOPE(&game.memory_allocators.temp) {
+        uint64_t start_timestamp = read_timestamp();
+        if (save_arena_snapshot(&game.memory_allocators.perm, game.game_perm_region, game.game_state, PERM_SNAPSHOT_VERSION, get_perm_snapshot_path()) == RESULT_SUCCESS) {
+            printf("Saved perm snapshot (%zu bytes) in %.2f ms\n", game.memory_allocators.perm.used_bytes - game.game_perm_region,
+                timestamp_to_seconds(read_timestamp() - start_timestamp) * 1000.0);
+        }
+    }
+}
+
+// Keeps the current game state if there is no snapshot, or it cannot be loaded.
+static void load_perm_snapshot(void) {
+    ARENA_SCOPE(&game.memory_allocators.temp) {
+        string path = get_perm_snapshot_path();
+        if (!file_exists(path)) {
+            break;
+        }
+
+        uint64_t start_timestamp = read_timestamp();
+        void* game_state = NULL;
+        if (load_arena_snapshot(&game.memory_allocators.perm, game.game_perm_region, PERM_SNAPSHOT_VERSION, path, &game_state) == RESULT_SUCCESS) {
+            game.game_state = game_state;
+            printf("Loaded perm snapshot (%zu bytes) in %.2f ms\n", game.memory_allocators.perm.used_bytes - game.game_perm_region,
+                timestamp_to_seconds(read_timestamp() - start_timestamp) * 1000.0);
+        }
+    }
+}
+#endif
+
 static result create_game(void) {
     if (create_clock(&game.clock) != RESULT_SUCCESS) {
         BUG("Failed to create application clock (for measuring delta time).");
         return RESULT_FAILURE;
     }
 
-    if (create_bump_allocator(&game.memory_allocators.perm, 1024 * 1024 * 1024) != RESULT_SUCCESS) {
+    bump_allocator_options perm_options = { .preferred_base = PERM_ARENA_BASE_ADDRESS };
+#ifdef ENABLE_HUGE_PAGE_ARENAS
+    perm_options.use_huge_pages = true;
+#endif
+    if (create_bump_allocator_with_options(&game.memory_allocators.perm, PERM_ARENA_CAPACITY, &perm_options) != RESULT_SUCCESS) {
         BUG("Failed to create permanent memory allocator.");
         return RESULT_FAILURE;
     }
 
-    if (create_bump_allocator(&game.memory_allocators.temp, 64 * 1024 * 1024) != RESULT_SUCCESS) {
+    // A frame that needs a lot of temp memory should not keep it committed for the rest of the game.
+    bump_allocator_options temp_options = { .decommit_above_bytes = TEMP_ARENA_KEEP_COMMITTED_BYTES };
+    if (create_bump_allocator_with_options(&game.memory_allocators.temp, TEMP_ARENA_CAPACITY, &temp_options) != RESULT_SUCCESS) {
         BUG("Failed to create temporary memory allocator.");
         return RESULT_FAILURE;
     }
 
+    bump_allocator_options frame_options = { .decommit_above_bytes = TEMP_ARENA_KEEP_COMMITTED_BYTES };
+    if (create_frame_arenas(&game.memory_allocators, FRAME_ARENA_CAPACITY, &frame_options) != RESULT_SUCCESS) {
+        BUG("Failed to create frame memory allocators.");
+        return RESULT_FAILURE;
+    }
+
+    if (create_job_system(&game.jobs, 0, &game.memory_allocators.perm) != RESULT_SUCCESS) {
+        BUG("Failed to create job system.");
+        return RESULT_FAILURE;
+    }
+
+#ifdef ENABLE_FRAME_STATISTICS
+    if (create_frame_statistics(&game.frame_statistics, &game.memory_allocators.perm, FRAME_STATISTICS_WINDOW_FRAMES, FRAME_STATISTICS_HITCH_MILLISECONDS) != RESULT_SUCCESS) {
+        BUG("Failed to create frame statistics.");
+        return RESULT_FAILURE;
+    }
+#endif
+
     window_mode mode = WINDOW_MODE_WINDOWED;
 #if defined(NDEBUG)
     mode = WINDOW_MODE_BORDERLESS_FULLSCREEN;
@@ -1846,6 +2233,13 @@ static result create_game(void) {
         return RESULT_FAILURE;
     }
 
+    // Audio keeps its sounds in perm, so it is created before the game's part of perm begins (which snapshots overwrite).
+    if (create_audio(&game.memory_allocators, &game.audio) != RESULT_SUCCESS) {
+        BUG("Failed to create audio context.");
+        return RESULT_FAILURE;
+    }
+
+    game.game_perm_region = begin_arena_snapshot_region(&game.memory_allocators.perm);
     init_in_params in_params = { 0 };
     in_params.memory_allocators = &game.memory_allocators;
     init_out_params out_params = { 0 };
@@ -1856,25 +2250,27 @@ static result create_game(void) {
     }
 
     game.game_state = out_params.game_state;
+#if defined(ENABLE_PERM_SNAPSHOTS) && defined(LOAD_PERM_SNAPSHOT_ON_LAUNCH)
+    load_perm_snapshot();
+#endif
+
+    create_frame_pacer(&game.frame_pacer, out_params.target_frame_rate);
     if (create_graphics(&game.window, out_params.virtual_resolution, &game.memory_allocators.temp, &game.graphics) != RESULT_SUCCESS) {
         BUG("Failed to create graphics context.");
         return RESULT_FAILURE;
     }
 
-    if (create_audio(&game.memory_allocators, &game.audio) != RESULT_SUCCESS) {
-        BUG("Failed to create audio context.");
-        return RESULT_FAILURE;
-    }
-
     return RESULT_SUCCESS;
 }
 
 static void destroy_game(void) {
+    destroy_job_system(&game.jobs);
     destroy_audio(&game.audio);
     destroy_graphics(&game.graphics);
     destroy_window(&game.window);
     destroy_bump_allocator(&game.memory_allocators.perm);
     destroy_bump_allocator(&game.memory_allocators.temp);
+    destroy_frame_arenas(&game.memory_allocators);
 
 #ifdef HOT_RELOAD_HOST
     FreeLibrary(app_dll);
@@ -1887,6 +2283,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
     (void)hPrevInstance;
     (void)lpCmdLine;
     (void)nCmdShow;
+    set_profiler_thread_name("main");
 #ifdef HOT_RELOAD_HOST
     if (!potential_hot_reload(HOT_RELOAD_FORCED)) {
         BUG("Failed to load initial game DLL.");
@@ -1914,12 +2311,20 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 
     // update the clock just before the first frame so delta time is not too big.
     update_clock(&game.clock);
-    float time_step_accumulator = 0.0f;
+    double time_step_accumulator = 0.0;
     /*-----------------------------------------------------------------*/
     // Main loop
     while (1) {
-        update_audio(&game.audio, game.clock.time_since_previous_update);
+        PROFILE_BEGIN("frame");
+        uint64_t frame_start_timestamp = read_timestamp();
+        uint64_t update_ticks = 0;
+        input* frame_input = NULL;
+        PROFILE_SCOPE("audio") {
+            update_audio(&game.audio, game.clock.time_since_previous_update);
+        }
         reset_bump_allocator(&game.memory_allocators.temp);
+        advance_frame_arenas(&game.memory_allocators);
+        reset_job_scratch_arenas(&game.jobs);
         update_clock(&game.clock);
 
 #ifdef HOT_RELOAD_HOST
@@ -1931,12 +2336,15 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
             update_params.delta_time = FIXED_TIME_STEP; //game.clock.time_since_previous_update;
             update_params.audio = &game.audio;
             update_params.memory_allocators = &game.memory_allocators;
+            update_params.jobs = &game.jobs;
             update_params.game_state = game.game_state;
 
-            time_step_accumulator += game.clock.time_since_previous_update;
+            time_step_accumulator += timestamp_to_seconds(game.clock.ticks_since_previous_update);
             uint32_t updates_this_frame = 0;
             while (time_step_accumulator >= FIXED_TIME_STEP && updates_this_frame < MAX_UPDATES_PER_FRAME) {
+                PROFILE_BEGIN("input");
                 input* input_state = update_window_input(&game.window);
+                PROFILE_END();
                 if (input_state->closed_window) {
                     goto cleanup;
                 }
@@ -1945,37 +2353,94 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
                 time_step_accumulator -= FIXED_TIME_STEP;
                 update_params.input = input_state;
                 update_params.delta_time = FIXED_TIME_STEP;
-                if (update(&update_params) != RESULT_SUCCESS) {
+
+                frame_input = input_state;
+                PROFILE_BEGIN("update");
+                uint64_t update_start_timestamp = read_timestamp();
+                result update_result = update(&update_params);
+                update_ticks += read_timestamp() - update_start_timestamp;
+                PROFILE_END();
+                if (update_result != RESULT_SUCCESS) {
                     BUG("Failed to update game.");
                     goto cleanup;
                 }
             }
         }
 
+#ifdef ENABLE_PERM_SNAPSHOTS
+        if (frame_input != NULL && is_key_down(frame_input, PERM_SNAPSHOT_SAVE_KEY)) {
+            save_perm_snapshot();
+        }
+        if (frame_input != NULL && is_key_down(frame_input, PERM_SNAPSHOT_LOAD_KEY)) {
+            load_perm_snapshot();
+        }
+#endif
+
+        // A frame whose instance buffer cannot be mapped is not drawn, but it is still recorded and paced like any other.
+        bool is_instance_buffer_mapped = false;
         { // Map the instance buffer to update instance data
+            select_instance_buffer(&game.graphics, game.memory_allocators.frame_number);
+            PROFILE_BEGIN("map_instance_buffer");
             HRESULT hr = game.graphics.context->lpVtbl->Map(game.graphics.context, (ID3D11Resource*)game.graphics.instance_buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &game.graphics.instance_buffer_mapping);
+            PROFILE_END();
             if (FAILED(hr)) {
                 BUG("Failed to map instance buffer. HRESULT: 0x%08X", hr);
-                continue;
             }
-
-            game.graphics.sprite_instances.elements = (sprite_instance*)game.graphics.instance_buffer_mapping.pData;
-            game.graphics.sprite_instances.count = 0;
+            else {
+                game.graphics.sprite_instances.elements = (sprite_instance*)game.graphics.instance_buffer_mapping.pData;
+                game.graphics.sprite_instances.count = 0;
+                is_instance_buffer_mapped = true;
+            }
         }
 
-        draw_params draw_params = { 0 };
-        draw_params.graphics = &game.graphics;
-        draw_params.game_state = game.game_state;
-        draw_params.delta_time = game.clock.time_since_previous_update;
+        uint64_t draw_ticks = 0;
+        if (is_instance_buffer_mapped) {
+            draw_params draw_params = { 0 };
+            draw_params.graphics = &game.graphics;
+            draw_params.temp_allocator = &game.memory_allocators.temp;
+            draw_params.frame_allocator = get_frame_arena(&game.memory_allocators);
+            draw_params.game_state = game.game_state;
+            draw_params.delta_time = game.clock.time_since_previous_update;
+
+            uint64_t draw_start_timestamp = read_timestamp();
+            PROFILE_SCOPE("draw") {
+                draw(&draw_params);
+            }
+            draw_ticks = read_timestamp() - draw_start_timestamp;
 
-        draw(&draw_params);
+#ifdef ENABLE_FRAME_STATISTICS
+            if (frame_input != NULL && is_key_down(frame_input, FRAME_STATISTICS_DUMP_KEY)) {
+                print_frame_statistics(&game.frame_statistics);
+            }
+            if (frame_input != NULL && is_key_down(frame_input, FRAME_STATISTICS_OVERLAY_KEY)) {
+                game.frame_statistics.is_overlay_visible = !game.frame_statistics.is_overlay_visible;
+            }
+            if (game.frame_statistics.is_overlay_visible) {
+                draw_frame_statistics_overlay(&game.frame_statistics, &game.graphics, (vector2) { 8.0f, 8.0f }, game.graphics.virtual_resolution.x / 8.0f,
+                    FRAME_STATISTICS_OVERLAY_SAMPLE_POINT, FRAME_STATISTICS_OVERLAY_SAMPLE_SIZE);
+            }
+#endif
 
+            PROFILE_SCOPE("unmap_instance_buffer") { // Unmap the instance buffer after updating sprite data (presumably from update game)
+                game.graphics.context->lpVtbl->Unmap(game.graphics.context, (ID3D11Resource*)game.graphics.instance_buffer, 0);
+            }
 
-        { // Unmap the instance buffer after updating sprite data (presumably from update game)
-            game.graphics.context->lpVtbl->Unmap(game.graphics.context, (ID3D11Resource*)game.graphics.instance_buffer, 0);
+            PROFILE_SCOPE("present") {
+                present_graphics(&game.graphics);
+            }
         }
 
-        present_graphics(&game.graphics);
+        PROFILE_SCOPE("wait_for_next_frame") {
+            wait_for_next_frame(&game.frame_pacer);
+        }
+#ifdef ENABLE_FRAME_STATISTICS
+        // Recorded after the wait, so the frame time is the whole frame (what the player sees) rather than only the work in it.
+        record_frame_statistics(&game.frame_statistics,
+            (float)(timestamp_to_seconds(read_timestamp() - frame_start_timestamp) * 1000.0),
+            (float)(timestamp_to_seconds(update_ticks) * 1000.0),
+            (float)(timestamp_to_seconds(draw_ticks) * 1000.0));
+#endif
+        PROFILE_END(); // frame
     }
 
 cleanup:
@@ -1983,6 +2448,29 @@ cleanup:
     cleanup_params.game_state = game.game_state;
     cleanup_params.memory_allocators = &game.memory_allocators;
     cleanup(&cleanup_params);
+
+#ifdef ENABLE_FRAME_STATISTICS
+    print_frame_statistics(&game.frame_statistics);
+    print_frame_pacer_report(&game.frame_pacer);
+#endif
+#ifdef ENABLE_MEMORY_ACCOUNTING
+    print_memory_report("perm", &game.memory_allocators.perm);
+    print_memory_report("temp", &game.memory_allocators.temp);
+    for (uint32_t i = 0; i < FRAME_ARENA_COUNT; ++i) {
+        char name[32];
+        snprintf(name, sizeof(name), "frame %u", i);
+        print_memory_report(name, &game.memory_allocators.frames[i]);
+    }
+#endif
+
+#ifdef ENABLE_PROFILER
+    reset_bump_allocator(&game.memory_allocators.temp);
+    string trace_path = concat(get_executable_directory(&game.memory_allocators.temp), (string)CSTR("profile_trace.json"), &game.memory_allocators.temp);
+    if (export_profiler_trace(trace_path, &game.memory_allocators.temp) != RESULT_SUCCESS) {
+        BUG("Failed to export profiler trace to %s", trace_path.text);
+    }
+#endif
+
     destroy_game();
 
     return 0;
@@ -2,6 +2,10 @@
 #include <stdlib.h>
 #include "geometry.h"
 #include "platform_layer.h"
+#include "job_system.h"
+#include "dynamic_array.h"
+#include "slot_map.h"
+#include "soa.h"
 
 #define TARGET_RESOLUTION 1024
 #define SPRITE_SIZE 64
@@ -24,8 +28,15 @@
 
 #define PROJECTILE_SAMPLE_POINT (vector2int){4 * SPRITE_SIZE, 3 * SPRITE_SIZE }
 
-#define MAX_ASTEROIDS 128
+// These can be overridden before including this file (the simulation benchmark scales them up).
+// Asteroids are not capped (there are as many as the asteroids split into), this is only how many there is room for up front.
+#ifndef INITIAL_ASTEROID_CAPACITY
+#define INITIAL_ASTEROID_CAPACITY 128
+#endif
+
+#ifndef MAX_PROJECTILES
 #define MAX_PROJECTILES 16
+#endif
 
 typedef enum {
     ANIMATION_TYPE_NONE,
@@ -65,13 +76,17 @@ typedef enum {
 } asteroid_content;
 
 typedef struct {
-    transform transform;
     asteroid_size size;
     asteroid_content content;
 } asteroid;
 
-DECLARE_CAPPED_ARRAY(asteroids, asteroid, MAX_ASTEROIDS)
-IMPLEMENT_CAPPED_ARRAY(asteroids, asteroid, MAX_ASTEROIDS)
+DECLARE_SLOT_MAP(asteroids, asteroid)
+IMPLEMENT_SLOT_MAP(asteroids, asteroid)
+
+// The parts of the asteroids that change every tick, a column each, so the integration, wrap-around and collision passes only load
+// the columns they use. Row i is the motion of asteroids.elements[i]: both are added to together and removed from the same way.
+DECLARE_SOA(asteroid_motion, (vector2, position), (vector2, velocity), (float, rotation), (float, angular_velocity))
+IMPLEMENT_SOA(asteroid_motion, (vector2, position), (vector2, velocity), (float, rotation), (float, angular_velocity))
 
 typedef struct {
     transform transform;
@@ -81,10 +96,15 @@ typedef struct {
 DECLARE_CAPPED_ARRAY(projectiles, projectile, MAX_PROJECTILES)
 IMPLEMENT_CAPPED_ARRAY(projectiles, projectile, MAX_PROJECTILES)
 
+DECLARE_DYNAMIC_ARRAY(asteroid_hits, slot_handle)
+IMPLEMENT_DYNAMIC_ARRAY(asteroid_hits, slot_handle)
+
 typedef struct {
     spaceship player_spaceship;
     projectiles projectiles;
     asteroids asteroids;
+    asteroid_motion asteroid_motion;
+    asteroid_hits asteroid_hits;
 } game_state;
 
 static void apply_velocity(transform* transform, float delta_time) {
@@ -97,30 +117,35 @@ typedef enum {
     ROTATION_CHANGES_MOVEMENT_DIRECTION,
 } rotation_mode;
 
-static void apply_angular_velocity(transform* transform, float delta_time) {
-    ASSERT(transform != NULL, return, "Transform cannot be NULL");
-    if (transform->angular_velocity == 0.0f) return;
-    transform->rotation += transform->angular_velocity * delta_time;
+// The asteroids grow into perm, which is where the game state lives.
+static slot_handle add_asteroid(game_state* state, bump_allocator* perm, asteroid ast, asteroid_motion_element motion) {
+    ASSERT(state != NULL, return SLOT_HANDLE_NONE, "State cannot be NULL");
+    slot_handle handle = asteroids_insert(&state->asteroids, perm, ast);
+    if (handle == SLOT_HANDLE_NONE) {
+        return SLOT_HANDLE_NONE;
+    }
+    if (asteroid_motion_append(&state->asteroid_motion, perm, motion) != RESULT_SUCCESS) {
+        asteroids_remove(&state->asteroids, handle);
+        return SLOT_HANDLE_NONE;
+    }
+    return handle;
 }
 
-static void spawn_asteroid(asteroids* asteroids, vector2 position, asteroid_size size) {
-    ASSERT(asteroids != NULL, return, "Asteroids array cannot be NULL");
-    if (asteroids->count >= MAX_ASTEROIDS) {
-        asteroids_remove_swap(asteroids, 0);
-        ASSERT(asteroids->count < MAX_ASTEROIDS, return, "Failed to remove asteroid to make space for new one");
-    }
+static void remove_asteroid(game_state* state, slot_handle handle) {
+    ASSERT(state != NULL, return, "State cannot be NULL");
+    uint32_t index = 0;
+    ASSERT(find_slot_map_index(&state->asteroids.lookup, handle, &index), return, "Asteroid handle %u is stale", handle);
+    asteroids_remove_at(&state->asteroids, index);
+    asteroid_motion_remove_swap(&state->asteroid_motion, index);
+}
 
-    asteroid* ast = &asteroids->elements[asteroids->count];
-    ++asteroids->count;
-    ast->transform.position = position;
-    ast->transform.rotation = 0.0f;
-    ast->transform.angular_velocity = ((float)(rand() % 200) / 100.0f - 1.0f) * 1.0f; // random angular velocity between -1.0 and 1.0
+static void spawn_asteroid(game_state* state, bump_allocator* perm, vector2 position, asteroid_size size) {
+    asteroid_motion_element motion = { .position = position, .rotation = 0.0f };
+    motion.angular_velocity = ((float)(rand() % 200) / 100.0f - 1.0f) * 1.0f; // random angular velocity between -1.0 and 1.0
     float speed = ((float)(rand() % 200) / 100.0f) * 50.0f + 20.0f; // random speed between 20.0 and 70.0
     float angle = ((float)(rand() % 360)) * (M_PI / 180.0f); // random direction
-    ast->transform.direction = vector2_from_angle(angle);
-    ast->transform.speed = speed;
-    ast->size = size;
-    ast->content = ASTEROID_CONTENT_NONE;
+    motion.velocity = vector2_scale(vector2_from_angle(angle), speed);
+    add_asteroid(state, perm, (asteroid){ .size = size, .content = ASTEROID_CONTENT_NONE }, motion);
 }
 
 static void control_player_spaceship(spaceship* player, input* input, projectiles* projectiles, float delta_time) {
@@ -192,7 +217,7 @@ static void control_player_spaceship(spaceship* player, input* input, projectile
 
     if (is_key_down(input, KEY_SPACE)) {
         if (projectiles->count >= MAX_PROJECTILES) {
-            projectiles_remove_swap(projectiles, 0);
+            projectiles_remove(projectiles, 0); // the projectiles stay in the order they were fired, so this is the oldest
             ASSERT(projectiles->count < MAX_PROJECTILES, return, "Failed to remove projectile to make space for new one");
         }
 
@@ -209,89 +234,156 @@ static void control_player_spaceship(spaceship* player, input* input, projectile
     }
 }
 
-static void update_simulation(game_state* state, float delta_time) {
-    ASSERT(state != NULL, return, "State cannot be NULL");
+/*
+The simulation is updated in phases, so that each phase can be measured on its own (see src/bench/bench_simulation.c).
+*/
 
-    for (uint32_t i = 0; i < state->asteroids.count; ++i) {
-        asteroid* asteroid = &state->asteroids.elements[i];
-        apply_angular_velocity(&asteroid->transform, delta_time);
-        apply_velocity(&asteroid->transform, delta_time);
+// Entities per job when the simulation is split across threads (below this the loops run on the calling thread).
+#define SIMULATION_MIN_GRAIN 1024
+
+typedef struct {
+    game_state* state;
+    float delta_time;
+} simulation_job_context;
+
+static void integrate_asteroids(void* context, uint32_t begin, uint32_t end) {
+    simulation_job_context* job_context = (simulation_job_context*)context;
+    asteroid_motion* motion = &job_context->state->asteroid_motion;
+    float delta_time = job_context->delta_time;
+    for (uint32_t i = begin; i < end; ++i) {
+        motion->rotation[i] += motion->angular_velocity[i] * delta_time;
+    }
+    for (uint32_t i = begin; i < end; ++i) {
+        motion->position[i] = vector2_add(motion->position[i], vector2_scale(motion->velocity[i], delta_time));
+    }
+}
+
+static void integrate_projectiles(void* context, uint32_t begin, uint32_t end) {
+    simulation_job_context* job_context = (simulation_job_context*)context;
+    for (uint32_t i = begin; i < end; ++i) {
+        projectile* proj = &job_context->state->projectiles.elements[i];
+        apply_velocity(&proj->transform, job_context->delta_time);
+        proj->lifetime -= job_context->delta_time;
+    }
+}
+
+static void integrate_simulation(game_state* state, job_system* jobs, float delta_time) {
+    ASSERT(state != NULL, return, "State cannot be NULL");
+    simulation_job_context context = { .state = state, .delta_time = delta_time };
+    PARALLEL_FOR_EACH_COLUMN(jobs, &state->asteroid_motion, rotation, SIMULATION_MIN_GRAIN, integrate_asteroids, &context);
+    PARALLEL_FOR_EACH(jobs, &state->projectiles, SIMULATION_MIN_GRAIN, integrate_projectiles, &context);
+}
 
-        if (asteroid->transform.position.x < 0.0f) {
-            asteroid->transform.position.x += TARGET_RESOLUTION;
+static void wrap_asteroids(void* context, uint32_t begin, uint32_t end) {
+    simulation_job_context* job_context = (simulation_job_context*)context;
+    vector2* positions = job_context->state->asteroid_motion.position;
+    for (uint32_t i = begin; i < end; ++i) {
+        vector2* position = &positions[i];
+        if (position->x < 0.0f) {
+            position->x += TARGET_RESOLUTION;
         }
-        else if (asteroid->transform.position.x > TARGET_RESOLUTION) {
-            asteroid->transform.position.x -= TARGET_RESOLUTION;
+        else if (position->x > TARGET_RESOLUTION) {
+            position->x -= TARGET_RESOLUTION;
         }
 
-        if (asteroid->transform.position.y < 0.0f) {
-            asteroid->transform.position.y += TARGET_RESOLUTION;
+        if (position->y < 0.0f) {
+            position->y += TARGET_RESOLUTION;
         }
-        else if (asteroid->transform.position.y > TARGET_RESOLUTION) {
-            asteroid->transform.position.y -= TARGET_RESOLUTION;
+        else if (position->y > TARGET_RESOLUTION) {
+            position->y -= TARGET_RESOLUTION;
         }
     }
+}
 
-    if (!state->player_spaceship.is_destroyed && state->player_spaceship.invincibility_time_remaining <= 0.0f) {
-        for (uint32_t i = 0; i < state->asteroids.count; ++i) {
-            asteroid* ast = &state->asteroids.elements[i];
+static void wrap_simulation(game_state* state, job_system* jobs) {
+    ASSERT(state != NULL, return, "State cannot be NULL");
+    simulation_job_context context = { .state = state };
+    PARALLEL_FOR_EACH_COLUMN(jobs, &state->asteroid_motion, position, SIMULATION_MIN_GRAIN, wrap_asteroids, &context);
+}
 
-            // check collision with player spaceship
-            vector2 to_player = vector2_sub(state->player_spaceship.transform.position, ast->transform.position);
-            float distance_sq = to_player.x * to_player.x + to_player.y * to_player.y;
-            float collision_distance = SPRITE_SIZE; // approximate both as circles with radius SPRITE_SIZE/2
-            if (distance_sq < collision_distance * collision_distance) {
-                // Collision detected
-                state->player_spaceship.animation.type = ANIMATION_TYPE_EXPLOSION;
-                state->player_spaceship.animation.time = 0.0f;
-                state->player_spaceship.transform.speed = 0.0f;
-                state->player_spaceship.transform.angular_velocity = 0.0f;
-                state->player_spaceship.is_destroyed = true;
-            }
-        }
+static void collide_spaceship_with_asteroids(spaceship* ship, const asteroid_motion* motion) {
+    ASSERT(ship != NULL, return, "Spaceship cannot be NULL");
+    ASSERT(motion != NULL, return, "Asteroid motion cannot be NULL");
+
+    if (ship->is_destroyed || ship->invincibility_time_remaining > 0.0f) {
+        return;
     }
 
-    for (int32_t i = (int32_t)state->projectiles.count - 1; i >= 0; --i) {
-        projectile* proj = &state->projectiles.elements[i];
-        proj->lifetime -= delta_time;
-        if (proj->lifetime <= 0.0f) {
-            projectiles_remove_swap(&state->projectiles, i);
+    for (uint32_t i = 0; i < motion->count; ++i) {
+        vector2 to_ship = vector2_sub(ship->transform.position, motion->position[i]);
+        float distance_sq = to_ship.x * to_ship.x + to_ship.y * to_ship.y;
+        float collision_distance = SPRITE_SIZE; // approximate both as circles with radius SPRITE_SIZE/2
+        if (distance_sq < collision_distance * collision_distance) {
+            // Collision detected
+            ship->animation.type = ANIMATION_TYPE_EXPLOSION;
+            ship->animation.time = 0.0f;
+            ship->transform.speed = 0.0f;
+            ship->transform.angular_velocity = 0.0f;
+            ship->is_destroyed = true;
         }
     }
+}
 
-    for (uint32_t i = 0; i < state->projectiles.count; ++i) {
-        projectile* proj = &state->projectiles.elements[i];
-        apply_velocity(&proj->transform, delta_time);
-    }
+// Projectiles that hit an asteroid are spent straight away (so they cannot hit anything else), and removed with the expired ones
+// in spawn_and_despawn_simulation. The handles of the asteroids that were hit are recorded, and they are split up there too.
+static void collide_simulation(game_state* state, bump_allocator* perm) {
+    ASSERT(state != NULL, return, "State cannot be NULL");
 
+    collide_spaceship_with_asteroids(&state->player_spaceship, &state->asteroid_motion);
 
-    for (int32_t i = (int32_t)state->asteroids.count - 1; i >= 0; --i) {
-        asteroid* ast = &state->asteroids.elements[i];
+    asteroid_hits_clear(&state->asteroid_hits);
+    for (int32_t i = (int32_t)state->asteroid_motion.count - 1; i >= 0; --i) {
+        vector2 asteroid_position = state->asteroid_motion.position[i];
         for (int32_t j = (int32_t)state->projectiles.count - 1; j >= 0; --j) {
             projectile* proj = &state->projectiles.elements[j];
+            if (proj->lifetime <= 0.0f) {
+                continue;
+            }
 
             // check collision between projectile and asteroid
-            vector2 to_proj = vector2_sub(proj->transform.position, ast->transform.position);
+            vector2 to_proj = vector2_sub(proj->transform.position, asteroid_position);
             float distance_sq = to_proj.x * to_proj.x + to_proj.y * to_proj.y;
             float collision_distance = SPRITE_SIZE / 2.0f; // need to be very close for a hit
             if (distance_sq < collision_distance * collision_distance) {
-                projectiles_remove_swap(&state->projectiles, j);
-                if (ast->size == ASTEROID_SIZE_LARGE) {
-                    spawn_asteroid(&state->asteroids, ast->transform.position, ASTEROID_SIZE_MEDIUM);
-                    spawn_asteroid(&state->asteroids, ast->transform.position, ASTEROID_SIZE_MEDIUM);
-                    spawn_asteroid(&state->asteroids, ast->transform.position, ASTEROID_SIZE_MEDIUM);
-                }
-                else if (ast->size == ASTEROID_SIZE_MEDIUM) {
-                    spawn_asteroid(&state->asteroids, ast->transform.position, ASTEROID_SIZE_SMALL);
-                    spawn_asteroid(&state->asteroids, ast->transform.position, ASTEROID_SIZE_SMALL);
-                }
-
-                asteroids_remove_swap(&state->asteroids, i);
-
+                proj->lifetime = 0.0f;
+                asteroid_hits_append(&state->asteroid_hits, perm, asteroids_handle_at(&state->asteroids, (uint32_t)i));
                 break;
             }
         }
     }
+}
+
+static bool is_projectile_spent(const projectile* proj, void* context) {
+    (void)context;
+    return proj->lifetime <= 0.0f;
+}
+
+static void spawn_and_despawn_simulation(game_state* state, bump_allocator* perm, float delta_time) {
+    ASSERT(state != NULL, return, "State cannot be NULL");
+
+    // Hits are handles, so they stay valid while the asteroids that were hit are removed (and split ones are added).
+    for (uint32_t i = 0; i < state->asteroid_hits.count; ++i) {
+        slot_handle hit = state->asteroid_hits.elements[i];
+        uint32_t index = 0;
+        ASSERT(find_slot_map_index(&state->asteroids.lookup, hit, &index), continue, "Asteroid hit handle %u is stale", hit);
+        asteroid_size size = state->asteroids.elements[index].size;
+        vector2 position = state->asteroid_motion.position[index];
+        if (size == ASTEROID_SIZE_LARGE) {
+            spawn_asteroid(state, perm, position, ASTEROID_SIZE_MEDIUM);
+            spawn_asteroid(state, perm, position, ASTEROID_SIZE_MEDIUM);
+            spawn_asteroid(state, perm, position, ASTEROID_SIZE_MEDIUM);
+        }
+        else if (size == ASTEROID_SIZE_MEDIUM) {
+            spawn_asteroid(state, perm, position, ASTEROID_SIZE_SMALL);
+            spawn_asteroid(state, perm, position, ASTEROID_SIZE_SMALL);
+        }
+
+        remove_asteroid(state, hit);
+    }
+    asteroid_hits_clear(&state->asteroid_hits);
+
+    // Lifetimes count down in integrate_projectiles, so the spent projectiles are removed in a single pass.
+    projectiles_remove_if(&state->projectiles, is_projectile_spent, NULL);
 
     if (state->player_spaceship.invincibility_time_remaining > 0.0f) {
         state->player_spaceship.invincibility_time_remaining -= delta_time;
@@ -314,6 +406,15 @@ static void update_simulation(game_state* state, float delta_time) {
     }
 }
 
+// jobs may be NULL, then every phase runs on the calling thread.
+static void update_simulation(game_state* state, job_system* jobs, bump_allocator* perm, float delta_time) {
+    ASSERT(state != NULL, return, "State cannot be NULL");
+    integrate_simulation(state, jobs, delta_time);
+    wrap_simulation(state, jobs);
+    collide_simulation(state, perm);
+    spawn_and_despawn_simulation(state, perm, delta_time);
+}
+
 static void draw_player_spaceship(spaceship* player, graphics* graphics, float delta_time) {
     ASSERT(player != NULL, return, "Player spaceship cannot be NULL");
     ASSERT(graphics != NULL, return, "Graphics cannot be NULL");
@@ -389,12 +490,12 @@ static void draw_simulation(game_state* state, graphics* graphics, float delta_t
     // Draw asteroids
     for (uint32_t i = 0; i < state->asteroids.count; ++i) {
         asteroid* ast = &state->asteroids.elements[i];
-        draw_sprite(graphics, ast->transform.position, DRAW_SIZE,
+        draw_sprite(graphics, state->asteroid_motion.position[i], DRAW_SIZE,
             (ast->size == ASTEROID_SIZE_LARGE) ? ASTEROID_LARGE_SAMPLE_POINT :
             (ast->size == ASTEROID_SIZE_MEDIUM) ? ASTEROID_MEDIUM_SAMPLE_POINT :
             ASTEROID_SMALL_SAMPLE_POINT,
             SAMPLE_SIZE,
-            ast->transform.rotation * M_PI);
+            state->asteroid_motion.rotation[i] * M_PI);
     }
 
     // Draw projectiles
@@ -411,7 +512,7 @@ static void draw_simulation(game_state* state, graphics* graphics, float delta_t
 }
 
 DLL_EXPORT result init(init_in_params* in, init_out_params* out) {
-    game_state* state = (game_state*)bump_allocate(&in->memory_allocators->perm, alignof(game_state), sizeof(game_state));
+    game_state* state = (game_state*)BUMP_ALLOCATE_TAGGED(&in->memory_allocators->perm, alignof(game_state), sizeof(game_state), "game_state");
     if (state == NULL) {
         BUG("Failed to allocate memory for game state.");
         return RESULT_FAILURE;
@@ -424,19 +525,28 @@ DLL_EXPORT result init(init_in_params* in, init_out_params* out) {
     }
 
     {
+        bump_allocator* perm = &in->memory_allocators->perm;
+        state->asteroids = (asteroids){ 0 };
+        state->asteroid_motion = (asteroid_motion){ 0 };
+        state->asteroid_hits = (asteroid_hits){ 0 };
+        if (asteroids_reserve(&state->asteroids, perm, INITIAL_ASTEROID_CAPACITY) != RESULT_SUCCESS
+            || asteroid_motion_reserve(&state->asteroid_motion, perm, INITIAL_ASTEROID_CAPACITY) != RESULT_SUCCESS) {
+            return RESULT_FAILURE;
+        }
+
         // Initialize some asteroids for demonstration
         for (uint32_t i = 0; i < 10; ++i) {
-            asteroid* ast = &state->asteroids.elements[state->asteroids.count++];
-            ast->transform.position = (vector2){ (float)(rand() % (TARGET_RESOLUTION)),
-                                                 (float)(rand() % (TARGET_RESOLUTION)) };
+            asteroid_motion_element motion = { 0 };
+            motion.position = (vector2){ (float)(rand() % (TARGET_RESOLUTION)),
+                                         (float)(rand() % (TARGET_RESOLUTION)) };
             float angle = (float)(rand() % 360) * (M_PI / 180.0f);
             float speed = (float)(50 + rand() % 100);
-            ast->transform.direction = vector2_from_angle(angle);
-            ast->transform.speed = speed;
-            ast->transform.rotation = 0.0f;
-            ast->transform.angular_velocity = ((float)(rand() % 100) / 100.0f) * 1.0f;
-            ast->size = ASTEROID_SIZE_LARGE;
-            ast->content = ASTEROID_CONTENT_NONE;
+            motion.velocity = vector2_scale(vector2_from_angle(angle), speed);
+            motion.rotation = 0.0f;
+            motion.angular_velocity = ((float)(rand() % 100) / 100.0f) * 1.0f;
+            if (add_asteroid(state, perm, (asteroid){ .size = ASTEROID_SIZE_LARGE, .content = ASTEROID_CONTENT_NONE }, motion) == SLOT_HANDLE_NONE) {
+                return RESULT_FAILURE;
+            }
         }
     }
 
@@ -453,8 +563,13 @@ DLL_EXPORT result start(start_params* in) {
 DLL_EXPORT result update(update_params* in) {
     ASSERT(in->game_state, return RESULT_FAILURE, "Game state is NULL in update.");
     game_state* state = (game_state*)in->game_state;
+
+    // The whole play area is visible at once, so positional sounds are heard from the centre of the screen.
+    camera_2d listener = { .position = { TARGET_RESOLUTION / 2.0f, TARGET_RESOLUTION / 2.0f }, .zoom = 1.0f };
+    set_audio_listener(in->audio, listener);
+
     control_player_spaceship(&state->player_spaceship, in->input, &state->projectiles, in->delta_time);
-    update_simulation(state, in->delta_time);
+    update_simulation(state, in->jobs, &in->memory_allocators->perm, in->delta_time);
     return RESULT_SUCCESS;
 }
 